@@ -0,0 +1,540 @@
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "EventSystem.h"
+
+// ============================================================================
+// 事件录制与回放 - 用生产环境的事件流做可复现的压测
+// ============================================================================
+//
+// 1. EventRecorder 通过 EventSystem::setPublishObserver 在发布线程中编码事件（类型、优先级、时间戳、负载），
+//    追加到内存缓冲区，由后台线程批量写入文件，发布线程不做文件 IO
+// 2. 负载由按类型注册的编解码器（EventCodecRegistry）序列化；文件中保存注册名而不是 type_index::name，
+//    不同编译器/版本的程序可以互相回放。没有注册编解码器的事件不录制（计入 getSkippedCount）
+// 3. EventReplayer 加载文件时一次性解码全部事件，回放时在调用线程中按录制顺序发布，
+//    可以按原速、倍速或最快速度发布
+//
+// 文件格式（整数均为 LEB128 变长编码，有符号数先做 zigzag）：
+//   文件头：  "EVRC" + 版本号
+//   类型定义：'T' 类型编号 名称长度 名称         （每种类型在第一次出现前写一次）
+//   事件：    'E' 类型编号 优先级 发布时间增量(ns) 创建到发布的间隔(ns) 负载长度 负载
+//
+// 用法：
+//   EventCodecRegistry codecs;
+//   codecs.registerFields<TradeEvent>("Trade", &TradeEvent::price, &TradeEvent::volume);
+//
+//   EventRecorder recorder(codecs);
+//   recorder.start(EventSystem::getInstance(), "trades.evrc");
+//   ...
+//   recorder.stop();
+//
+//   EventReplayer replayer(codecs);
+//   replayer.load("trades.evrc");
+//   replayer.replay(EventSystem::getInstance(), ReplayOptions{2.0});    // 两倍速
+
+// ============================================================================
+// 编解码器注册表
+// ============================================================================
+class EventCodecRegistry {
+public:
+    using Encoder = std::function<void(const Event&, std::string&)>;
+    using Decoder = std::function<std::shared_ptr<Event>(const char*, size_t)>;
+
+    struct Codec {
+        std::string name;
+        Encoder encode;     // 把负载追加到输出缓冲区
+        Decoder decode;     // 从负载构造事件，失败时返回 nullptr
+    };
+
+    // 注册自定义编解码器，name 写入录制文件，同一个名称只能对应一种类型
+    template<typename T>
+    bool registerCodec(const std::string& name,
+                       std::function<void(const T&, std::string&)> encode,
+                       std::function<std::shared_ptr<T>(const char*, size_t)> decode) {
+        static_assert(std::is_base_of<Event, T>::value, "T must inherit from Event");
+
+        if (byName_.count(name)) {
+            std::cerr << "[EventRecorder] 编解码器名称重复: " << name << std::endl;
+            return false;
+        }
+
+        Codec codec;
+        codec.name = name;
+        codec.encode = [encode = std::move(encode)](const Event& event, std::string& out) {
+            encode(static_cast<const T&>(event), out);
+        };
+        codec.decode = [decode = std::move(decode)](const char* data, size_t size) -> std::shared_ptr<Event> {
+            return decode(data, size);
+        };
+
+        auto codecPtr = std::make_shared<const Codec>(std::move(codec));
+        byType_[std::type_index(typeid(T))] = codecPtr;
+        byName_[name] = codecPtr;
+        return true;
+    }
+
+    // 按成员逐个拷贝字节的编解码器，成员必须是可平凡复制的类型，T 必须可以默认构造
+    //   codecs.registerFields<TradeEvent>("Trade", &TradeEvent::price, &TradeEvent::volume);
+    template<typename T, typename... Members>
+    bool registerFields(const std::string& name, Members T::*... members) {
+        static_assert((std::is_trivially_copyable<Members>::value && ...),
+                      "registerFields only supports trivially copyable members");
+        constexpr size_t payloadSize = (sizeof(Members) + ... + 0);
+
+        return registerCodec<T>(
+            name,
+            [members...](const T& event, std::string& out) {
+                (out.append(reinterpret_cast<const char*>(&(event.*members)), sizeof(Members)), ...);
+            },
+            [members...](const char* data, size_t size) -> std::shared_ptr<T> {
+                if (size != payloadSize) {
+                    return nullptr;
+                }
+                auto event = std::make_shared<T>();
+                ((std::memcpy(&((*event).*members), data, sizeof(Members)), data += sizeof(Members)), ...);
+                return event;
+            });
+    }
+
+    const Codec* find(std::type_index type) const {
+        auto it = byType_.find(type);
+        return it != byType_.end() ? it->second.get() : nullptr;
+    }
+
+    const Codec* find(const std::string& name) const {
+        auto it = byName_.find(name);
+        return it != byName_.end() ? it->second.get() : nullptr;
+    }
+
+private:
+    std::unordered_map<std::type_index, std::shared_ptr<const Codec>> byType_;
+    std::unordered_map<std::string, std::shared_ptr<const Codec>> byName_;
+};
+
+// ============================================================================
+// 文件格式辅助函数
+// ============================================================================
+struct EventRecordFormat {
+    static constexpr char MAGIC[4] = {'E', 'V', 'R', 'C'};
+    static constexpr uint64_t VERSION = 1;
+    static constexpr char TYPE_TAG = 'T';
+    static constexpr char EVENT_TAG = 'E';
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static void putSigned(std::string& out, int64_t value) {
+        putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    // 读取失败（数据截断或超过 10 字节）时返回 false
+    static bool getVarint(const char*& pos, const char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool getSigned(const char*& pos, const char* end, int64_t& value) {
+        uint64_t raw;
+        if (!getVarint(pos, end, raw)) {
+            return false;
+        }
+        value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        return true;
+    }
+};
+
+// ============================================================================
+// 录制器
+// ============================================================================
+class EventRecorder {
+public:
+    explicit EventRecorder(const EventCodecRegistry& registry) : registry_(registry) {}
+
+    ~EventRecorder() {
+        stop();
+    }
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+
+    // 开始录制 bus 上发布的事件，覆盖已有文件
+    // 同一个 EventSystem 同时只能有一个发布观察者，已有观察者时返回 false
+    bool start(EventSystem& bus, const std::string& path) {
+        if (sink_) {
+            std::cout << "[EventRecorder] 已经在录制中" << std::endl;
+            return false;
+        }
+
+        auto sink = std::make_shared<Sink>(registry_);
+        sink->file.open(path, std::ios::binary | std::ios::trunc);
+        if (!sink->file) {
+            std::cerr << "[EventRecorder] 无法打开录制文件: " << path << std::endl;
+            return false;
+        }
+        sink->buffer.append(EventRecordFormat::MAGIC, sizeof(EventRecordFormat::MAGIC));
+        EventRecordFormat::putVarint(sink->buffer, EventRecordFormat::VERSION);
+
+        // 观察者持有 sink 的 shared_ptr：停止录制后仍在执行的回调只会看到 closed 并返回
+        auto observer = std::make_shared<const EventSystem::PublishObserver>(
+            [sink](const std::shared_ptr<Event>& event) { sink->append(*event); });
+        auto previous = bus.setPublishObserver(observer);
+        if (previous) {
+            bus.setPublishObserver(std::move(previous));
+            std::cerr << "[EventRecorder] EventSystem 已经有发布观察者" << std::endl;
+            return false;
+        }
+
+        sink_ = std::move(sink);
+        bus_ = &bus;
+        writerThread_ = std::thread(&EventRecorder::writeLoop, sink_);
+        std::cout << "[EventRecorder] 开始录制: " << path << std::endl;
+        return true;
+    }
+
+    // 停止录制，把缓冲区中剩余的记录写入文件
+    void stop() {
+        if (!sink_) {
+            return;
+        }
+
+        bus_->setPublishObserver(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(sink_->mutex);
+            sink_->closed = true;
+        }
+        sink_->cv.notify_one();
+        if (writerThread_.joinable()) {
+            writerThread_.join();
+        }
+
+        std::cout << "[EventRecorder] 停止录制，事件数=" << sink_->recorded.load()
+                  << " 未录制=" << sink_->skipped.load()
+                  << " 字节数=" << sink_->bytesWritten << std::endl;
+        bus_ = nullptr;
+        lastRecorded_ = sink_->recorded.load();
+        lastSkipped_ = sink_->skipped.load();
+        sink_.reset();
+    }
+
+    // 已录制的事件数量
+    size_t getRecordedCount() const {
+        return sink_ ? sink_->recorded.load() : lastRecorded_;
+    }
+
+    // 因没有注册编解码器而没有录制的事件数量
+    size_t getSkippedCount() const {
+        return sink_ ? sink_->skipped.load() : lastSkipped_;
+    }
+
+private:
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;                         // 缓冲区超过该大小时唤醒写线程
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};          // 最长的刷盘间隔
+
+    // 录制状态，由观察者和写线程共享
+    struct Sink {
+        explicit Sink(const EventCodecRegistry& codecs)
+            : registry(codecs), startTime(std::chrono::steady_clock::now()), lastOffset(0),
+              closed(false), recorded(0), skipped(0), bytesWritten(0) {}
+
+        // 在发布线程中编码一个事件
+        void append(const Event& event) {
+            const EventCodecRegistry::Codec* codec = registry.find(std::type_index(typeid(event)));
+            if (!codec) {
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+            int64_t age = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - event.timestamp).count();
+
+            // 负载在锁外编码，复用线程局部缓冲区
+            thread_local std::string payload;
+            payload.clear();
+            codec->encode(event, payload);
+
+            bool flush;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (closed) {
+                    return;
+                }
+
+                auto it = typeIds.find(codec);
+                if (it == typeIds.end()) {
+                    uint64_t id = typeIds.size();
+                    it = typeIds.emplace(codec, id).first;
+                    buffer.push_back(EventRecordFormat::TYPE_TAG);
+                    EventRecordFormat::putVarint(buffer, id);
+                    EventRecordFormat::putVarint(buffer, codec->name.size());
+                    buffer.append(codec->name);
+                }
+
+                // 多个发布线程的时间戳可能略微乱序，增量按有符号数保存
+                buffer.push_back(EventRecordFormat::EVENT_TAG);
+                EventRecordFormat::putVarint(buffer, it->second);
+                EventRecordFormat::putSigned(buffer, event.priority);
+                EventRecordFormat::putSigned(buffer, now - lastOffset);
+                EventRecordFormat::putSigned(buffer, age);
+                EventRecordFormat::putVarint(buffer, payload.size());
+                buffer.append(payload);
+                lastOffset = now;
+
+                recorded.fetch_add(1, std::memory_order_relaxed);
+                flush = buffer.size() >= FLUSH_BYTES;
+            }
+            if (flush) {
+                cv.notify_one();
+            }
+        }
+
+        const EventCodecRegistry registry;          // 录制期间使用的编解码器副本
+        const std::chrono::steady_clock::time_point startTime;
+        std::unordered_map<const EventCodecRegistry::Codec*, uint64_t> typeIds;
+        int64_t lastOffset;
+
+        std::mutex mutex;                           // 保护 buffer/typeIds/lastOffset/closed
+        std::condition_variable cv;
+        std::string buffer;
+        bool closed;
+
+        std::atomic<size_t> recorded;
+        std::atomic<size_t> skipped;
+
+        std::ofstream file;                         // 只在写线程中访问
+        size_t bytesWritten;
+    };
+
+    // 写线程：交换缓冲区后在锁外写文件
+    static void writeLoop(std::shared_ptr<Sink> sink) {
+        std::string chunk;
+        while (true) {
+            bool closed;
+            {
+                std::unique_lock<std::mutex> lock(sink->mutex);
+                sink->cv.wait_for(lock, FLUSH_INTERVAL, [&sink] {
+                    return sink->closed || sink->buffer.size() >= FLUSH_BYTES;
+                });
+                chunk.swap(sink->buffer);
+                closed = sink->closed;
+            }
+
+            if (!chunk.empty()) {
+                sink->file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                sink->bytesWritten += chunk.size();
+                chunk.clear();
+            }
+            if (closed) {
+                break;
+            }
+        }
+        sink->file.flush();
+        if (!sink->file) {
+            std::cerr << "[EventRecorder] 写入录制文件失败" << std::endl;
+        }
+    }
+
+    const EventCodecRegistry& registry_;
+    std::shared_ptr<Sink> sink_;
+    EventSystem* bus_ = nullptr;
+    std::thread writerThread_;
+    size_t lastRecorded_ = 0;
+    size_t lastSkipped_ = 0;
+};
+
+// ============================================================================
+// 回放器
+// ============================================================================
+
+// 回放选项
+struct ReplayOptions {
+    double speed = 1.0;     // 1.0 原速，2.0 两倍速，0.5 半速，<= 0 以最快速度发布
+};
+
+// 回放结果
+struct ReplayStats {
+    size_t published = 0;
+    std::chrono::nanoseconds elapsed{0};
+    std::chrono::nanoseconds maxLag{0};     // 发布时刻落后计划时刻的最大值（发布线程跟不上时变大）
+};
+
+class EventReplayer {
+public:
+    explicit EventReplayer(const EventCodecRegistry& registry) : registry_(registry), skipped_(0) {}
+
+    // 加载录制文件并校验全部事件的负载，文件损坏时返回 false（已加载的事件保留）
+    bool load(const std::string& path) {
+        events_.clear();
+        skipped_ = 0;
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "[EventReplayer] 无法打开录制文件: " << path << std::endl;
+            return false;
+        }
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        const char* pos = data.data();
+        const char* end = pos + data.size();
+        uint64_t version;
+        if (data.size() < sizeof(EventRecordFormat::MAGIC) ||
+            std::memcmp(pos, EventRecordFormat::MAGIC, sizeof(EventRecordFormat::MAGIC)) != 0 ||
+            !EventRecordFormat::getVarint(pos += sizeof(EventRecordFormat::MAGIC), end, version) ||
+            version != EventRecordFormat::VERSION) {
+            std::cerr << "[EventReplayer] 不是录制文件或版本不支持: " << path << std::endl;
+            return false;
+        }
+
+        std::vector<const EventCodecRegistry::Codec*> codecs;     // 类型编号 -> 编解码器（未注册的为 nullptr）
+        int64_t offset = 0;
+        while (pos < end) {
+            char tag = *pos++;
+            if (tag == EventRecordFormat::TYPE_TAG) {
+                uint64_t id, length;
+                if (!EventRecordFormat::getVarint(pos, end, id) || !EventRecordFormat::getVarint(pos, end, length) ||
+                    id != codecs.size() || length > static_cast<uint64_t>(end - pos)) {
+                    return corrupted(path);
+                }
+                std::string name(pos, length);
+                pos += length;
+                codecs.push_back(registry_.find(name));
+                if (!codecs.back()) {
+                    std::cerr << "[EventReplayer] 未注册的事件类型: " << name << std::endl;
+                }
+            } else if (tag == EventRecordFormat::EVENT_TAG) {
+                uint64_t id, length;
+                int64_t priority, delta, age;
+                if (!EventRecordFormat::getVarint(pos, end, id) || !EventRecordFormat::getSigned(pos, end, priority) ||
+                    !EventRecordFormat::getSigned(pos, end, delta) || !EventRecordFormat::getSigned(pos, end, age) ||
+                    !EventRecordFormat::getVarint(pos, end, length) ||
+                    id >= codecs.size() || length > static_cast<uint64_t>(end - pos)) {
+                    return corrupted(path);
+                }
+                offset += delta;
+
+                // 加载时只解码一次用来校验负载，保存的是负载字节，每次发布重新解码
+                const EventCodecRegistry::Codec* codec = codecs[id];
+                bool valid = codec && codec->decode(pos, length);
+                std::string payload(pos, length);
+                pos += length;
+                if (!valid) {
+                    skipped_++;
+                    continue;
+                }
+                events_.push_back(RecordedEvent{codec, std::move(payload), static_cast<int>(priority),
+                                                std::chrono::nanoseconds(offset), std::chrono::nanoseconds(age)});
+            } else {
+                return corrupted(path);
+            }
+        }
+
+        // 多个发布线程录制时时间戳可能略微乱序，按发布时刻排序（稳定排序保留同一时刻的录制顺序）
+        std::stable_sort(events_.begin(), events_.end(), [](const RecordedEvent& a, const RecordedEvent& b) {
+            return a.offset < b.offset;
+        });
+
+        std::cout << "[EventReplayer] 加载录制文件: " << path << " 事件数=" << events_.size()
+                  << " 跳过=" << skipped_ << std::endl;
+        return true;
+    }
+
+    // 在调用线程中按录制顺序发布全部事件，返回时所有事件都已发布（不等待处理完）
+    // 每次发布都从负载解码出新的事件对象：已发布的事件可能还在队列中或被监听器持有，不能修改后再次发布
+    // 新对象的时间戳为当前时刻减去录制时的创建到发布间隔
+    ReplayStats replay(EventSystem& bus, const ReplayOptions& options = ReplayOptions()) {
+        ReplayStats stats;
+        if (events_.empty()) {
+            return stats;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto first = events_.front().offset;
+
+        for (const auto& recorded : events_) {
+            auto now = std::chrono::steady_clock::now();
+            if (options.speed > 0) {
+                auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    (recorded.offset - first) / options.speed);
+                if (due > now) {
+                    std::this_thread::sleep_until(due);
+                    now = std::chrono::steady_clock::now();
+                }
+                stats.maxLag = std::max(stats.maxLag, std::chrono::duration_cast<std::chrono::nanoseconds>(now - due));
+            }
+
+            std::shared_ptr<Event> event = recorded.codec->decode(recorded.payload.data(), recorded.payload.size());
+            if (!event) {
+                continue;
+            }
+            event->priority = recorded.priority;
+            event->timestamp = now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(recorded.age);
+            bus.publish(std::move(event));
+            stats.published++;
+        }
+
+        stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return stats;
+    }
+
+    // 已加载的事件数量
+    size_t size() const { return events_.size(); }
+
+    // 加载时因类型未注册或负载解码失败而跳过的事件数量
+    size_t getSkippedCount() const { return skipped_; }
+
+    // 录制时长（第一个事件到最后一个事件）
+    std::chrono::nanoseconds duration() const {
+        return events_.empty() ? std::chrono::nanoseconds(0) : events_.back().offset - events_.front().offset;
+    }
+
+private:
+    struct RecordedEvent {
+        const EventCodecRegistry::Codec* codec;     // 由 registry_ 持有
+        std::string payload;
+        int priority;
+        std::chrono::nanoseconds offset;    // 相对录制开始的发布时刻
+        std::chrono::nanoseconds age;       // 录制时事件创建到发布的间隔
+    };
+
+    bool corrupted(const std::string& path) {
+        std::cerr << "[EventReplayer] 录制文件已损坏: " << path << "，已加载事件数=" << events_.size() << std::endl;
+        return false;
+    }
+
+    const EventCodecRegistry& registry_;
+    std::vector<RecordedEvent> events_;
+    size_t skipped_;
+};
+
+#endif // EVENT_RECORDER_H
@@ -3,7 +3,7 @@
 
 #include <functional>
 #include <memory>
-#include <queue>
+#include <climits>
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
@@ -14,7 +14,25 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <deque>
+#include <future>
+#include <stdexcept>
+
+#include "thread_pool.h"
+// 与 System/src 的 EventLoop 共用同一个时间轮实现（CMake 中的 timer_wheel 库提供头文件路径和实现）
+#include "timer_wheel.hpp"
+
+// 监听器计时使用 TSC（假定 constant_tsc，启用统计时对照 steady_clock 校准一次），其他平台使用 steady_clock
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define EVENT_SYSTEM_USE_RDTSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define EVENT_SYSTEM_USE_RDTSC 1
+#endif
 
 // ============================================================================
 // 事件基类 - 所有事件都必须继承此类
@@ -37,20 +55,344 @@ public:
     // 事件时间戳
     std::chrono::steady_clock::time_point timestamp;
 
+    // 请求/应答的关联ID，由 EventSystem::request 设置（0 表示不是请求）
+    uint64_t correlationId = 0;
+
     Event() : timestamp(std::chrono::steady_clock::now()) {}
 };
 
 // ============================================================================
-// 事件队列项 - 用于优先级队列
+// 订阅过滤器 - 在发布时求值，没有监听器需要的事件不会入队
+// ============================================================================
+
+// 字段索引键的类型擦除基类：标识"事件的哪个字段"以及订阅要求的值的哈希
+class FilterIndexKey {
+public:
+    virtual ~FilterIndexKey() = default;
+
+    // 是否与 other 索引同一个事件字段
+    virtual bool sameField(const FilterIndexKey& other) const = 0;
+
+    // 计算事件该字段的哈希，事件类型不匹配时返回 false
+    virtual bool hashOf(const Event& event, size_t& hash) const = 0;
+
+    size_t valueHash = 0;   // 订阅要求的字段值的哈希
+};
+
+template<typename T, typename M>
+class FieldIndexKey : public FilterIndexKey {
+public:
+    FieldIndexKey(M T::*field, const M& value) : field_(field) {
+        valueHash = std::hash<M>{}(value);
+    }
+
+    bool sameField(const FilterIndexKey& other) const override {
+        auto* key = dynamic_cast<const FieldIndexKey<T, M>*>(&other);
+        return key && key->field_ == field_;
+    }
+
+    bool hashOf(const Event& event, size_t& hash) const override {
+        auto* typedEvent = dynamic_cast<const T*>(&event);
+        if (!typedEvent) {
+            return false;
+        }
+        hash = std::hash<M>{}(typedEvent->*field_);
+        return true;
+    }
+
+private:
+    M T::*field_;
+};
+
+// 订阅过滤器
+// 1. 任意谓词：EventFilter<T>([](const T& e) { return e.level >= 3; })
+// 2. 声明式字段比较：EventFilter<T>::field(&T::level, std::greater_equal<>(), 3)
+// 3. 字段相等：EventFilter<T>::fieldEquals(&T::symbol, "AAPL")，会被编入该事件类型的字段索引，
+//    发布时按字段值哈希直接找到候选监听器，不需要逐个检查
+// 过滤器可以用 && 组合，组合后保留其中一个字段索引
+template<typename T>
+class EventFilter {
+public:
+    using Predicate = std::function<bool(const T&)>;
+
+    // 默认过滤器接受所有事件
+    EventFilter() = default;
+
+    EventFilter(Predicate predicate) : predicate_(std::move(predicate)) {}
+
+    template<typename M, typename Compare, typename V>
+    static EventFilter field(M T::*member, Compare compare, V value) {
+        return EventFilter([member, compare, value](const T& event) {
+            return compare(event.*member, value);
+        });
+    }
+
+    template<typename M, typename V>
+    static EventFilter fieldEquals(M T::*member, V value) {
+        M expected(value);
+        EventFilter filter([member, expected](const T& event) {
+            return event.*member == expected;
+        });
+        filter.indexKey_ = std::make_shared<FieldIndexKey<T, M>>(member, expected);
+        return filter;
+    }
+
+    EventFilter operator&&(const EventFilter& other) const {
+        Predicate lhs = predicate_;
+        Predicate rhs = other.predicate_;
+        EventFilter combined([lhs, rhs](const T& event) {
+            return (!lhs || lhs(event)) && (!rhs || rhs(event));
+        });
+        combined.indexKey_ = indexKey_ ? indexKey_ : other.indexKey_;
+        return combined;
+    }
+
+    bool operator()(const T& event) const {
+        return !predicate_ || predicate_(event);
+    }
+
+    bool acceptsAll() const { return !predicate_; }
+
+    const std::shared_ptr<FilterIndexKey>& indexKey() const { return indexKey_; }
+
+private:
+    Predicate predicate_;
+    std::shared_ptr<FilterIndexKey> indexKey_;
+};
+
+// ============================================================================
+// 事件队列项
 // ============================================================================
+class EventListenerBase;
+
 struct EventQueueItem {
     std::shared_ptr<Event> event;
 
-    EventQueueItem(std::shared_ptr<Event> e) : event(std::move(e)) {}
+    // 发布时已经按过滤器选出的监听器；routed 为 false 时（例如定时发布）在分发时再选择
+    std::vector<std::shared_ptr<EventListenerBase>> targets;
+    bool routed;
+
+    EventQueueItem(std::shared_ptr<Event> e) : event(std::move(e)), routed(false) {}
+
+    EventQueueItem(std::shared_ptr<Event> e, std::vector<std::shared_ptr<EventListenerBase>> t)
+        : event(std::move(e)), targets(std::move(t)), routed(true) {}
+};
+
+// ============================================================================
+// 优先级通道 - 固定数量的 FIFO 通道，按赤字轮询（Deficit Round Robin）调度
+// ============================================================================
+//
+// std::priority_queue 是堆：入队出队 O(log n)，同优先级的事件不保证先进先出，低优先级事件可能一直得不到处理。
+// 这里按优先级把事件分到固定数量的通道：
+// 1. 每个通道是一个 FIFO 队列，同一通道内的事件严格按入队顺序处理
+// 2. 出队按 DRR 从最高通道向最低通道轮转：轮到的通道最多连续处理 weight 个事件，然后轮到下一个通道；
+//    所有通道都有积压时，各通道处理的事件数之比等于权重之比，低优先级通道也有保证的处理份额
+// 3. 通道数量固定（最多 MAX_LANES 个），入队按优先级线性查找通道，出队最多跳过所有空通道一次，都是 O(1)
+//
+// 不是线程安全的，由 EventSystem 的 queueMutex_ 保护
+
+// 通道配置：priority >= minPriority 的事件进入满足条件的最高通道，最低的通道同时接收低于它的优先级
+struct PriorityLaneConfig {
+    int minPriority;
+    size_t weight;      // 每轮最多连续处理的事件数
+};
+
+// 通道统计
+struct PriorityLaneStats {
+    int minPriority = 0;
+    size_t weight = 0;
+    size_t pending = 0;         // 排队中的事件数
+    size_t dispatched = 0;      // 已出队的事件数
+};
+
+class PriorityLanes {
+public:
+    static constexpr size_t MAX_LANES = 8;
+
+    PriorityLanes() : current_(0), size_(0) {
+        configure(defaultLanes());
+    }
+
+    // 默认通道：低（< 0）、普通（0）、高（1~9）、紧急（>= 10），权重 1 : 4 : 16 : 64
+    static std::vector<PriorityLaneConfig> defaultLanes() {
+        return {{INT_MIN, 1}, {0, 4}, {1, 16}, {10, 64}};
+    }
+
+    // 重新配置通道，只能在队列为空时调用；配置非法（空、超过 MAX_LANES、权重为 0、minPriority 重复）时返回 false
+    bool configure(std::vector<PriorityLaneConfig> configs) {
+        if (size_ != 0 || configs.empty() || configs.size() > MAX_LANES) {
+            return false;
+        }
+        std::sort(configs.begin(), configs.end(), [](const PriorityLaneConfig& a, const PriorityLaneConfig& b) {
+            return a.minPriority < b.minPriority;
+        });
+        for (size_t i = 0; i < configs.size(); ++i) {
+            if (configs[i].weight == 0 || (i > 0 && configs[i].minPriority == configs[i - 1].minPriority)) {
+                return false;
+            }
+        }
+
+        lanes_.clear();
+        lanes_.resize(configs.size());
+        for (size_t i = 0; i < configs.size(); ++i) {
+            lanes_[i].minPriority = configs[i].minPriority;
+            lanes_[i].weight = configs[i].weight;
+        }
+        current_ = lanes_.size() - 1;
+        return true;
+    }
+
+    void push(EventQueueItem item) {
+        lanes_[laneOf(item.event->priority)].items.push_back(std::move(item));
+        size_++;
+    }
+
+    // 按 DRR 取出下一个事件，调用前必须保证队列不空
+    EventQueueItem pop() {
+        while (true) {
+            Lane& lane = lanes_[current_];
+            if (lane.items.empty()) {
+                lane.deficit = 0;
+                advance();
+                continue;
+            }
+
+            // 刚轮到这个通道，发放本轮的额度
+            if (lane.deficit == 0) {
+                lane.deficit = lane.weight;
+            }
+            EventQueueItem item = std::move(lane.items.front());
+            lane.items.pop_front();
+            lane.deficit--;
+            lane.dispatched++;
+            size_--;
+
+            // 额度用完或者通道已空，下次从下一个通道开始
+            if (lane.deficit == 0 || lane.items.empty()) {
+                lane.deficit = 0;
+                advance();
+            }
+            return item;
+        }
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    size_t size() const { return size_; }
+
+    void clear() {
+        for (auto& lane : lanes_) {
+            lane.items.clear();
+            lane.deficit = 0;
+        }
+        size_ = 0;
+    }
+
+    std::vector<PriorityLaneStats> stats() const {
+        std::vector<PriorityLaneStats> result;
+        for (const auto& lane : lanes_) {
+            PriorityLaneStats stats;
+            stats.minPriority = lane.minPriority;
+            stats.weight = lane.weight;
+            stats.pending = lane.items.size();
+            stats.dispatched = lane.dispatched;
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+private:
+    struct Lane {
+        int minPriority = 0;
+        size_t weight = 1;
+        size_t deficit = 0;         // 本轮剩余额度，0 表示没有轮到
+        size_t dispatched = 0;
+        std::deque<EventQueueItem> items;
+    };
+
+    // 找到 minPriority <= priority 的最高通道（通道数固定，线性查找）
+    size_t laneOf(int priority) const {
+        size_t lane = 0;
+        while (lane + 1 < lanes_.size() && lanes_[lane + 1].minPriority <= priority) {
+            lane++;
+        }
+        return lane;
+    }
+
+    // 从高通道向低通道轮转，最低通道之后回到最高通道
+    void advance() {
+        current_ = current_ == 0 ? lanes_.size() - 1 : current_ - 1;
+    }
+
+    std::vector<Lane> lanes_;       // 按 minPriority 升序
+    size_t current_;                // 当前轮到的通道
+    size_t size_;
+};
+
+// ============================================================================
+// 监听器耗时统计
+// ============================================================================
+
+// 每个监听器一份，可能被处理线程、dispatch 的调用方和 Actor 线程池同时更新，全部是 relaxed 原子操作
+struct ListenerTimings {
+    static constexpr size_t BUCKETS = 32;   // 桶 0 为 0ns，桶 i 为 [2^(i-1), 2^i) ns，最后一个桶包含更长的调用
+
+    std::atomic<uint64_t> invocations{0};
+    std::atomic<uint64_t> slowCalls{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::array<std::atomic<uint64_t>, BUCKETS> histogram{};
+
+    void record(uint64_t ns) {
+        invocations.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t currentMax = maxNs.load(std::memory_order_relaxed);
+        while (ns > currentMax && !maxNs.compare_exchange_weak(currentMax, ns, std::memory_order_relaxed)) {
+        }
+        size_t bucket = std::min<size_t>(std::bit_width(ns), BUCKETS - 1);
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        invocations.store(0, std::memory_order_relaxed);
+        slowCalls.store(0, std::memory_order_relaxed);
+        totalNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+        for (auto& bucket : histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// 监听器统计快照
+struct ListenerStats {
+    size_t listenerId = 0;
+    std::string eventType;                      // 订阅的事件类型（std::type_index::name）
+    bool actor = false;                         // Actor 监听器统计的是线程池中的执行时间
+    uint64_t invocations = 0;
+    uint64_t slowCalls = 0;                     // 超过慢调用阈值的次数
+    std::chrono::nanoseconds totalTime{0};
+    std::chrono::nanoseconds maxTime{0};
+    std::array<uint64_t, ListenerTimings::BUCKETS> histogram{};
+
+    std::chrono::nanoseconds meanTime() const {
+        return invocations ? totalTime / static_cast<int64_t>(invocations) : std::chrono::nanoseconds(0);
+    }
 
-    // 优先级比较（优先级高的排在前面）
-    bool operator<(const EventQueueItem& other) const {
-        return event->priority < other.event->priority;
+    // 百分位耗时（按直方图估算，返回所在桶的上界），p 取 0~1
+    std::chrono::nanoseconds percentile(double p) const {
+        if (invocations == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        uint64_t rank = std::min(static_cast<uint64_t>(p * static_cast<double>(invocations)), invocations - 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < histogram.size(); ++i) {
+            seen += histogram[i];
+            if (seen > rank) {
+                return i == 0 ? std::chrono::nanoseconds(0) : std::chrono::nanoseconds(uint64_t(1) << i);
+            }
+        }
+        return maxTime;
     }
 };
 
@@ -63,8 +405,134 @@ public:
     virtual ~EventListenerBase() = default;
     virtual void onEvent(const std::shared_ptr<Event>& event) = 0;
 
+    // 订阅过滤器，发布时调用（持有监听器列表锁），不能阻塞或访问 EventSystem
+    virtual bool accepts(const Event& event) const {
+        (void)event;
+        return true;
+    }
+
+    // 字段相等过滤器的索引键，没有时为 nullptr
+    virtual std::shared_ptr<FilterIndexKey> indexKey() const { return nullptr; }
+
     // 监听器ID（用于注销）
     size_t listenerId = 0;
+
+    // 是否已编入字段索引（发布时不在线性扫描中检查）
+    bool indexed = false;
+
+    // 注销后置为 false，已经入队的事件不再分发给它
+    std::atomic<bool> active{true};
+
+    // 执行耗时统计；Actor 监听器与它的目标监听器共用同一份
+    std::shared_ptr<ListenerTimings> timings = std::make_shared<ListenerTimings>();
+
+    // 是否由调用方计时（Actor 监听器在分发线程中只是投递到邮箱，计时在线程池中对目标监听器进行）
+    bool timed = true;
+};
+
+// ============================================================================
+// 监听器计时：统计关闭时只多一次原子读，开启时每次调用读两次时钟
+// ============================================================================
+class ListenerProfiler {
+public:
+    // 慢调用回调：监听器、触发的事件、耗时，在执行监听器的线程中调用
+    using SlowCallHandler = std::function<void(const EventListenerBase&, const Event&, std::chrono::nanoseconds)>;
+
+    ListenerProfiler() : enabled_(false), slowThresholdTicks_(UINT64_MAX), nsPerTick_(1.0) {}
+
+    void setEnabled(bool enabled) {
+        if (enabled) {
+            calibrate();
+        }
+        enabled_.store(enabled, std::memory_order_release);
+    }
+
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // 慢调用阈值，<= 0 表示不检测
+    void setSlowThreshold(std::chrono::nanoseconds threshold) {
+        calibrate();
+        slowThresholdTicks_.store(threshold.count() > 0
+                                      ? static_cast<uint64_t>(static_cast<double>(threshold.count()) / nsPerTick_)
+                                      : UINT64_MAX,
+                                  std::memory_order_relaxed);
+    }
+
+    // 只在构造 EventSystem 时设置一次
+    void setSlowCallHandler(SlowCallHandler handler) { slowCallHandler_ = std::move(handler); }
+
+    // 调用监听器并计时，监听器抛出的异常原样传出（同样计入耗时）
+    void invoke(EventListenerBase& listener, const std::shared_ptr<Event>& event) {
+        if (!listener.timed || !enabled_.load(std::memory_order_acquire)) {
+            listener.onEvent(event);
+            return;
+        }
+
+        uint64_t start = readTicks();
+        try {
+            listener.onEvent(event);
+        } catch (...) {
+            record(listener, *event, readTicks() - start);
+            throw;
+        }
+        record(listener, *event, readTicks() - start);
+    }
+
+private:
+    static uint64_t readTicks() {
+#ifdef EVENT_SYSTEM_USE_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // 测量 TSC 频率（只做一次，约 10ms）
+    void calibrate() {
+#ifdef EVENT_SYSTEM_USE_RDTSC
+        std::call_once(calibrated_, [this] {
+            auto wallStart = std::chrono::steady_clock::now();
+            uint64_t tickStart = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            uint64_t ticks = __rdtsc() - tickStart;
+            auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart);
+            if (ticks > 0) {
+                nsPerTick_ = static_cast<double>(wall.count()) / static_cast<double>(ticks);
+            }
+        });
+#endif
+    }
+
+    void record(EventListenerBase& listener, const Event& event, uint64_t ticks) {
+        uint64_t ns = static_cast<uint64_t>(static_cast<double>(ticks) * nsPerTick_);
+        listener.timings->record(ns);
+
+        if (ticks >= slowThresholdTicks_.load(std::memory_order_relaxed)) {
+            listener.timings->slowCalls.fetch_add(1, std::memory_order_relaxed);
+            if (slowCallHandler_) {
+                slowCallHandler_(listener, event, std::chrono::nanoseconds(ns));
+            }
+        }
+    }
+
+    std::atomic<bool> enabled_;
+    std::atomic<uint64_t> slowThresholdTicks_;
+    double nsPerTick_;              // 校准后只读，enabled_ 的 release/acquire 保证可见
+    std::once_flag calibrated_;
+    SlowCallHandler slowCallHandler_;
+};
+
+// 慢调用诊断事件：监听器一次调用的耗时超过 setSlowListenerThreshold 设置的阈值时发布
+// 订阅该事件的监听器自己变慢时不会再发布，避免递归
+class SlowListenerEvent : public Event {
+public:
+    size_t listenerId = 0;
+    std::string eventName;                      // 触发慢调用的事件
+    std::chrono::nanoseconds duration{0};
+
+    std::type_index getType() const override { return typeid(SlowListenerEvent); }
+    std::string getName() const override { return "SlowListenerEvent"; }
 };
 
 // ============================================================================
@@ -77,8 +545,18 @@ public:
     // 可以接受函数指针，lambda 表达式，或绑定的函数对象，成员函数（通过 std::bind 绑定或 lambda 捕获 this 指针）
     using CallbackType = std::function<void(const std::shared_ptr<T>&)>;
 
-    explicit EventListener(CallbackType callback)
-        : callback_(std::move(callback)) {}
+    explicit EventListener(CallbackType callback, EventFilter<T> filter = EventFilter<T>())
+        : callback_(std::move(callback)), filter_(std::move(filter)) {}
+
+    bool accepts(const Event& event) const override {
+        if (filter_.acceptsAll()) {
+            return true;
+        }
+        auto* typedEvent = dynamic_cast<const T*>(&event);
+        return typedEvent && filter_(*typedEvent);
+    }
+
+    std::shared_ptr<FilterIndexKey> indexKey() const override { return filter_.indexKey(); }
 
     void onEvent(const std::shared_ptr<Event>& event) override {
         // 类型安全的向下转换，运行时检查事件类型是否匹配，转换失败会返回 nullptr
@@ -90,6 +568,246 @@ public:
 
 private:
     CallbackType callback_;
+    EventFilter<T> filter_;
+};
+
+// ============================================================================
+// Actor 模式：每个订阅一个有界邮箱，在共享线程池上执行
+// ============================================================================
+
+// 邮箱满时的处理策略
+enum class MailboxOverflowPolicy {
+    Block,       // 发布方等待邮箱有空位（最多等待 blockTimeout，超时后丢弃该事件）；等待发生在分发线程上，会拖慢所有监听器
+    DropNewest,  // 丢弃新到达的事件
+    DropOldest   // 丢弃邮箱中最旧的事件，为新事件腾出位置
+};
+
+// Actor 订阅选项
+struct ActorOptions {
+    size_t capacity = 1024;                                     // 邮箱容量
+    MailboxOverflowPolicy overflow = MailboxOverflowPolicy::DropOldest;  // 默认不阻塞分发线程，慢监听器只丢自己的旧事件
+    std::chrono::milliseconds blockTimeout{100};                // Block 策略的最长等待时间，卡死的监听器不会让总线一直阻塞
+    size_t batchSize = 32;                                      // 每次调度最多处理的事件数，处理完后让出线程，保证各监听器公平
+};
+
+// Actor 监听器的统计信息
+struct ActorStats {
+    size_t pending = 0;     // 邮箱中等待处理的事件数
+    size_t processed = 0;   // 已处理的事件数
+    size_t dropped = 0;     // 因邮箱满被丢弃的事件数
+};
+
+// 监听器邮箱
+// 1. 同一个邮箱同一时刻最多只有一个处理任务在线程池中运行，事件按到达顺序处理
+// 2. 慢监听器只会填满自己的邮箱，不会拖慢其他监听器和后续事件的分发
+class ActorMailbox : public std::enable_shared_from_this<ActorMailbox> {
+public:
+    ActorMailbox(std::shared_ptr<EventListenerBase> target, const ActorOptions& options,
+                 CodeGuide::ThreadPool& pool, ListenerProfiler& profiler)
+        : target_(std::move(target)), options_(options), pool_(pool), profiler_(profiler),
+          scheduled_(false), closed_(false), processed_(0), dropped_(0) {
+        if (options_.capacity == 0) options_.capacity = 1;
+        if (options_.batchSize == 0) options_.batchSize = 1;
+    }
+
+    // 按溢出策略投递事件，被丢弃时返回 false
+    bool post(const std::shared_ptr<Event>& event) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+
+        if (queue_.size() >= options_.capacity) {
+            switch (options_.overflow) {
+                case MailboxOverflowPolicy::DropNewest:
+                    dropped_++;
+                    return false;
+                case MailboxOverflowPolicy::DropOldest:
+                    queue_.pop_front();
+                    dropped_++;
+                    break;
+                case MailboxOverflowPolicy::Block:
+                    if (!notFull_.wait_for(lock, options_.blockTimeout, [this] {
+                            return closed_ || queue_.size() < options_.capacity;
+                        }) || closed_) {
+                        dropped_++;
+                        return false;
+                    }
+                    break;
+            }
+        }
+
+        queue_.push_back(event);
+        bool schedule = !scheduled_;
+        scheduled_ = true;
+        lock.unlock();
+
+        if (schedule) {
+            auto self = shared_from_this();
+            pool_.post([self] { self->drain(); });
+        }
+        return true;
+    }
+
+    // 关闭邮箱：丢弃未处理的事件，唤醒等待中的发布方
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        dropped_ += queue_.size();
+        queue_.clear();
+        notFull_.notify_all();
+    }
+
+    // 等待邮箱中的事件全部处理完，到 deadline 仍未处理完时返回 false
+    bool waitIdle(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return idle_.wait_until(lock, deadline, [this] { return !scheduled_; });
+    }
+
+    // 丢弃还没开始处理的事件（邮箱仍可继续投递），返回丢弃的数量
+    size_t discardPending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t count = queue_.size();
+        dropped_ += count;
+        queue_.clear();
+        notFull_.notify_all();
+        return count;
+    }
+
+    ActorStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ActorStats result;
+        result.pending = queue_.size();
+        result.processed = processed_;
+        result.dropped = dropped_;
+        return result;
+    }
+
+private:
+    // 在线程池中处理一批事件，还有剩余时重新提交，避免长期占用工作线程
+    void drain() {
+        for (size_t handled = 0; handled < options_.batchSize; ++handled) {
+            std::shared_ptr<Event> event;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (queue_.empty()) {
+                    break;
+                }
+                event = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            notFull_.notify_one();
+
+            try {
+                profiler_.invoke(*target_, event);
+            } catch (const std::exception& e) {
+                std::cerr << "[EventSystem] 监听器异常: " << e.what() << std::endl;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            processed_++;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!queue_.empty()) {
+            lock.unlock();
+            auto self = shared_from_this();
+            pool_.post([self] { self->drain(); });
+            return;
+        }
+        scheduled_ = false;
+        idle_.notify_all();
+    }
+
+    std::shared_ptr<EventListenerBase> target_;
+    ActorOptions options_;
+    CodeGuide::ThreadPool& pool_;
+    ListenerProfiler& profiler_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notFull_;   // Block 策略下等待空位
+    std::condition_variable idle_;      // waitIdle 等待处理完成
+    std::deque<std::shared_ptr<Event>> queue_;
+    bool scheduled_;                    // 是否已有处理任务在线程池中
+    bool closed_;
+    size_t processed_;
+    size_t dropped_;
+};
+
+// Actor 监听器：分发线程只把事件放入邮箱，真正的回调在线程池中执行
+class ActorListener : public EventListenerBase {
+public:
+    ActorListener(std::shared_ptr<EventListenerBase> target, std::shared_ptr<ActorMailbox> mailbox)
+        : target_(std::move(target)), mailbox_(std::move(mailbox)) {
+        timings = target_->timings;
+        timed = false;
+    }
+
+    void onEvent(const std::shared_ptr<Event>& event) override {
+        mailbox_->post(event);
+    }
+
+    // 过滤器在发布时求值，不需要的事件不会进入邮箱
+    bool accepts(const Event& event) const override { return target_->accepts(event); }
+
+    std::shared_ptr<FilterIndexKey> indexKey() const override { return target_->indexKey(); }
+
+    const std::shared_ptr<ActorMailbox>& mailbox() const { return mailbox_; }
+
+private:
+    std::shared_ptr<EventListenerBase> target_;
+    std::shared_ptr<ActorMailbox> mailbox_;
+};
+
+// ============================================================================
+// 请求/应答 - 等待应答的 promise
+// ============================================================================
+
+// 请求失败：超时、没有监听器接受请求、应答类型不匹配或应答表已满
+class RequestError : public std::runtime_error {
+public:
+    explicit RequestError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// 类型擦除：应答表中保存不同应答类型的 promise
+class PendingReplyBase {
+public:
+    virtual ~PendingReplyBase() = default;
+    virtual void fulfill(std::shared_ptr<Event> response) = 0;
+    virtual void fail(std::exception_ptr error) = 0;
+};
+
+template<typename Resp>
+class PendingReply : public PendingReplyBase {
+public:
+    std::future<std::shared_ptr<Resp>> getFuture() { return promise_.get_future(); }
+
+    void fulfill(std::shared_ptr<Event> response) override {
+        auto typedResponse = std::dynamic_pointer_cast<Resp>(response);
+        if (!typedResponse) {
+            fail(std::make_exception_ptr(RequestError("reply type does not match the request")));
+            return;
+        }
+        promise_.set_value(std::move(typedResponse));
+    }
+
+    void fail(std::exception_ptr error) override {
+        promise_.set_exception(std::move(error));
+    }
+
+private:
+    std::promise<std::shared_ptr<Resp>> promise_;
+};
+
+// 应答表的槽位：id 为 0 表示空闲，为 BUSY 表示正在被占用或完成，否则是等待中的关联ID
+// 谁把 id 从关联ID CAS 成 BUSY，谁就独占 pending（应答和超时只有一方成功）
+// timer 是超时定时器的ID（没有超时为 0），在发布请求前持有 queueMutex_ 写入，应答时取消
+struct ReplySlot {
+    static constexpr uint64_t BUSY = UINT64_MAX;
+
+    std::atomic<uint64_t> id{0};
+    std::atomic<asyncio::TimerWheel::TimerId> timer{asyncio::TimerWheel::INVALID_TIMER};
+    std::unique_ptr<PendingReplyBase> pending;
 };
 
 // ============================================================================
@@ -111,45 +829,114 @@ public:
     // 启动异步事件处理线程
     void start() {
         if (running_.load()) {
-            std::cout << "[EventSystem] 已经在运行中" << std::endl;
+            if (isVerbose()) {
+                std::cout << "[EventSystem] 已经在运行中" << std::endl;
+            }
             return;
         }
 
         running_.store(true);
         workerThread_ = std::thread(&EventSystem::processEvents, this);
-        std::cout << "[EventSystem] 异步处理线程已启动" << std::endl;
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 异步处理线程已启动" << std::endl;
+        }
     }
 
-    // 停止异步事件处理线程
-    void stop() {
-        if (!running_.load()) {
-            return;
+    // 停止异步事件处理线程，并在 drainTimeout 内等待各 Actor 邮箱处理完
+    // 同步 dispatch 投递到邮箱的事件也要等待，所以没有调用过 start 时同样会排空邮箱
+    void stop(std::chrono::milliseconds drainTimeout = std::chrono::milliseconds(1000)) {
+        if (running_.exchange(false)) {
+            cv_.notify_all();
+            // 等待线程完成后再结束，避免线程泄露导致程序退出异常
+            if (workerThread_.joinable()) {
+                workerThread_.join();
+            }
+            if (isVerbose()) {
+                std::cout << "[EventSystem] 异步处理线程已停止" << std::endl;
+            }
+        }
+
+        drainActors(drainTimeout);
+    }
+
+    // 启用 Actor 模式的共享线程池（不调用时第一次 subscribeActor 使用硬件并发数）
+    void enableActorMode(size_t threadCount = 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!actorPool_) {
+            actorPool_ = std::make_unique<CodeGuide::ThreadPool>(threadCount);
+            if (isVerbose()) {
+                std::cout << "[EventSystem] Actor 线程池已启动，线程数=" << actorPool_->size() << std::endl;
+            }
         }
+    }
+
+    // 注册 Actor 监听器：独立的有界邮箱，回调在共享线程池中按事件顺序执行
+    // 慢监听器只会积压自己的邮箱，邮箱满时按 options.overflow 处理
+    template<typename T>
+    size_t subscribeActor(typename EventListener<T>::CallbackType callback,
+                          const ActorOptions& options = ActorOptions()) {
+        return subscribeActor<T>(EventFilter<T>(), std::move(callback), options);
+    }
 
-        running_.store(false);
-        cv_.notify_all();
-        // 等待线程完成后再结束，避免线程泄露导致程序退出异常
-        if (workerThread_.joinable()) {
-            workerThread_.join();
+    // 注册带过滤器的 Actor 监听器
+    template<typename T>
+    size_t subscribeActor(EventFilter<T> filter, typename EventListener<T>::CallbackType callback,
+                          const ActorOptions& options = ActorOptions()) {
+        enableActorMode();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto target = std::make_shared<EventListener<T>>(std::move(callback), std::move(filter));
+        auto mailbox = std::make_shared<ActorMailbox>(target, options, *actorPool_, profiler_);
+        auto listener = std::make_shared<ActorListener>(target, mailbox);
+        listener->listenerId = nextListenerId_++;
+        // 慢调用诊断中报告的是目标监听器，使用同一个ID
+        target->listenerId = listener->listenerId;
+
+        std::type_index typeIndex(typeid(T));
+        addListenerLocked(typeIndex, listener);
+        actors_[listener->listenerId] = mailbox;
+
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 注册 Actor 监听器 ID=" << listener->listenerId
+                      << " 事件类型=" << typeIndex.name()
+                      << " 邮箱容量=" << options.capacity << std::endl;
         }
 
-        std::cout << "[EventSystem] 异步处理线程已停止" << std::endl;
+        return listener->listenerId;
+    }
+
+    // 获取 Actor 监听器的统计信息（不是 Actor 监听器时返回全 0）
+    ActorStats getActorStats(size_t listenerId) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = actors_.find(listenerId);
+        return it != actors_.end() ? it->second->stats() : ActorStats();
     }
 
     // 注册事件监听器
     template<typename T>
     size_t subscribe(typename EventListener<T>::CallbackType callback) {
+        return subscribe<T>(EventFilter<T>(), std::move(callback));
+    }
+
+    // 注册带过滤器的事件监听器
+    // 过滤器在发布时求值：没有任何监听器接受的事件不会入队，也不会唤醒处理线程
+    template<typename T>
+    size_t subscribe(EventFilter<T> filter, typename EventListener<T>::CallbackType callback) {
         std::lock_guard<std::mutex> lock(mutex_);
 
         // 移动语义：将回调函数移动到新创建的 EventListener 中，避免拷贝
-        auto listener = std::make_shared<EventListener<T>>(std::move(callback));
+        auto listener = std::make_shared<EventListener<T>>(std::move(callback), std::move(filter));
         listener->listenerId = nextListenerId_++;
 
         std::type_index typeIndex(typeid(T));
-        listeners_[typeIndex].push_back(listener);
+        addListenerLocked(typeIndex, listener);
 
-        std::cout << "[EventSystem] 注册监听器 ID=" << listener->listenerId
-                  << " 事件类型=" << typeIndex.name() << std::endl;
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 注册监听器 ID=" << listener->listenerId
+                      << " 事件类型=" << typeIndex.name()
+                      << (listener->indexed ? " (字段索引)" : "") << std::endl;
+        }
 
         return listener->listenerId;
     }
@@ -167,6 +954,15 @@ public:
         }
 
         auto& listenerList = it->second;
+
+        // 已经入队的事件不再分发给它，并从字段索引中移除（remove_if 之后被移走的元素不能再访问）
+        for (auto& listener : listenerList) {
+            if (listener->listenerId == listenerId) {
+                listener->active.store(false);
+                removeFromIndexLocked(typeIndex, listener);
+            }
+        }
+
         // 使用 remove_if 移除匹配的监听器，防止迭代器失效
         // std::remove_if 不会直接删除元素（不改变容器大小），只是「标记」要删除的元素（移到尾部）并返回待删除的第一个元素
         // 后续需配合 erase 才能真正删除。
@@ -178,7 +974,17 @@ public:
         if (listenerIt != listenerList.end()) {
             // 移除[listenerIt, listenerList.end()) 范围内的元素
             listenerList.erase(listenerIt, listenerList.end());
-            std::cout << "[EventSystem] 注销监听器 ID=" << listenerId << std::endl;
+
+            // Actor 监听器：关闭邮箱，丢弃尚未处理的事件
+            auto actorIt = actors_.find(listenerId);
+            if (actorIt != actors_.end()) {
+                actorIt->second->close();
+                actors_.erase(actorIt);
+            }
+
+            if (isVerbose()) {
+                std::cout << "[EventSystem] 注销监听器 ID=" << listenerId << std::endl;
+            }
             return true;
         }
 
@@ -193,33 +999,161 @@ public:
         // std::is_base_of<Event, T>::value 检查 T 是否是 Event 的子类
         static_assert(std::is_base_of<Event, T>::value,
                       "T must inherit from Event");
+        publishEvent(std::move(event));
+    }
 
-        {
-            std::lock_guard<std::mutex> lock(queueMutex_);
-            eventQueue_.push(EventQueueItem(event));
-            // 原子执行：先返回 count 旧值（0），再将 count 加 1（最终 count=1）
-            eventCount_.fetch_add(1);
+    // 发布请求事件（异步），返回等待应答的 future
+    // 应答由 reply() 直接交给等待中的 promise，不经过事件队列，也不需要订阅应答事件
+    // 超时（timeout <= 0 表示不超时）、没有监听器接受请求或者应答表已满时，future 中保存 RequestError
+    // 同一个请求对象不能同时用于多个请求：correlationId 保存在事件对象中
+    template<typename Req, typename Resp>
+    std::future<std::shared_ptr<Resp>> request(std::shared_ptr<Req> event,
+                                               std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) {
+        static_assert(std::is_base_of<Event, Req>::value,
+                      "Req must inherit from Event");
+        static_assert(std::is_base_of<Event, Resp>::value,
+                      "Resp must inherit from Event");
+
+        std::unique_ptr<PendingReplyBase> pending;
+        auto typedPending = std::make_unique<PendingReply<Resp>>();
+        std::future<std::shared_ptr<Resp>> future = typedPending->getFuture();
+        pending = std::move(typedPending);
+
+        uint64_t correlationId = registerRequest(pending);
+        if (correlationId == 0) {
+            pending->fail(std::make_exception_ptr(RequestError("too many pending requests")));
+            return future;
         }
 
-        // 唤醒处理线程
-        cv_.notify_one();
+        // 超时定时器在发布前加入时间轮，应答时（包括下面发布失败）由 completeRequest 取消
+        if (timeout.count() > 0) {
+            armRequestTimeout(correlationId, currentTick() + toTicks(timeout));
+        }
+
+        event->correlationId = correlationId;
+        if (!publishEvent(std::move(event))) {
+            completeRequest(correlationId, nullptr,
+                            std::make_exception_ptr(RequestError("no listener accepts the request")));
+        }
+        return future;
+    }
+
+    // 应答请求（通常在请求事件的监听器中调用）
+    // 返回 false 表示请求已经超时、已被应答，或者 request 不是通过 request() 发布的
+    template<typename Resp>
+    bool reply(const Event& request, std::shared_ptr<Resp> response) {
+        static_assert(std::is_base_of<Event, Resp>::value,
+                      "Resp must inherit from Event");
+        return completeRequest(request.correlationId, std::move(response), nullptr);
+    }
+
+    // 以异常应答请求，请求方在 future.get() 时抛出
+    bool replyError(const Event& request, std::exception_ptr error) {
+        return completeRequest(request.correlationId, nullptr, std::move(error));
+    }
+
+    // 注册应答者：handler 的返回值作为应答（返回 nullptr 表示不应答），抛出的异常转交给请求方
+    // 通过 publish() 发布的普通事件同样会调用 handler，只是没有人等待应答
+    template<typename Req, typename Resp>
+    size_t respond(std::function<std::shared_ptr<Resp>(const std::shared_ptr<Req>&)> handler) {
+        return subscribe<Req>([this, handler = std::move(handler)](const std::shared_ptr<Req>& request) {
+            try {
+                auto response = handler(request);
+                if (response) {
+                    reply(*request, std::move(response));
+                }
+            } catch (...) {
+                replyError(*request, std::current_exception());
+            }
+        });
+    }
+
+    // 获取等待应答的请求数量
+    size_t getPendingRequestCount() const {
+        return pendingRequests_.load();
+    }
+
+    // 定时器ID，用于取消延迟/周期发布
+    using TimerId = asyncio::TimerWheel::TimerId;
+
+    // 延迟 delay 后发布事件（精度 1ms）
+    // 定时事件保存在总线自己的时间轮中，由事件处理线程在到期时放入队列，不会为每个事件创建线程
+    template<typename T>
+    TimerId publishAfter(std::chrono::milliseconds delay, std::shared_ptr<T> event) {
+        static_assert(std::is_base_of<Event, T>::value,
+                      "T must inherit from Event");
+        return schedule(currentTick() + toTicks(delay), 0, std::move(event));
+    }
+
+    // 在 when 时刻发布事件，已经过去的时刻在下一个 tick 发布
+    template<typename T>
+    TimerId publishAt(std::chrono::steady_clock::time_point when, std::shared_ptr<T> event) {
+        static_assert(std::is_base_of<Event, T>::value,
+                      "T must inherit from Event");
+        uint64_t tick = when > startTime_
+            ? toTicks(std::chrono::duration_cast<std::chrono::microseconds>(when - startTime_))
+            : 0;
+        return schedule(tick, 0, std::move(event));
+    }
+
+    // 每隔 interval 发布一次同一个事件对象（第一次在 interval 之后），直到 cancelScheduled
+    template<typename T>
+    TimerId publishEvery(std::chrono::milliseconds interval, std::shared_ptr<T> event) {
+        static_assert(std::is_base_of<Event, T>::value,
+                      "T must inherit from Event");
+        uint64_t ticks = std::max<uint64_t>(1, toTicks(interval));
+        return schedule(currentTick() + ticks, ticks, std::move(event));
+    }
+
+    // 取消尚未发布的定时事件（周期事件取消后不再发布），O(1)
+    bool cancelScheduled(TimerId id) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        return timers_.cancel(id);
+    }
 
-        std::cout << "[EventSystem] 发布事件: " << event->getName()
-                  << " 优先级=" << event->priority << std::endl;
+    // 获取尚未到期的定时事件数量
+    size_t getScheduledEventCount() const {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        return timers_.size();
     }
 
     // 批量发布事件（确保所有事件都入队后再唤醒处理线程）
-    // 用法：当需要发布多个相关事件时，使用此方法确保优先级正确生效
+    // 用法：当需要发布多个相关事件时，使用此方法确保各优先级通道的调度一次看到整批事件
     void publishBatch(std::vector<std::shared_ptr<Event>> events) {
         if (events.empty()) return;
 
+        std::vector<EventQueueItem> items;
+        std::shared_ptr<const PublishObserver> observer;
         {
-            std::lock_guard<std::mutex> lock(queueMutex_);
+            std::lock_guard<std::mutex> lock(mutex_);
+            observer = publishObserver_;
+            for (auto& event : events) {
+                std::vector<std::shared_ptr<EventListenerBase>> targets;
+                collectTargetsLocked(*event, targets);
+                if (targets.empty()) {
+                    filteredCount_.fetch_add(1);
+                } else {
+                    items.emplace_back(event, std::move(targets));
+                }
+            }
+        }
+        if (observer) {
             for (auto& event : events) {
-                eventQueue_.push(EventQueueItem(event));
+                (*observer)(event);
+            }
+        }
+        if (items.empty()) return;
+
+        {
+            bool verbose = isVerbose();
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            for (auto& item : items) {
+                if (verbose) {
+                    std::cout << "[EventSystem] 批量发布事件: " << item.event->getName()
+                              << " 优先级=" << item.event->priority << std::endl;
+                }
+                eventQueue_.push(std::move(item));
                 eventCount_.fetch_add(1);
-                std::cout << "[EventSystem] 批量发布事件: " << event->getName()
-                          << " 优先级=" << event->priority << std::endl;
             }
         }
 
@@ -233,33 +1167,144 @@ public:
         static_assert(std::is_base_of<Event, T>::value,
                       "T must inherit from Event");
 
-        std::cout << "[EventSystem] 同步分发事件: " << event->getName() << std::endl;
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 同步分发事件: " << event->getName() << std::endl;
+        }
+
+        std::vector<std::shared_ptr<EventListenerBase>> targets;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            std::type_index typeIndex(typeid(T));
+            auto it = listeners_.find(typeIndex);
+
+            if (it != listeners_.end()) {
+                for (auto& listener : it->second) {
+                    if (listener->accepts(*event)) {
+                        targets.push_back(listener);
+                    }
+                }
+            }
+        }
+
+        // 与 processEvents 一样在锁外调用，监听器（以及慢调用诊断）可以发布事件
+        std::shared_ptr<Event> baseEvent = event;
+        for (auto& listener : targets) {
+            profiler_.invoke(*listener, baseEvent);
+        }
+    }
+
+    // 开启/关闭监听器耗时统计（默认关闭，关闭时分发路径只多一次原子读）
+    void enableListenerStats(bool enabled = true) {
+        profiler_.setEnabled(enabled);
+    }
+
+    // 开启/关闭运行日志：逐事件的发布、分发、处理记录，以及监听器注册和线程启停（默认关闭）
+    // 这些日志同步写 std::cout 并逐条刷新，只用于调试；警告和错误不受影响
+    void setVerbose(bool verbose = true) {
+        verbose_.store(verbose, std::memory_order_relaxed);
+    }
+
+    bool isVerbose() const {
+        return verbose_.load(std::memory_order_relaxed);
+    }
+
+    // 设置慢调用阈值（<= 0 表示不检测），同时开启耗时统计
+    // 监听器一次调用超过阈值时发布 SlowListenerEvent，并输出一条警告
+    void setSlowListenerThreshold(std::chrono::nanoseconds threshold) {
+        profiler_.setSlowThreshold(threshold);
+        if (threshold.count() > 0) {
+            profiler_.setEnabled(true);
+        }
+    }
 
+    // 获取监听器的耗时统计（监听器不存在时返回全 0）
+    ListenerStats getListenerStats(size_t listenerId) const {
         std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : listeners_) {
+            for (const auto& listener : entry.second) {
+                if (listener->listenerId == listenerId) {
+                    return makeListenerStats(entry.first, *listener);
+                }
+            }
+        }
+        return ListenerStats();
+    }
 
-        std::type_index typeIndex(typeid(T));
-        auto it = listeners_.find(typeIndex);
+    // 获取所有监听器的耗时统计，按总耗时从高到低排序
+    std::vector<ListenerStats> getAllListenerStats() const {
+        std::vector<ListenerStats> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : listeners_) {
+                for (const auto& listener : entry.second) {
+                    result.push_back(makeListenerStats(entry.first, *listener));
+                }
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const ListenerStats& a, const ListenerStats& b) {
+            return a.totalTime > b.totalTime;
+        });
+        return result;
+    }
 
-        if (it != listeners_.end()) {
-            for (auto& listener : it->second) {
-                listener->onEvent(event);
+    // 清空所有监听器的耗时统计
+    void resetListenerStats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : listeners_) {
+            for (auto& listener : entry.second) {
+                listener->timings->reset();
             }
         }
     }
 
+    // 发布观察者：publish/publishBatch/request 发布的每个事件（包括被过滤丢弃的）都会在发布线程中回调一次，
+    // 在锁外调用；定时发布的事件不经过观察者。用于 EventRecorder 录制事件流
+    using PublishObserver = std::function<void(const std::shared_ptr<Event>&)>;
+
+    // 设置发布观察者（nullptr 表示移除），返回之前的观察者
+    // 移除后正在执行的回调可能还没有返回，观察者需要自己保证之后被调用是安全的
+    std::shared_ptr<const PublishObserver> setPublishObserver(std::shared_ptr<const PublishObserver> observer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(observer, publishObserver_);
+        return observer;
+    }
+
+    // 获取因没有监听器接受而在发布时丢弃的事件数量
+    size_t getFilteredEventCount() const {
+        return filteredCount_.load();
+    }
+
     // 获取待处理事件数量
     size_t getPendingEventCount() const {
         return eventCount_.load();
     }
 
+    // 配置优先级通道（见 PriorityLanes），只能在队列为空时调用，否则返回 false
+    // 例如 {{INT_MIN, 1}, {5, 3}}：优先级 >= 5 的事件与其他事件按 3 : 1 的比例处理
+    bool configurePriorityLanes(std::vector<PriorityLaneConfig> lanes) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!eventQueue_.configure(std::move(lanes))) {
+            std::cerr << "[EventSystem] 优先级通道配置失败（配置非法或队列不为空）" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 获取各优先级通道的统计信息（按 minPriority 升序）
+    std::vector<PriorityLaneStats> getPriorityLaneStats() const {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        return eventQueue_.stats();
+    }
+
     // 清空事件队列
     void clearQueue() {
         std::lock_guard<std::mutex> lock(queueMutex_);
-        while (!eventQueue_.empty()) {
-            eventQueue_.pop();
-        }
+        eventQueue_.clear();
         eventCount_.store(0);
-        std::cout << "[EventSystem] 事件队列已清空" << std::endl;
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 事件队列已清空" << std::endl;
+        }
     }
 
     // 析构函数
@@ -268,25 +1313,350 @@ public:
     }
 
 private:
-    EventSystem() : running_(false), nextListenerId_(1), eventCount_(0) {}
+    EventSystem() : running_(false), verbose_(false), nextListenerId_(1), eventCount_(0), filteredCount_(0),
+                    startTime_(std::chrono::steady_clock::now()), timers_(0), waitDeadline_(UINT64_MAX),
+                    replySlots_(new ReplySlot[REPLY_SLOTS]), nextRequestSequence_(1), pendingRequests_(0) {
+        profiler_.setSlowCallHandler([this](const EventListenerBase& listener, const Event& event,
+                                            std::chrono::nanoseconds duration) {
+            std::cerr << "[EventSystem] 慢监听器 ID=" << listener.listenerId
+                      << " 事件=" << event.getName()
+                      << " 耗时=" << duration.count() / 1000 << "us" << std::endl;
+
+            if (dynamic_cast<const SlowListenerEvent*>(&event)) {
+                return;
+            }
+            auto slowEvent = std::make_shared<SlowListenerEvent>();
+            slowEvent->listenerId = listener.listenerId;
+            slowEvent->eventName = event.getName();
+            slowEvent->duration = duration;
+            publishEvent(std::move(slowEvent));
+        });
+    }
+
+    // 等待各 Actor 邮箱中已投递的事件处理完，所有邮箱共用一个截止时间
+    // 超时的邮箱丢弃剩余事件：卡住的监听器不会让 stop 一直挂起
+    void drainActors(std::chrono::milliseconds timeout) {
+        std::vector<std::pair<size_t, std::shared_ptr<ActorMailbox>>> mailboxes;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& entry : actors_) {
+                mailboxes.emplace_back(entry.first, entry.second);
+            }
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (auto& entry : mailboxes) {
+            if (!entry.second->waitIdle(deadline)) {
+                size_t discarded = entry.second->discardPending();
+                std::cerr << "[EventSystem] Actor 监听器 ID=" << entry.first << " 在 " << timeout.count()
+                          << "ms 内没有处理完，丢弃 " << discarded << " 个待处理事件" << std::endl;
+            }
+        }
+    }
+
+    // 生成监听器统计快照（调用前必须持有 mutex_）
+    ListenerStats makeListenerStats(std::type_index typeIndex, const EventListenerBase& listener) const {
+        const ListenerTimings& timings = *listener.timings;
+        ListenerStats stats;
+        stats.listenerId = listener.listenerId;
+        stats.eventType = typeIndex.name();
+        stats.actor = actors_.count(listener.listenerId) > 0;
+        stats.invocations = timings.invocations.load(std::memory_order_relaxed);
+        stats.slowCalls = timings.slowCalls.load(std::memory_order_relaxed);
+        stats.totalTime = std::chrono::nanoseconds(timings.totalNs.load(std::memory_order_relaxed));
+        stats.maxTime = std::chrono::nanoseconds(timings.maxNs.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < ListenerTimings::BUCKETS; ++i) {
+            stats.histogram[i] = timings.histogram[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    // 注册监听器，带字段相等过滤器的同时编入字段索引（调用前必须持有 mutex_）
+    void addListenerLocked(std::type_index typeIndex, const std::shared_ptr<EventListenerBase>& listener) {
+        listeners_[typeIndex].push_back(listener);
+
+        auto key = listener->indexKey();
+        if (!key) {
+            return;
+        }
+
+        auto& indexes = fieldIndexes_[typeIndex];
+        auto it = std::find_if(indexes.begin(), indexes.end(), [&key](const FieldIndex& index) {
+            return index.field->sameField(*key);
+        });
+        if (it == indexes.end()) {
+            indexes.push_back(FieldIndex{key, {}});
+            it = std::prev(indexes.end());
+        }
+        it->buckets[key->valueHash].push_back(listener);
+        listener->indexed = true;
+    }
+
+    // 从字段索引中移除监听器（调用前必须持有 mutex_）
+    void removeFromIndexLocked(std::type_index typeIndex, const std::shared_ptr<EventListenerBase>& listener) {
+        if (!listener->indexed) {
+            return;
+        }
+        auto typeIt = fieldIndexes_.find(typeIndex);
+        if (typeIt == fieldIndexes_.end()) {
+            return;
+        }
+
+        auto key = listener->indexKey();
+        auto& indexes = typeIt->second;
+        for (auto it = indexes.begin(); it != indexes.end(); ++it) {
+            if (!it->field->sameField(*key)) {
+                continue;
+            }
+            auto bucket = it->buckets.find(key->valueHash);
+            if (bucket != it->buckets.end()) {
+                auto& list = bucket->second;
+                list.erase(std::remove(list.begin(), list.end(), listener), list.end());
+                if (list.empty()) {
+                    it->buckets.erase(bucket);
+                }
+            }
+            if (it->buckets.empty()) {
+                indexes.erase(it);
+            }
+            break;
+        }
+        if (indexes.empty()) {
+            fieldIndexes_.erase(typeIt);
+        }
+    }
+
+    // 按过滤器选出需要该事件的监听器（调用前必须持有 mutex_）
+    // 没有字段索引的监听器逐个求值；字段索引按事件字段值的哈希只取出一个桶，再用完整的过滤器确认
+    void collectTargetsLocked(const Event& event, std::vector<std::shared_ptr<EventListenerBase>>& targets) {
+        std::type_index typeIndex = event.getType();
+
+        auto it = listeners_.find(typeIndex);
+        if (it == listeners_.end()) {
+            return;
+        }
+        size_t first = targets.size();
+        for (auto& listener : it->second) {
+            if (!listener->indexed && listener->accepts(event)) {
+                targets.push_back(listener);
+            }
+        }
+
+        auto typeIt = fieldIndexes_.find(typeIndex);
+        if (typeIt == fieldIndexes_.end()) {
+            return;
+        }
+        size_t unindexed = targets.size();
+        for (auto& index : typeIt->second) {
+            size_t hash;
+            if (!index.field->hashOf(event, hash)) {
+                continue;
+            }
+            auto bucket = index.buckets.find(hash);
+            if (bucket == index.buckets.end()) {
+                continue;
+            }
+            for (auto& listener : bucket->second) {
+                if (listener->accepts(event)) {
+                    targets.push_back(listener);
+                }
+            }
+        }
+
+        // 监听器按订阅顺序调用：ID 单调递增，命中索引时按 ID 把两部分重新排好
+        if (targets.size() > unindexed) {
+            std::sort(targets.begin() + first, targets.end(),
+                      [](const std::shared_ptr<EventListenerBase>& a, const std::shared_ptr<EventListenerBase>& b) {
+                          return a->listenerId < b->listenerId;
+                      });
+        }
+    }
+
+    // 时间轮的 tick：构造以来的毫秒数
+    uint64_t currentTick() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime_).count());
+    }
+
+    // 时长向上取整为 tick，保证不会提前发布
+    template<typename Rep, typename Period>
+    static uint64_t toTicks(std::chrono::duration<Rep, Period> duration) {
+        if (duration.count() <= 0) {
+            return 0;
+        }
+        return static_cast<uint64_t>(std::chrono::ceil<std::chrono::milliseconds>(duration).count());
+    }
+
+    // 把定时事件加入时间轮
+    TimerId schedule(uint64_t expireTick, uint64_t intervalTicks, std::shared_ptr<Event> event) {
+        return scheduleCallback(expireTick, intervalTicks, [this, event] {
+            eventQueue_.push(EventQueueItem(event));
+            eventCount_.fetch_add(1);
+        });
+    }
+
+    // 把回调加入时间轮，只在新回调早于处理线程当前的唤醒时间时才唤醒它
+    // 回调在 processEvents 中持有 queueMutex_ 时调用
+    TimerId scheduleCallback(uint64_t expireTick, uint64_t intervalTicks, asyncio::TimerWheel::Callback callback) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        TimerId id = timers_.add(expireTick, intervalTicks, std::move(callback));
+        if (expireTick < waitDeadline_) {
+            cv_.notify_one();
+        }
+        return id;
+    }
+
+    // 发布事件，返回 false 表示没有监听器接受而被丢弃
+    bool publishEvent(std::shared_ptr<Event> event) {
+        // 发布时按过滤器选出监听器，没有监听器需要的事件直接丢弃
+        std::vector<std::shared_ptr<EventListenerBase>> targets;
+        std::shared_ptr<const PublishObserver> observer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            observer = publishObserver_;
+            collectTargetsLocked(*event, targets);
+        }
+        if (observer) {
+            (*observer)(event);
+        }
+        if (targets.empty()) {
+            filteredCount_.fetch_add(1);
+            return false;
+        }
+
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 发布事件: " << event->getName()
+                      << " 优先级=" << event->priority << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            eventQueue_.push(EventQueueItem(std::move(event), std::move(targets)));
+            // 原子执行：先返回 count 旧值（0），再将 count 加 1（最终 count=1）
+            eventCount_.fetch_add(1);
+        }
+
+        // 唤醒处理线程
+        cv_.notify_one();
+        return true;
+    }
+
+    // 为等待中的请求加入超时定时器，定时器ID在 queueMutex_ 内写入槽位：
+    // 定时器只会在处理线程持有 queueMutex_ 时触发，触发前槽位中一定已经有它的ID
+    void armRequestTimeout(uint64_t correlationId, uint64_t expireTick) {
+        ReplySlot& slot = replySlots_[correlationId & (REPLY_SLOTS - 1)];
+
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        TimerId id = timers_.add(expireTick, 0, [this, correlationId] {
+            // 在持有 queueMutex_ 的处理线程中执行，定时器已经触发，不需要再取消
+            completeRequest(correlationId, nullptr,
+                            std::make_exception_ptr(RequestError("request timed out")), false);
+        });
+        slot.timer.store(id, std::memory_order_relaxed);
+        if (expireTick < waitDeadline_) {
+            cv_.notify_one();
+        }
+    }
+
+    // 在应答表中占用一个槽位，成功时 pending 移入槽位并返回关联ID，表满时返回 0
+    // 关联ID = (序号 << REPLY_SLOT_BITS) | 槽位下标，应答时直接定位槽位，不需要加锁或查找
+    uint64_t registerRequest(std::unique_ptr<PendingReplyBase>& pending) {
+        uint64_t sequence = nextRequestSequence_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t probe = 0; probe < REPLY_SLOTS; ++probe) {
+            size_t index = static_cast<size_t>(sequence + probe) & (REPLY_SLOTS - 1);
+            ReplySlot& slot = replySlots_[index];
+
+            uint64_t expected = 0;
+            if (slot.id.compare_exchange_strong(expected, ReplySlot::BUSY, std::memory_order_acquire)) {
+                slot.pending = std::move(pending);
+                pendingRequests_.fetch_add(1);
+                uint64_t correlationId = (sequence << REPLY_SLOT_BITS) | index;
+                // release：应答方看到关联ID时一定能看到 pending
+                slot.id.store(correlationId, std::memory_order_release);
+                return correlationId;
+            }
+        }
+        return 0;
+    }
+
+    // 完成请求（应答、失败或超时），返回 false 表示请求已经完成过
+    // cancelTimer 为 true 时取消还没触发的超时定时器（需要获取 queueMutex_，超时回调中传 false）
+    bool completeRequest(uint64_t correlationId, std::shared_ptr<Event> response, std::exception_ptr error,
+                         bool cancelTimer = true) {
+        if (correlationId == 0) {
+            return false;
+        }
+
+        ReplySlot& slot = replySlots_[correlationId & (REPLY_SLOTS - 1)];
+        uint64_t expected = correlationId;
+        if (!slot.id.compare_exchange_strong(expected, ReplySlot::BUSY, std::memory_order_acquire)) {
+            return false;
+        }
+        std::unique_ptr<PendingReplyBase> pending = std::move(slot.pending);
+        TimerId timer = slot.timer.exchange(asyncio::TimerWheel::INVALID_TIMER, std::memory_order_relaxed);
+        slot.id.store(0, std::memory_order_release);
+        pendingRequests_.fetch_sub(1);
+
+        // 应答后不留下到期才失效的定时器，频繁请求时时间轮不会堆积
+        if (cancelTimer && timer != asyncio::TimerWheel::INVALID_TIMER) {
+            cancelScheduled(timer);
+        }
+
+        // 在槽位释放之后唤醒等待者
+        if (error) {
+            pending->fail(std::move(error));
+        } else {
+            pending->fulfill(std::move(response));
+        }
+        return true;
+    }
+
+    // 把到期的定时事件放入队列（调用前必须持有 queueMutex_）
+    void fireDueTimersLocked() {
+        if (timers_.size() == 0) {
+            return;
+        }
+        timers_.advance(currentTick(), expiredTimers_);
+        for (auto& callback : expiredTimers_) {
+            callback();
+        }
+        expiredTimers_.clear();
+    }
 
     // 事件处理线程函数
     void processEvents() {
-        std::cout << "[EventSystem] 事件处理线程开始运行" << std::endl;
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 事件处理线程开始运行" << std::endl;
+        }
 
         while (running_.load()) {
             std::shared_ptr<Event> event;
+            std::vector<std::shared_ptr<EventListenerBase>> targets;
+            bool routed = false;
 
             {
                 std::unique_lock<std::mutex> lock(queueMutex_);
 
-                // 等待事件或停止信号，解决虚假唤醒问题
-                // 1.加锁后检查当事件队列不空或停止时，立即返回处理
-                // 2.如果事件队列空且未停止，释放锁后等待 notify_one 被唤醒
-                // 3.被唤醒后再次检查事件队列是否为空，若为空则继续等待
-                cv_.wait(lock, [this] {
-                    return !eventQueue_.empty() || !running_.load();
-                });
+                // 等待事件、定时事件到期或停止信号，解决虚假唤醒问题
+                // 1.加锁后先把到期的定时事件放入队列，事件队列不空或停止时，立即返回处理
+                // 2.有定时事件时最多等到时间轮的下一个到期时刻，没有时等待 notify_one 被唤醒
+                // 3.被唤醒后重新检查，若仍然无事可做则继续等待
+                while (true) {
+                    fireDueTimersLocked();
+                    if (!eventQueue_.empty() || !running_.load()) {
+                        break;
+                    }
+
+                    uint64_t next;
+                    if (timers_.next_expiry(next)) {
+                        waitDeadline_ = next;
+                        cv_.wait_until(lock, startTime_ + std::chrono::milliseconds(next));
+                    } else {
+                        waitDeadline_ = UINT64_MAX;
+                        cv_.wait(lock);
+                    }
+                    waitDeadline_ = 0;
+                }
 
                 // 确保退出前处理完所有事件
                 if (!running_.load() && eventQueue_.empty()) {
@@ -294,38 +1664,40 @@ private:
                 }
 
                 if (!eventQueue_.empty()) {
-                    event = eventQueue_.top().event;//获取堆顶元素
-                    eventQueue_.pop();
+                    EventQueueItem item = eventQueue_.pop();
+                    event = std::move(item.event);
+                    routed = item.routed;
+                    targets = std::move(item.targets);
                     eventCount_.fetch_sub(1);
                 }
             }
 
             // 分发事件
             if (event) {
-                // 复制监听器列表（避免在持有锁时调用回调导致死锁）
+                // 发布时已经选好了监听器；定时发布的事件在这里按过滤器选择
+                // 选出的监听器保存在局部列表中，在锁外调用回调
                 // 如果在持有锁 mutex_ 时直接调用事件监听回调
                 // 事件监听回调可能还会执行发布事件、注册监听回调等操作尝试获取 mutex_ 导致死锁
-                std::vector<std::shared_ptr<EventListenerBase>> listenersCopy;
-
-                {
+                if (!routed) {
                     std::lock_guard<std::mutex> lock(mutex_);
+                    collectTargetsLocked(*event, targets);
+                }  // 锁在这里释放
 
-                    std::type_index typeIndex = event->getType();
-                    auto it = listeners_.find(typeIndex);
-
-                    if (it != listeners_.end()) {
+                if (!targets.empty()) {
+                    if (isVerbose()) {
                         std::cout << "[EventSystem] 处理事件: " << event->getName()
-                                  << " 监听器数量=" << it->second.size() << std::endl;
-
-                        // 复制监听器列表然后释放锁，避免在持有锁时调用回调导致死锁
-                        listenersCopy = it->second;
+                                  << " 监听器数量=" << targets.size() << std::endl;
                     }
-                }  // 锁在这里释放
+                }
 
                 // 在锁外调用监听器回调（安全，不会死锁）
-                for (auto& listener : listenersCopy) {
+                for (auto& listener : targets) {
+                    // 入队之后被注销的监听器不再接收
+                    if (!listener->active.load()) {
+                        continue;
+                    }
                     try {
-                        listener->onEvent(event);
+                        profiler_.invoke(*listener, event);
                     } catch (const std::exception& e) {
                         std::cerr << "[EventSystem] 监听器异常: " << e.what() << std::endl;
                     }
@@ -333,27 +1705,65 @@ private:
             }
         }
 
-        std::cout << "[EventSystem] 事件处理线程结束" << std::endl;
+        if (isVerbose()) {
+            std::cout << "[EventSystem] 事件处理线程结束" << std::endl;
+        }
     }
 
     // 监听器映射表（事件类型 -> 监听器列表）
     std::unordered_map<std::type_index, std::vector<std::shared_ptr<EventListenerBase>>> listeners_;
 
-    // 事件优先级队列
-    std::priority_queue<EventQueueItem> eventQueue_;
+    // 事件队列（按优先级分通道，DRR 调度）
+    PriorityLanes eventQueue_;
 
     // 线程同步，允许监听器和事件发布并发
-    std::mutex mutex_;           // 保护监听器列表
-    std::mutex queueMutex_;      // 保护事件队列
+    mutable std::mutex mutex_;   // 保护监听器列表
+    mutable std::mutex queueMutex_; // 保护事件队列和时间轮
     std::condition_variable cv_; // 条件变量
     std::thread workerThread_;   // 工作线程
     std::atomic<bool> running_;  // 运行状态，原子读写
+    std::atomic<bool> verbose_;  // 是否输出运行日志
 
     // 监听器ID生成器
     size_t nextListenerId_;
 
     // 待处理事件计数
     std::atomic<size_t> eventCount_;
+
+    // 字段相等过滤器的索引（事件类型 -> 各字段的值哈希桶），由 mutex_ 保护
+    struct FieldIndex {
+        std::shared_ptr<FilterIndexKey> field;
+        std::unordered_map<size_t, std::vector<std::shared_ptr<EventListenerBase>>> buckets;
+    };
+    std::unordered_map<std::type_index, std::vector<FieldIndex>> fieldIndexes_;
+
+    // 发布时因没有监听器接受而丢弃的事件数量
+    std::atomic<size_t> filteredCount_;
+
+    // 延迟/周期发布的时间轮（1 tick = 1ms），由 queueMutex_ 保护
+    std::chrono::steady_clock::time_point startTime_;
+    asyncio::TimerWheel timers_;
+    std::vector<asyncio::TimerWheel::Callback> expiredTimers_;
+    uint64_t waitDeadline_;      // 处理线程当前等待到的 tick（UINT64_MAX 表示无限等待，0 表示没有在等待）
+
+    // 请求/应答表（无锁，槽位按关联ID的低位定位）
+    static constexpr size_t REPLY_SLOT_BITS = 12;
+    static constexpr size_t REPLY_SLOTS = size_t(1) << REPLY_SLOT_BITS;
+    std::unique_ptr<ReplySlot[]> replySlots_;
+    std::atomic<uint64_t> nextRequestSequence_;
+    std::atomic<size_t> pendingRequests_;
+
+    // 发布观察者，由 mutex_ 保护（发布时在锁内复制一份，在锁外调用）
+    std::shared_ptr<const PublishObserver> publishObserver_;
+
+    // 监听器耗时统计与慢调用检测（邮箱持有它的引用，必须在 actorPool_ 之前声明）
+    ListenerProfiler profiler_;
+
+    // Actor 监听器的邮箱（监听器ID -> 邮箱），由 mutex_ 保护
+    std::unordered_map<size_t, std::shared_ptr<ActorMailbox>> actors_;
+
+    // Actor 模式的共享线程池（最后声明，析构时最先停止，邮箱处理任务不会访问已销毁的成员）
+    std::unique_ptr<CodeGuide::ThreadPool> actorPool_;
 };
 
 #endif // EVENT_SYSTEM_H
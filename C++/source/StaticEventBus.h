@@ -0,0 +1,335 @@
+#ifndef STATIC_EVENT_BUS_H
+#define STATIC_EVENT_BUS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "epoch_reclaim.h"
+
+// ============================================================================
+// 编译期事件总线 - 事件类型集合在编译期确定
+// ============================================================================
+//
+// 与 EventSystem 的区别：
+// 1. 不需要 std::type_index 映射：每种事件类型一个监听器数组，放在 std::tuple 中，
+//    publish<T> / dispatch<T> 在编译期就确定了要访问的数组
+// 2. 事件不需要继承 Event，也没有虚函数 onEvent：异步队列中存放 std::variant<Events...>，
+//    处理线程用 std::visit 跳转到对应类型的分发函数
+// 3. 监听器不经过 std::function：每个监听器保存为 {对象指针, 函数指针}，函数指针是按监听器
+//    类型实例化的模板函数，监听器的 operator() 在这个模板函数中内联展开；
+//    用 subscribe<T, Fn>() 注册的自由函数连对象指针都不需要
+//
+// 限制：监听器在运行时注册，类型不属于总线的类型参数，所以 dispatch 里每个监听器仍是一次
+// 经函数指针的间接调用，编译器不能把监听器内联进分发循环（与 std::function 的开销相当，
+// 省掉的是它的类型擦除包装和小对象判断）；需要完全内联的场景直接在调用处调用处理函数
+//
+// 异步语义与 EventSystem 一致：publish 入队后由处理线程分发，dispatch 同步分发，
+// stop() 时处理完已入队的事件；队列按发布顺序处理（事件没有 priority 字段）。
+//
+// 监听器数组写时复制，分发线程在纪元临界区（CodeGuide::EpochGuard）内读取数组；
+// 被替换的数组交给总线自己的 EpochDomain 退休，没有分发线程还在使用时释放，
+// 其中拥有的、已注销的监听器对象随之析构，频繁注册/注销时内存不会一直增长。
+//
+// 用法：
+//   struct Tick { int n; };
+//   struct Quit {};
+//   StaticEventBus<Tick, Quit> bus;
+//   bus.subscribe<Tick>([](const Tick& t) { ... });
+//   bus.start();
+//   bus.publish(Tick{1});
+
+template<typename... Events>
+class StaticEventBus {
+    static_assert(sizeof...(Events) > 0, "StaticEventBus needs at least one event type");
+
+    // 编译期查找 T 在 Events... 中的下标
+    template<typename T, typename... List>
+    struct IndexOf;
+
+    template<typename T, typename... Rest>
+    struct IndexOf<T, T, Rest...> : std::integral_constant<size_t, 0> {};
+
+    template<typename T, typename First, typename... Rest>
+    struct IndexOf<T, First, Rest...> : std::integral_constant<size_t, 1 + IndexOf<T, Rest...>::value> {};
+
+    template<typename T, typename... List>
+    struct Count : std::integral_constant<size_t, (std::is_same<T, List>::value + ... + 0)> {};
+
+    static_assert(((Count<Events, Events...>::value == 1) && ...),
+                  "StaticEventBus event types must be distinct");
+
+public:
+    // 事件类型是否属于该总线
+    template<typename T>
+    static constexpr bool contains = Count<T, Events...>::value == 1;
+
+    // 事件类型的编译期下标
+    template<typename T>
+    static constexpr size_t indexOf() {
+        static_assert(contains<T>, "event type is not registered in this StaticEventBus");
+        return IndexOf<T, Events...>::value;
+    }
+
+    StaticEventBus() : running_(false), nextListenerId_(1), eventCount_(0) {
+        std::apply([](auto&... lists) { (lists.store(nullptr), ...); }, slots_);
+    }
+
+    ~StaticEventBus() {
+        stop();
+        // 调用者保证此时没有线程再分发，当前数组直接释放，已退休的数组由 epoch_ 析构时释放
+        std::apply([](auto&... lists) { (delete lists.load(std::memory_order_relaxed), ...); }, slots_);
+    }
+
+    StaticEventBus(const StaticEventBus&) = delete;
+    StaticEventBus& operator=(const StaticEventBus&) = delete;
+
+    // 启动异步事件处理线程
+    void start() {
+        if (running_.load()) {
+            std::cout << "[StaticEventBus] 已经在运行中" << std::endl;
+            return;
+        }
+
+        running_.store(true);
+        workerThread_ = std::thread(&StaticEventBus::processEvents, this);
+    }
+
+    // 停止异步事件处理线程，已入队的事件处理完后线程退出
+    void stop() {
+        if (!running_.load()) {
+            return;
+        }
+
+        running_.store(false);
+        cv_.notify_all();
+        if (workerThread_.joinable()) {
+            workerThread_.join();
+        }
+    }
+
+    // 注册监听器（拥有监听器对象），L 是可调用对象：void(const T&)
+    // L 作为模板参数保留完整类型，operator() 在 invokeListener<T, L> 中内联
+    template<typename T, typename L>
+    size_t subscribe(L&& listener) {
+        using Listener = std::decay_t<L>;
+        static_assert(std::is_invocable<Listener&, const T&>::value,
+                      "listener must be callable with const T&");
+
+        auto owner = std::make_shared<Listener>(std::forward<L>(listener));
+        Listener* object = owner.get();
+        return addSlot<T>(Slot<T>{std::move(owner), object, &invokeListener<T, Listener>, 0});
+    }
+
+    // 注册监听器（不拥有监听器对象，调用者保证注销前对象有效）
+    template<typename T, typename L>
+    size_t subscribeRef(L& listener) {
+        static_assert(std::is_invocable<L&, const T&>::value,
+                      "listener must be callable with const T&");
+        return addSlot<T>(Slot<T>{nullptr, &listener, &invokeListener<T, L>, 0});
+    }
+
+    // 注册自由函数或静态成员函数，函数在编译期确定：bus.subscribe<Tick, &onTick>()
+    template<typename T, void (*Fn)(const T&)>
+    size_t subscribe() {
+        return addSlot<T>(Slot<T>{nullptr, nullptr, &invokeFunction<T, Fn>, 0});
+    }
+
+    // 注销监听器
+    template<typename T>
+    bool unsubscribe(size_t listenerId) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        auto& current = std::get<indexOf<T>()>(slots_);
+        const std::vector<Slot<T>>* list = current.load(std::memory_order_relaxed);
+        if (!list) {
+            return false;
+        }
+
+        // 写时复制：正在分发的线程仍然持有旧数组，不受影响
+        auto updated = std::make_unique<std::vector<Slot<T>>>(*list);
+        auto it = std::remove_if(updated->begin(), updated->end(),
+            [listenerId](const Slot<T>& slot) { return slot.id == listenerId; });
+        if (it == updated->end()) {
+            return false;
+        }
+        updated->erase(it, updated->end());
+        retireList<T>(swapList<T>(std::move(updated), lock));
+        return true;
+    }
+
+    // 等待已注销的监听器对象和被替换的数组全部释放（不能在监听器中调用）
+    // 有分发线程停在监听器里时会一直等待；等待期间不持有 mutex_，不影响其他线程注册/注销
+    void synchronize() {
+        epoch_.synchronize();
+    }
+
+    // 发布事件（异步），事件按值入队
+    template<typename T>
+    void publish(T&& event) {
+        using Type = std::decay_t<T>;
+        static_assert(contains<Type>, "event type is not registered in this StaticEventBus");
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            queue_.emplace_back(std::in_place_index<indexOf<Type>()>, std::forward<T>(event));
+            eventCount_.fetch_add(1);
+        }
+        cv_.notify_one();
+    }
+
+    // 立即分发事件（同步）
+    template<typename T>
+    void dispatch(const T& event) {
+        static_assert(contains<T>, "event type is not registered in this StaticEventBus");
+
+        // 无锁读取当前数组：临界区内被替换的旧数组不会被释放，读到旧指针也是安全的
+        CodeGuide::EpochGuard guard(epoch_);
+        const std::vector<Slot<T>>* list = std::get<indexOf<T>()>(slots_).load(std::memory_order_acquire);
+        if (!list) {
+            return;
+        }
+
+        for (const auto& slot : *list) {
+            slot.invoke(slot.object, event);
+        }
+    }
+
+    // 某种事件的监听器数量
+    template<typename T>
+    size_t getListenerCount() const {
+        CodeGuide::EpochGuard guard(epoch_);
+        const std::vector<Slot<T>>* list = std::get<indexOf<T>()>(slots_).load(std::memory_order_acquire);
+        return list ? list->size() : 0;
+    }
+
+    // 获取待处理事件数量
+    size_t getPendingEventCount() const {
+        return eventCount_.load();
+    }
+
+private:
+    // 一个监听器：对象指针 + 按监听器类型实例化的调用函数
+    template<typename T>
+    struct Slot {
+        std::shared_ptr<void> owner;            // 拥有的监听器对象（subscribeRef/函数监听器为空）
+        void* object;
+        void (*invoke)(void*, const T&);
+        size_t id;
+    };
+
+    template<typename T>
+    using SlotList = std::atomic<const std::vector<Slot<T>>*>;
+
+    template<typename T, typename L>
+    static void invokeListener(void* object, const T& event) {
+        (*static_cast<L*>(object))(event);
+    }
+
+    template<typename T, void (*Fn)(const T&)>
+    static void invokeFunction(void*, const T& event) {
+        Fn(event);
+    }
+
+    template<typename T>
+    size_t addSlot(Slot<T> slot) {
+        static_assert(contains<T>, "event type is not registered in this StaticEventBus");
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        slot.id = nextListenerId_++;
+        size_t id = slot.id;
+
+        const std::vector<Slot<T>>* list = std::get<indexOf<T>()>(slots_).load(std::memory_order_relaxed);
+        auto updated = list ? std::make_unique<std::vector<Slot<T>>>(*list)
+                            : std::make_unique<std::vector<Slot<T>>>();
+        updated->push_back(std::move(slot));
+        retireList<T>(swapList<T>(std::move(updated), lock));
+        return id;
+    }
+
+    // 发布新的监听器数组并释放 mutex_（只有替换本身需要和其他注册/注销串行），返回旧数组
+    template<typename T>
+    const std::vector<Slot<T>>* swapList(std::unique_ptr<std::vector<Slot<T>>> updated,
+                                         std::unique_lock<std::mutex>& lock) {
+        const std::vector<Slot<T>>* old = std::get<indexOf<T>()>(slots_).exchange(updated.release(),
+                                                                                 std::memory_order_acq_rel);
+        lock.unlock();
+        return old;
+    }
+
+    // 旧数组退休，宽限期过后释放（不持有 mutex_：退休超过上限时可能等待读者，
+    // 回收时会析构已注销的监听器对象，这些都不应该挡住其他线程注册/注销）
+    // 每次替换都顺带尝试推进纪元并回收，上一次替换下来的数组通常在下一次注册/注销时释放
+    template<typename T>
+    void retireList(const std::vector<Slot<T>>* old) {
+        if (old) {
+            epoch_.retire(const_cast<std::vector<Slot<T>>*>(old), [](void* ptr, void*) {
+                delete static_cast<std::vector<Slot<T>>*>(ptr);
+            });
+            epoch_.try_advance();
+            epoch_.collect();
+        }
+    }
+
+    // 事件处理线程函数
+    void processEvents() {
+        while (true) {
+            // variant 的第一个类型不一定可以默认构造，用 optional 延迟构造
+            std::optional<std::variant<Events...>> event;
+
+            {
+                std::unique_lock<std::mutex> lock(queueMutex_);
+                cv_.wait(lock, [this] {
+                    return !queue_.empty() || !running_.load();
+                });
+
+                // 确保退出前处理完所有事件
+                if (queue_.empty()) {
+                    break;
+                }
+
+                event.emplace(std::move(queue_.front()));
+                queue_.pop_front();
+                eventCount_.fetch_sub(1);
+            }
+
+            // std::visit 按 variant 的下标跳转，分发函数在编译期按类型实例化
+            std::visit([this](const auto& typed) {
+                try {
+                    dispatch(typed);
+                } catch (const std::exception& e) {
+                    std::cerr << "[StaticEventBus] 监听器异常: " << e.what() << std::endl;
+                }
+            }, *event);
+        }
+    }
+
+    // 每种事件类型一个监听器数组（写时复制，分发时在纪元临界区内做一次 acquire 读取）
+    // 替换下来的数组和其中拥有的监听器对象退休到 epoch_，不需要在分发路径上维护引用计数
+    mutable CodeGuide::EpochDomain epoch_;
+    std::tuple<SlotList<Events>...> slots_;
+    std::mutex mutex_;                      // 串行化注册/注销
+
+    // 异步队列
+    std::deque<std::variant<Events...>> queue_;
+    std::mutex queueMutex_;
+    std::condition_variable cv_;
+    std::thread workerThread_;
+    std::atomic<bool> running_;
+
+    size_t nextListenerId_;
+    std::atomic<size_t> eventCount_;
+};
+
+#endif // STATIC_EVENT_BUS_H
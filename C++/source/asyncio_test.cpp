@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "async_logger.hpp"
+#include "io_uring_wrapper.hpp"
+#include "wal.hpp"
+
+// System/src 中依赖 io_uring 的组件：预写日志、异步日志、事件循环的自旋模式
+
+// 轮询等待条件成立，超时视为测试失败直接退出（不依赖 assert，NDEBUG 下同样等待）
+template<typename Predicate>
+void wait_until(Predicate predicate, const char *what, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            std::cerr << "[ERROR] 等待超时: " << what << std::endl;
+            std::abort();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// 第 thread 个线程的第 seq 条记录，长度各不相同，跨越多个段
+std::string wal_record(int thread, int seq) {
+    std::string data = "t" + std::to_string(thread) + "-" + std::to_string(seq) + "-";
+    data.append(100 + (seq * 37 + thread * 11) % 900, static_cast<char>('a' + seq % 26));
+    return data;
+}
+
+// 多线程写入 -> 停止 -> recover 按 LSN 顺序读回全部记录；改坏一个帧后 CRC 校验在那里截断
+void wal_round_trip_test() {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "codeguide_wal";
+    std::filesystem::remove_all(directory);
+
+    asyncio::WalConfig config;
+    config.directory = directory.string();
+    config.segment_size = 64 * 1024;
+
+    constexpr int THREADS = 4;
+    constexpr int RECORDS = 50;
+    std::mutex written_mutex;
+    std::vector<std::pair<asyncio::WriteAheadLog::Lsn, std::string>> written;
+    asyncio::WalStats stats;
+    {
+        asyncio::WriteAheadLog wal(config);
+        wal.start();
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < THREADS; ++t) {
+            writers.emplace_back([&, t] {
+                for (int i = 0; i < RECORDS; ++i) {
+                    std::string data = wal_record(t, i);
+                    asyncio::WriteAheadLog::Lsn lsn = wal.append(data).get();
+                    std::lock_guard<std::mutex> lock(written_mutex);
+                    written.emplace_back(lsn, std::move(data));
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+        assert(wal.durable_lsn() == THREADS * RECORDS);
+        wal.stop();
+        stats = wal.stats();
+    }
+    std::sort(written.begin(), written.end());
+
+    // 段文件创建时整段写 0，大小固定为 segment_size
+    std::vector<std::filesystem::path> segments;
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        segments.push_back(entry.path());
+        assert(std::filesystem::file_size(entry.path()) == config.segment_size);
+    }
+    std::sort(segments.begin(), segments.end());
+    assert(segments.size() > 1 && segments.size() == stats.segments);
+
+    std::vector<std::pair<asyncio::WriteAheadLog::Lsn, std::string>> recovered;
+    asyncio::WriteAheadLog::Lsn last = asyncio::WriteAheadLog::recover(config.directory,
+        [&recovered](asyncio::WriteAheadLog::Lsn lsn, std::string_view data) {
+            recovered.emplace_back(lsn, std::string(data));
+        });
+    bool intact = last == THREADS * RECORDS && recovered == written;
+
+    // 改掉最后一个段第一条记录的一个数据字节，recover 在 CRC 不匹配处停止，只读回前面的段
+    const std::filesystem::path &tail = segments.back();
+    asyncio::WriteAheadLog::Lsn tail_first = std::stoull(tail.stem().string());
+    {
+        std::fstream file(tail, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(asyncio::WriteAheadLog::FRAME_HEADER_SIZE);
+        char byte = static_cast<char>(file.get());
+        file.seekp(asyncio::WriteAheadLog::FRAME_HEADER_SIZE);
+        file.put(static_cast<char>(byte ^ 0x5A));
+    }
+    size_t after_corruption = 0;
+    asyncio::WriteAheadLog::Lsn corrupted_last = asyncio::WriteAheadLog::recover(config.directory,
+        [&after_corruption](asyncio::WriteAheadLog::Lsn, std::string_view) { after_corruption++; });
+
+    std::cout << "[wal] 写入 " << written.size() << " 条, 组提交 " << stats.commits << " 次, 段 " << stats.segments
+              << " 个, 读回一致: " << (intact ? "是" : "否") << ", 改坏后读回 " << after_corruption << " 条" << std::endl;
+    assert(intact);
+    assert(corrupted_last == tail_first - 1 && after_corruption == tail_first - 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+// 多个线程写日志，flush 后文件中每条日志都按格式串格式化
+void async_logger_test() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "codeguide_async.log";
+    std::filesystem::remove(path);
+
+    asyncio::AsyncLoggerConfig config;
+    config.path = path.string();
+    constexpr int THREADS = 2;
+    constexpr int LINES = 100;
+    uint64_t dropped = 0;
+    {
+        asyncio::AsyncLogger logger(config);
+        logger.start();
+        std::vector<std::thread> writers;
+        for (int t = 0; t < THREADS; ++t) {
+            writers.emplace_back([t] {
+                const char *tag = "ok";
+                for (int i = 0; i < LINES; ++i) {
+                    ASYNC_LOG_INFO("worker={} seq={} tag={}", t, i, tag);
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+        logger.flush();
+        dropped = logger.dropped_count();
+        logger.stop();
+    }
+
+    std::ifstream file(path);
+    std::string line;
+    int lines = 0;
+    bool found = false;
+    while (std::getline(file, line)) {
+        if (line.find("worker=") != std::string::npos) {
+            lines++;
+        }
+        found = found || (line.find("INFO") != std::string::npos &&
+                          line.find("worker=1 seq=42 tag=ok") != std::string::npos);
+    }
+
+    std::cout << "[async_logger] 写入 " << lines << " 行, 丢弃 " << dropped << " 条" << std::endl;
+    assert(dropped == 0 && lines == THREADS * LINES && found);
+
+    std::filesystem::remove(path);
+}
+
+// 自旋模式下投递的任务和定时器都被执行，自旋轮询计入统计
+void event_loop_busy_poll_test() {
+    asyncio::IoUring ring(64);
+    asyncio::EventLoopOptions options;
+    options.spin_budget = std::chrono::microseconds(200);
+    asyncio::EventLoop loop(ring, options);
+    loop.start();
+
+    constexpr int TASKS = 100;
+    std::atomic<int> done(0);
+    for (int i = 0; i < TASKS; ++i) {
+        loop.post([&done] { done.fetch_add(1); });
+    }
+    wait_until([&] { return done.load() == TASKS; }, "事件循环任务");
+
+    std::atomic<bool> fired(false);
+    loop.schedule_after(std::chrono::milliseconds(5), [&fired] { fired.store(true); });
+    wait_until([&] { return fired.load(); }, "事件循环定时器");
+
+    loop.stop();
+    loop.join();
+    asyncio::EventLoopStats stats = loop.stats();
+    std::cout << "[event_loop] 任务 " << stats.tasks << " 个, 自旋轮询 " << stats.spin_polls
+              << " 次, 自旋命中率 " << stats.spin_efficiency() << std::endl;
+    assert(stats.tasks >= TASKS && stats.spin_polls > 0);
+}
+
+int main() {
+    wal_round_trip_test();
+    async_logger_test();
+    event_loop_busy_poll_test();
+    return 0;
+}
@@ -0,0 +1,651 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef SOURCE_EPOCH_RECLAIM_H
+#define SOURCE_EPOCH_RECLAIM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace CodeGuide {
+
+/**
+ * 无锁数据结构的延迟释放（Safe Memory Reclamation）
+ *
+ * 无锁结构把节点从链表摘下后不能立即释放：其他线程可能刚读到这个指针、还没来得及访问。
+ * 这里实现基于纪元的回收（Epoch-Based Reclamation，EBR），并用风险指针（Hazard Pointer）兜底：
+ *
+ * 1. 读者进入临界区时把全局纪元记录到自己的线程记录中（EpochGuard），退出时清除
+ * 2. 写者摘下节点后 retire，节点按当前全局纪元放入本线程的 3 个 limbo 桶之一
+ * 3. 所有活跃线程都已观察到当前纪元时，全局纪元才能 +1；纪元 e 中退休的节点在全局纪元到达 e+2 后可以释放
+ * 4. 可能长时间阻塞的读者改用 HazardGuard 逐个保护指针，不占用纪元，也就不会卡住其他线程的回收
+ *
+ * 垃圾总量有界：
+ * - 每个线程退休数达到 collect_threshold 时主动尝试推进纪元并回收
+ * - 待回收数超过 max_pending 时写者等待纪元推进（背压），而不是无限堆积
+ * - 同一个线程连续 stall_rounds 次阻止纪元推进时记为停滞，并回调通知；
+ *   停滞期间写者不再等待（否则一个卡住的读者会拖住所有写者），节点暂时堆积，
+ *   读者退出临界区后第一次推进纪元就会全部释放。会长时间停留在临界区的读者应改用 HazardGuard
+ *
+ * 使用示例：
+ * @code
+ * EpochDomain& domain = EpochDomain::global();
+ *
+ * // 读者
+ * {
+ *     EpochGuard guard(domain);
+ *     Node* node = head.load(std::memory_order_acquire);
+ *     ... // 临界区内可以安全访问 node
+ * }
+ *
+ * // 写者：摘下节点后退休，释放回内存池
+ * domain.retire_to(pool, old_node);
+ * @endcode
+ */
+
+// ============================================================================
+// 配置与统计
+// ============================================================================
+
+struct EpochConfig {
+    size_t collect_threshold = 64;      // 每个线程退休多少个节点后尝试回收
+    size_t max_pending = 4096;          // 每个线程待回收节点的上限，超过后写者等待
+    uint32_t stall_rounds = 1024;       // 同一线程连续阻止推进多少次判定为停滞
+    bool block_on_overflow = true;      // 超过上限时是否等待（检测到读者停滞后不再等待），false 时只计数
+};
+
+struct EpochStats {
+    uint64_t global_epoch = 0;          // 当前全局纪元
+    uint64_t retired = 0;               // 累计退休的节点数
+    uint64_t reclaimed = 0;             // 累计释放的节点数
+    uint64_t pending = 0;               // 等待释放的节点数（retired - reclaimed）
+    uint64_t advance_failures = 0;      // 因读者未跟上而推进失败的次数
+    uint64_t hazard_deferred = 0;       // 因风险指针保护而推迟释放的次数
+    uint64_t stall_events = 0;          // 检测到读者停滞的次数
+    uint64_t overflow_waits = 0;        // 写者因超过上限而等待的次数
+    uint64_t overflow_bypassed = 0;     // 读者停滞导致写者放弃等待的次数
+    size_t thread_records = 0;          // 线程记录数量
+};
+
+// ============================================================================
+// 回收域
+// ============================================================================
+
+class EpochDomain {
+public:
+    static constexpr size_t HAZARD_SLOTS = 4;   // 每个线程的风险指针数量
+
+    using Deleter = void (*)(void *ptr, void *ctx);
+    using StallCallback = std::function<void(std::thread::id stalled_thread, uint64_t epoch)>;
+
+    explicit EpochDomain(EpochConfig config = EpochConfig())
+        : config_(config), id_(next_domain_id().fetch_add(1)), global_epoch_(2), head_(nullptr) {}
+
+    /**
+     * @brief 析构时释放所有待回收节点，调用者保证此时没有线程再访问这个域
+     * 各线程缓存里指向本域的记录被标记为孤儿，由线程下次查找记录时移除
+     */
+    ~EpochDomain() {
+        for (ThreadRecord *rec = head_.load(std::memory_order_acquire); rec; rec = rec->next) {
+            for (auto &bucket : rec->limbo) {
+                free_all(bucket.items);
+            }
+            free_all(rec->deferred);
+            rec->pending = 0;
+            rec->orphaned.store(true, std::memory_order_release);
+        }
+    }
+
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    /**
+     * @brief 进程级默认回收域
+     */
+    static EpochDomain &global() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // ------------------------------------------------------------------------
+    // 读者接口
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief 进入临界区，可以嵌套
+     */
+    void enter() {
+        ThreadRecord &rec = local_record();
+        if (rec.nesting++ == 0) {
+            uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+            // 先发布自己的纪元再读共享指针，seq_cst 保证推进者要么看到这次写入，要么我们读不到已摘下的节点
+            rec.state.store((epoch << 1) | 1, std::memory_order_seq_cst);
+        }
+    }
+
+    /**
+     * @brief 退出临界区
+     */
+    void exit() {
+        ThreadRecord &rec = local_record();
+        if (--rec.nesting == 0) {
+            rec.state.store(0, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief 当前线程是否在临界区内
+     */
+    bool in_critical_section() {
+        return local_record().nesting > 0;
+    }
+
+    // ------------------------------------------------------------------------
+    // 写者接口
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief 退休一个已经从共享结构中摘下的节点
+     * @param ptr 节点指针
+     * @param deleter 释放函数，回收时以 deleter(ptr, ctx) 调用
+     * @param ctx 传给释放函数的上下文（例如内存池）
+     */
+    void retire(void *ptr, Deleter deleter, void *ctx = nullptr) {
+        if (!ptr) {
+            return;
+        }
+
+        ThreadRecord &rec = local_record();
+        uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+        LimboBucket &bucket = rec.limbo[epoch % 3];
+        if (bucket.epoch != epoch) {
+            // 同一个桶里旧的节点至少早了 3 个纪元，已经可以释放
+            reclaim_list(rec, bucket.items);
+            bucket.epoch = epoch;
+        }
+
+        bucket.items.push_back(Retired{ptr, deleter, ctx});
+        rec.pending++;
+        retired_.fetch_add(1, std::memory_order_relaxed);
+
+        if (++rec.retired_since_collect >= config_.collect_threshold) {
+            rec.retired_since_collect = 0;
+            try_advance();
+            collect(rec);
+            adopt_orphans();
+        }
+
+        if (rec.pending > config_.max_pending) {
+            handle_overflow(rec);
+        }
+    }
+
+    /**
+     * @brief 退休一个 new 出来的对象，回收时 delete
+     */
+    template<typename T>
+    void retire(T *ptr) {
+        retire(ptr, [](void *p, void *) { delete static_cast<T *>(p); });
+    }
+
+    /**
+     * @brief 退休一块从内存池分配的内存，回收时调用 pool.deallocate(ptr)
+     * 适用于 MemoryPoolManager 以及任何提供 deallocate(void*) 的分配器
+     */
+    template<typename Pool>
+    void retire_to(Pool &pool, void *ptr) {
+        retire(ptr, [](void *p, void *ctx) { static_cast<Pool *>(ctx)->deallocate(p); }, &pool);
+    }
+
+    /**
+     * @brief 尝试推进全局纪元
+     * @return 推进成功返回 true
+     */
+    bool try_advance() {
+        uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+        for (ThreadRecord *rec = head_.load(std::memory_order_acquire); rec; rec = rec->next) {
+            uint64_t state = rec->state.load(std::memory_order_seq_cst);
+            if ((state & 1) && (state >> 1) != epoch) {
+                advance_failures_.fetch_add(1, std::memory_order_relaxed);
+                note_blocked(rec, state);
+                return false;
+            }
+        }
+
+        blocked_rounds_.store(0, std::memory_order_relaxed);
+        return global_epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief 回收当前线程所有可以释放的节点
+     */
+    void collect() {
+        collect(local_record());
+    }
+
+    /**
+     * @brief 等待调用前退休的所有节点被释放（不能在临界区内调用）
+     */
+    void synchronize() {
+        ThreadRecord &rec = local_record();
+        if (rec.nesting > 0) {
+            return;
+        }
+
+        uint64_t target = global_epoch_.load(std::memory_order_seq_cst) + 2;
+        while (global_epoch_.load(std::memory_order_seq_cst) < target) {
+            if (!try_advance()) {
+                std::this_thread::yield();
+            }
+        }
+        collect(rec);
+        adopt_orphans();
+    }
+
+    /**
+     * @brief 设置读者停滞时的回调（在检测到停滞的写者线程上执行）
+     */
+    void set_stall_callback(StallCallback callback) {
+        std::lock_guard<std::mutex> lock(records_mutex_);
+        stall_callback_ = std::make_shared<StallCallback>(std::move(callback));
+    }
+
+    EpochStats stats() const {
+        EpochStats stats;
+        stats.global_epoch = global_epoch_.load(std::memory_order_relaxed);
+        stats.retired = retired_.load(std::memory_order_relaxed);
+        stats.reclaimed = reclaimed_.load(std::memory_order_relaxed);
+        stats.pending = stats.retired >= stats.reclaimed ? stats.retired - stats.reclaimed : 0;
+        stats.advance_failures = advance_failures_.load(std::memory_order_relaxed);
+        stats.hazard_deferred = hazard_deferred_.load(std::memory_order_relaxed);
+        stats.stall_events = stall_events_.load(std::memory_order_relaxed);
+        stats.overflow_waits = overflow_waits_.load(std::memory_order_relaxed);
+        stats.overflow_bypassed = overflow_bypassed_.load(std::memory_order_relaxed);
+        for (ThreadRecord *rec = head_.load(std::memory_order_acquire); rec; rec = rec->next) {
+            stats.thread_records++;
+        }
+        return stats;
+    }
+
+    /**
+     * @brief 当前线程缓存的线程记录数量（每个进入过且仍然存活的域一条，用于诊断）
+     */
+    static size_t cached_records() {
+        return thread_cache().size();
+    }
+
+private:
+    friend class HazardGuard;
+
+    struct Retired {
+        void *ptr;
+        Deleter deleter;
+        void *ctx;
+    };
+
+    struct LimboBucket {
+        uint64_t epoch = 0;
+        std::vector<Retired> items;
+    };
+
+    /**
+     * @brief 线程记录，只追加不删除；线程退出后标记为空闲，可被新线程复用
+     */
+    struct alignas(64) ThreadRecord {
+        std::atomic<uint64_t> state{0};         // (纪元 << 1) | 活跃位
+        std::atomic<bool> in_use{false};        // 是否被某个线程持有
+        std::atomic<void *> hazards[HAZARD_SLOTS] = {};
+        ThreadRecord *next = nullptr;           // 发布后不再修改
+        std::atomic<std::thread::id> owner{};
+        std::atomic<bool> orphaned{false};      // 所属的域已经析构
+
+        // 以下字段只由持有者线程访问
+        uint32_t nesting = 0;
+        uint32_t hazard_mask = 0;               // 已占用的风险指针槽
+        size_t pending = 0;                     // limbo + deferred 中的节点数
+        size_t retired_since_collect = 0;
+        LimboBucket limbo[3];
+        std::vector<Retired> deferred;          // 被风险指针保护而推迟释放的节点
+    };
+
+    /**
+     * @brief 线程本地缓存，线程退出时释放持有的记录，未回收的节点留给下一个持有者
+     * 记录由 shared_ptr 共同持有，域先于线程销毁时也不会访问已释放的内存
+     */
+    struct CacheEntry {
+        uint64_t domain_id;
+        std::shared_ptr<ThreadRecord> record;
+
+        CacheEntry(uint64_t id, std::shared_ptr<ThreadRecord> rec) : domain_id(id), record(std::move(rec)) {}
+
+        // vector 扩容时只转移所有权，不能释放记录
+        CacheEntry(CacheEntry &&other) noexcept : domain_id(other.domain_id), record(std::move(other.record)) {}
+        CacheEntry(const CacheEntry &) = delete;
+        CacheEntry &operator=(const CacheEntry &) = delete;
+
+        CacheEntry &operator=(CacheEntry &&other) noexcept {
+            if (this != &other) {
+                release();
+                domain_id = other.domain_id;
+                record = std::move(other.record);
+            }
+            return *this;
+        }
+
+        ~CacheEntry() {
+            release();
+        }
+
+        void release() {
+            if (record) {
+                for (auto &hazard : record->hazards) {
+                    hazard.store(nullptr, std::memory_order_release);
+                }
+                record->hazard_mask = 0;
+                record->nesting = 0;
+                record->state.store(0, std::memory_order_release);
+                record->in_use.store(false, std::memory_order_release);
+                record.reset();
+            }
+        }
+    };
+
+    static std::atomic<uint64_t> &next_domain_id() {
+        static std::atomic<uint64_t> id{1};
+        return id;
+    }
+
+    static std::vector<CacheEntry> &thread_cache() {
+        thread_local std::vector<CacheEntry> cache;
+        return cache;
+    }
+
+    ThreadRecord &local_record() {
+        auto &cache = thread_cache();
+        for (size_t i = 0; i < cache.size();) {
+            CacheEntry &entry = cache[i];
+            if (entry.domain_id == id_) {
+                return *entry.record;
+            }
+            // 已析构的域留下的记录顺便移除，缓存不会随域的创建销毁增长，查找也不会越来越慢
+            if (entry.record->orphaned.load(std::memory_order_acquire)) {
+                if (i + 1 != cache.size()) {
+                    entry = std::move(cache.back());
+                }
+                cache.pop_back();
+                continue;
+            }
+            ++i;
+        }
+        return acquire_record(cache);
+    }
+
+    ThreadRecord &acquire_record(std::vector<CacheEntry> &cache) {
+        std::shared_ptr<ThreadRecord> record;
+        {
+            std::lock_guard<std::mutex> lock(records_mutex_);
+            // 优先复用已退出线程的记录，连同它遗留的待回收节点
+            for (auto &owned : records_) {
+                bool expected = false;
+                if (owned->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                    record = owned;
+                    break;
+                }
+            }
+            if (!record) {
+                record = std::make_shared<ThreadRecord>();
+                record->in_use.store(true, std::memory_order_relaxed);
+                record->next = head_.load(std::memory_order_relaxed);
+                records_.push_back(record);
+                head_.store(record.get(), std::memory_order_release);
+            }
+        }
+
+        record->owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        cache.emplace_back(id_, record);
+        return *record;
+    }
+
+    /**
+     * @brief 释放已过宽限期的 limbo 桶，以及不再被风险指针保护的推迟节点
+     */
+    void collect(ThreadRecord &rec) {
+        uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+        for (auto &bucket : rec.limbo) {
+            if (!bucket.items.empty() && bucket.epoch + 2 <= epoch) {
+                reclaim_list(rec, bucket.items);
+            }
+        }
+        if (!rec.deferred.empty()) {
+            std::vector<Retired> deferred;
+            deferred.swap(rec.deferred);
+            reclaim_list(rec, deferred);
+        }
+    }
+
+    /**
+     * @brief 释放 list 中的节点，被风险指针保护的节点移到 deferred
+     * 调用者保证 list 中的节点都已经过了纪元宽限期
+     */
+    void reclaim_list(ThreadRecord &rec, std::vector<Retired> &list) {
+        if (list.empty()) {
+            return;
+        }
+
+        std::vector<void *> protected_ptrs;
+        for (ThreadRecord *r = head_.load(std::memory_order_acquire); r; r = r->next) {
+            for (auto &hazard : r->hazards) {
+                void *p = hazard.load(std::memory_order_seq_cst);
+                if (p) {
+                    protected_ptrs.push_back(p);
+                }
+            }
+        }
+        std::sort(protected_ptrs.begin(), protected_ptrs.end());
+
+        size_t freed = 0;
+        for (const Retired &item : list) {
+            if (std::binary_search(protected_ptrs.begin(), protected_ptrs.end(), item.ptr)) {
+                rec.deferred.push_back(item);
+                hazard_deferred_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                item.deleter(item.ptr, item.ctx);
+                freed++;
+            }
+        }
+        list.clear();
+
+        rec.pending -= freed;
+        reclaimed_.fetch_add(freed, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 顺带回收已退出线程遗留的节点，避免它们一直等到记录被复用
+     */
+    void adopt_orphans() {
+        for (ThreadRecord *rec = head_.load(std::memory_order_acquire); rec; rec = rec->next) {
+            if (rec->in_use.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            bool expected = false;
+            if (rec->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                if (rec->pending > 0) {
+                    collect(*rec);
+                }
+                rec->in_use.store(false, std::memory_order_release);
+            }
+        }
+    }
+
+    /**
+     * @brief 记录阻止纪元推进的线程，连续 stall_rounds 次都是同一个状态时判定为停滞
+     */
+    void note_blocked(ThreadRecord *rec, uint64_t state) {
+        ThreadRecord *prev = blocked_record_.exchange(rec, std::memory_order_relaxed);
+        uint64_t prev_state = blocked_state_.exchange(state, std::memory_order_relaxed);
+        if (prev != rec || prev_state != state) {
+            blocked_rounds_.store(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (blocked_rounds_.fetch_add(1, std::memory_order_relaxed) + 1 == config_.stall_rounds) {
+            stall_events_.fetch_add(1, std::memory_order_relaxed);
+            std::shared_ptr<StallCallback> callback;
+            {
+                std::lock_guard<std::mutex> lock(records_mutex_);
+                callback = stall_callback_;
+            }
+            if (callback && *callback) {
+                (*callback)(rec->owner.load(std::memory_order_relaxed), state >> 1);
+            }
+        }
+    }
+
+    /**
+     * @brief 当前是否有读者停滞（连续 stall_rounds 次阻止推进，纪元推进成功后清零）
+     */
+    bool reader_stalled() const {
+        return blocked_rounds_.load(std::memory_order_relaxed) >= config_.stall_rounds;
+    }
+
+    /**
+     * @brief 待回收节点超过上限：不在临界区内时等待纪元推进，否则只能继续堆积
+     * 等待以读者停滞为界：停滞的读者不知道什么时候才会退出，继续等待会让所有写者一起卡住
+     */
+    void handle_overflow(ThreadRecord &rec) {
+        overflow_waits_.fetch_add(1, std::memory_order_relaxed);
+        if (!config_.block_on_overflow || rec.nesting > 0) {
+            return;
+        }
+
+        // 被风险指针保护的节点数量有上限（线程数 × HAZARD_SLOTS），不计入等待条件
+        while (rec.pending - rec.deferred.size() > config_.max_pending) {
+            bool advanced = try_advance();
+            collect(rec);
+            if (!advanced) {
+                if (reader_stalled()) {
+                    overflow_bypassed_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void free_all(std::vector<Retired> &list) {
+        for (const Retired &item : list) {
+            item.deleter(item.ptr, item.ctx);
+        }
+        reclaimed_.fetch_add(list.size(), std::memory_order_relaxed);
+        list.clear();
+    }
+
+    EpochConfig config_;
+    uint64_t id_;                                   // 区分不同的域，线程缓存按 id 查找
+    std::atomic<uint64_t> global_epoch_;
+    std::atomic<ThreadRecord *> head_;              // 线程记录链表（只追加）
+
+    std::mutex records_mutex_;                      // 保护 records_ 和 stall_callback_
+    std::vector<std::shared_ptr<ThreadRecord>> records_;
+    std::shared_ptr<StallCallback> stall_callback_;
+
+    std::atomic<ThreadRecord *> blocked_record_{nullptr};
+    std::atomic<uint64_t> blocked_state_{0};
+    std::atomic<uint32_t> blocked_rounds_{0};
+
+    std::atomic<uint64_t> retired_{0};
+    std::atomic<uint64_t> reclaimed_{0};
+    std::atomic<uint64_t> advance_failures_{0};
+    std::atomic<uint64_t> hazard_deferred_{0};
+    std::atomic<uint64_t> stall_events_{0};
+    std::atomic<uint64_t> overflow_waits_{0};
+    std::atomic<uint64_t> overflow_bypassed_{0};
+};
+
+// ============================================================================
+// RAII 守卫
+// ============================================================================
+
+/**
+ * @brief 纪元临界区守卫，适合短小、不阻塞的读操作
+ */
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochDomain &domain = EpochDomain::global()) : domain_(domain) {
+        domain_.enter();
+    }
+
+    ~EpochGuard() {
+        domain_.exit();
+    }
+
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+
+private:
+    EpochDomain &domain_;
+};
+
+/**
+ * @brief 风险指针守卫，适合可能长时间持有指针或会阻塞的读者
+ * 只保护单个指针，不占用纪元，不会阻止其他线程回收
+ */
+class HazardGuard {
+public:
+    explicit HazardGuard(EpochDomain &domain = EpochDomain::global()) : rec_(domain.local_record()), slot_(0) {
+        while (slot_ < EpochDomain::HAZARD_SLOTS && (rec_.hazard_mask & (1u << slot_))) {
+            slot_++;
+        }
+        if (slot_ == EpochDomain::HAZARD_SLOTS) {
+            throw std::runtime_error("HazardGuard: no free hazard slot");
+        }
+        rec_.hazard_mask |= 1u << slot_;
+    }
+
+    ~HazardGuard() {
+        rec_.hazards[slot_].store(nullptr, std::memory_order_release);
+        rec_.hazard_mask &= ~(1u << slot_);
+    }
+
+    HazardGuard(const HazardGuard &) = delete;
+    HazardGuard &operator=(const HazardGuard &) = delete;
+
+    /**
+     * @brief 读取 src 并保护读到的指针：发布后再次确认 src 未变，保证节点发布时还没有被摘下
+     */
+    template<typename T>
+    T *protect(const std::atomic<T *> &src) {
+        T *ptr = src.load(std::memory_order_acquire);
+        while (true) {
+            rec_.hazards[slot_].store(ptr, std::memory_order_seq_cst);
+            T *again = src.load(std::memory_order_seq_cst);
+            if (again == ptr) {
+                return ptr;
+            }
+            ptr = again;
+        }
+    }
+
+    /**
+     * @brief 不再需要保护
+     */
+    void reset() {
+        rec_.hazards[slot_].store(nullptr, std::memory_order_release);
+    }
+
+private:
+    EpochDomain::ThreadRecord &rec_;
+    size_t slot_;
+};
+
+} // namespace CodeGuide
+
+#endif //SOURCE_EPOCH_RECLAIM_H
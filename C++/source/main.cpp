@@ -1,6 +1,581 @@
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include "file.h"
 #include "thread.h"
+#include "thread_pool.h"
+#include "epoch_reclaim.h"
+#include "timer_wheel.hpp"
+#include "StaticEventBus.h"
+#include "EventSystem.h"
+#include "EventRecorder.h"
+
+// ============================================================================
+// 测试用的事件类型
+// ============================================================================
+
+struct QuoteEvent : public Event {
+    std::string symbol;
+    double price = 0;
+
+    std::type_index getType() const override { return typeid(QuoteEvent); }
+    std::string getName() const override { return "QuoteEvent"; }
+};
+
+struct TradeEvent : public Event {
+    double price = 0;
+    int64_t volume = 0;
+
+    std::type_index getType() const override { return typeid(TradeEvent); }
+    std::string getName() const override { return "TradeEvent"; }
+};
+
+struct TickEvent : public Event {
+    int seq = 0;
+
+    std::type_index getType() const override { return typeid(TickEvent); }
+    std::string getName() const override { return "TickEvent"; }
+};
+
+struct PriceRequest : public Event {
+    std::string symbol;
+
+    std::type_index getType() const override { return typeid(PriceRequest); }
+    std::string getName() const override { return "PriceRequest"; }
+};
+
+struct PriceReply : public Event {
+    double price = 0;
+
+    std::type_index getType() const override { return typeid(PriceReply); }
+    std::string getName() const override { return "PriceReply"; }
+};
+
+// StaticEventBus 的事件不需要继承 Event
+struct StaticTick { int n; };
+struct StaticQuit {};
+
+// 轮询等待条件成立，超时视为测试失败直接退出（不依赖 assert，NDEBUG 下同样等待）
+template<typename Predicate>
+void wait_until(Predicate predicate, const char *what, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            std::cerr << "[ERROR] 等待超时: " << what << std::endl;
+            std::abort();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// 读者停在临界区内时写者不会被无限期阻塞，读者退出后积压的节点全部释放
+void epoch_reclaim_test() {
+    CodeGuide::EpochConfig config;
+    config.max_pending = 256;
+    config.stall_rounds = 64;
+    CodeGuide::EpochDomain domain(config);
+
+    std::atomic<int> freed(0);
+    std::atomic<bool> entered(false);
+    std::atomic<bool> release(false);
+    std::thread reader([&] {
+        CodeGuide::EpochGuard guard(domain);
+        entered.store(true);
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+
+    const int count = 10000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        domain.retire(new int(i), [](void *ptr, void *ctx) {
+            delete static_cast<int *>(ptr);
+            static_cast<std::atomic<int> *>(ctx)->fetch_add(1);
+        }, &freed);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    CodeGuide::EpochStats stats = domain.stats();
+    std::cout << "[epoch] 读者停滞时退休 " << count << " 个节点耗时 " << elapsed.count() << "ms"
+              << ", stall_events=" << stats.stall_events
+              << ", overflow_bypassed=" << stats.overflow_bypassed
+              << ", 已释放=" << freed.load() << std::endl;
+    assert(stats.stall_events >= 1 && stats.overflow_bypassed > 0);
+    assert(freed.load() == 0);
+
+    release.store(true);
+    reader.join();
+    domain.synchronize();
+    std::cout << "[epoch] 读者退出后已释放 " << freed.load() << "/" << count << std::endl;
+    assert(freed.load() == count);
+}
+
+// 反复创建销毁域时，线程缓存只保留存活的域，已析构域的记录在下次查找时被移除
+void epoch_domain_churn_test() {
+    CodeGuide::EpochDomain live;
+    CodeGuide::EpochGuard live_guard(live);
+    size_t baseline = CodeGuide::EpochDomain::cached_records();
+
+    for (int i = 0; i < 1000; ++i) {
+        CodeGuide::EpochDomain domain;
+        CodeGuide::EpochGuard guard(domain);
+    }
+
+    std::cout << "[epoch] 创建销毁 1000 个域后线程缓存记录数 " << CodeGuide::EpochDomain::cached_records()
+              << " (基线 " << baseline << ")" << std::endl;
+    // 最后一个销毁的域要等下一次未命中的查找才移除，最多多出一条
+    assert(CodeGuide::EpochDomain::cached_records() <= baseline + 1);
+}
+
+// 停止前提交的任务全部执行完，停止后提交被拒绝
+void thread_pool_shutdown_test() {
+    CodeGuide::ThreadPool pool(2);
+    std::atomic<int> done(0);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.push_back(pool.submit([&done, i] {
+            done.fetch_add(1);
+            return i;
+        }));
+    }
+    pool.shutdown();
+
+    int sum = 0;
+    for (auto &result : results) {
+        sum += result.get();
+    }
+
+    bool rejected = false;
+    try {
+        pool.post([] {});
+    } catch (const std::runtime_error &) {
+        rejected = true;
+    }
+    std::cout << "[thread_pool] 停止前完成 " << done.load() << "/100 个任务, 停止后提交"
+              << (rejected ? "被拒绝" : "未被拒绝") << std::endl;
+    assert(done.load() == 100 && sum == 99 * 100 / 2 && rejected);
+}
+
+// 只能移动的参数可以提交；parallel_for 覆盖整个区间，调用线程等待时不空转
+void thread_pool_submit_test() {
+    CodeGuide::ThreadPool pool(2);
+    auto owned = pool.submit([](std::unique_ptr<int> value, int scale) { return *value * scale; },
+                             std::make_unique<int>(21), 2);
+
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallel_for(0, hits.size(), [&hits](size_t i) {
+        hits[i].fetch_add(1);
+    });
+    size_t covered = 0;
+    for (auto &hit : hits) {
+        covered += hit.load() == 1 ? 1 : 0;
+    }
+
+    int value = owned.get();
+    std::cout << "[thread_pool] unique_ptr 参数任务返回 " << value << ", parallel_for 覆盖 "
+              << covered << "/" << hits.size() << std::endl;
+    assert(value == 42 && covered == hits.size());
+}
+
+// 一次性定时器按到期顺序触发，取消的不触发，周期定时器每个间隔触发一次
+void timer_wheel_test() {
+    asyncio::TimerWheel wheel(0);
+    std::vector<int> fired;
+    int periodic_count = 0;
+
+    wheel.add(10, 0, [&] { fired.push_back(10); });
+    asyncio::TimerWheel::TimerId cancelled = wheel.add(20, 0, [&] { fired.push_back(20); });
+    wheel.add(300, 0, [&] { fired.push_back(300); });    // 超过 level0 的范围，需要下沉
+    asyncio::TimerWheel::TimerId periodic = wheel.add(5, 5, [&] { periodic_count++; });
+    [[maybe_unused]] bool cancelled_ok = wheel.cancel(cancelled);
+    assert(cancelled_ok);
+
+    std::vector<asyncio::TimerWheel::Callback> expired;
+    wheel.advance(400, expired);
+    for (auto &callback : expired) {
+        callback();
+    }
+    [[maybe_unused]] bool periodic_cancelled = wheel.cancel(periodic);
+    assert(periodic_cancelled);
+
+    std::cout << "[timer_wheel] 一次性定时器触发 " << fired.size() << " 个, 周期定时器触发 "
+              << periodic_count << " 次, 剩余 " << wheel.size() << std::endl;
+    assert((fired == std::vector<int>{10, 300}));
+    assert(periodic_count == 80 && wheel.size() == 0);
+}
+
+std::atomic<int> static_function_hits(0);
+
+void on_static_tick(const StaticTick &tick) {
+    static_function_hits.fetch_add(tick.n);
+}
+
+// 编译期事件总线：三种监听器都能收到事件，注销后拥有的监听器对象被释放
+void static_event_bus_test() {
+    StaticEventBus<StaticTick, StaticQuit> bus;
+    auto owned = std::make_shared<std::atomic<int>>(0);
+    std::weak_ptr<std::atomic<int>> owned_alive = owned;
+    std::atomic<int> ref_hits(0);
+    auto ref_listener = [&ref_hits](const StaticTick &tick) { ref_hits.fetch_add(tick.n); };
+
+    size_t owned_id = bus.subscribe<StaticTick>([owned](const StaticTick &tick) { owned->fetch_add(tick.n); });
+    bus.subscribeRef<StaticTick>(ref_listener);
+    bus.subscribe<StaticTick, &on_static_tick>();
+    std::atomic<bool> quit(false);
+    bus.subscribe<StaticQuit>([&quit](const StaticQuit &) { quit.store(true); });
+    owned.reset();
+
+    bus.dispatch(StaticTick{1});
+    bus.start();
+    bus.publish(StaticTick{2});
+    bus.publish(StaticQuit{});
+    wait_until([&] { return quit.load(); }, "静态总线退出事件");
+    assert(ref_hits.load() == 3 && static_function_hits.load() == 3 && !owned_alive.expired());
+
+    [[maybe_unused]] bool removed = bus.unsubscribe<StaticTick>(owned_id);
+    assert(removed);
+    bus.synchronize();
+    std::cout << "[static_bus] 监听器数量 " << bus.getListenerCount<StaticTick>()
+              << ", 注销的监听器已释放: " << (owned_alive.expired() ? "是" : "否") << std::endl;
+    assert(bus.getListenerCount<StaticTick>() == 2 && owned_alive.expired());
+
+    // 回收在 mutex_ 外进行：已注销的监听器析构时可以调用总线的注册/注销接口，不会死锁
+    struct Unsubscriber {
+        StaticEventBus<StaticTick, StaticQuit> *bus;
+        std::shared_ptr<std::atomic<bool>> destroyed;
+        void operator()(const StaticQuit &) const {}
+        ~Unsubscriber() {
+            if (destroyed) {
+                bus->unsubscribe<StaticQuit>(0);
+                destroyed->store(true);
+            }
+        }
+    };
+    auto destroyed = std::make_shared<std::atomic<bool>>(false);
+    size_t unsubscriber_id = bus.subscribe<StaticQuit>(Unsubscriber{&bus, destroyed});
+    [[maybe_unused]] bool unsubscriber_removed = bus.unsubscribe<StaticQuit>(unsubscriber_id);
+    assert(unsubscriber_removed);
+    bus.synchronize();
+    std::cout << "[static_bus] 析构中调用注销接口的监听器已释放: " << (destroyed->load() ? "是" : "否") << std::endl;
+    assert(destroyed->load() && bus.getListenerCount<StaticQuit>() == 1);
+    bus.stop();
+}
+
+// 字段相等过滤器走字段索引，字段比较过滤器逐个检查，没有监听器接受的事件在发布时丢弃
+void event_filter_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    std::atomic<int> aapl(0);
+    std::atomic<int> expensive(0);
+
+    size_t by_symbol = bus.subscribe<QuoteEvent>(EventFilter<QuoteEvent>::fieldEquals(&QuoteEvent::symbol, "AAPL"),
+        [&aapl](const std::shared_ptr<QuoteEvent> &) { aapl.fetch_add(1); });
+    size_t by_price = bus.subscribe<QuoteEvent>(EventFilter<QuoteEvent>::field(&QuoteEvent::price, std::greater<>(), 500.0),
+        [&expensive](const std::shared_ptr<QuoteEvent> &) { expensive.fetch_add(1); });
+
+    size_t filtered_before = bus.getFilteredEventCount();
+    for (auto [symbol, price] : {std::pair<const char *, double>{"AAPL", 100}, {"MSFT", 600}, {"GOOG", 100}}) {
+        auto quote = std::make_shared<QuoteEvent>();
+        quote->symbol = symbol;
+        quote->price = price;
+        bus.publish(quote);
+    }
+
+    wait_until([&] { return aapl.load() == 1 && expensive.load() == 1; }, "过滤后的报价");
+    size_t filtered = bus.getFilteredEventCount() - filtered_before;
+    std::cout << "[filter] AAPL=" << aapl.load() << " 高价=" << expensive.load() << " 发布时丢弃=" << filtered << std::endl;
+    assert(filtered == 1);
+
+    bus.unsubscribe<QuoteEvent>(by_symbol);
+    bus.unsubscribe<QuoteEvent>(by_price);
+}
+
+// 走字段索引的监听器和普通监听器混合时，仍然按订阅顺序调用
+void event_filter_order_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    std::mutex order_mutex;
+    std::vector<int> order;
+    auto record = [&order_mutex, &order](int listener) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(listener);
+    };
+
+    size_t first = bus.subscribe<QuoteEvent>([&record](const std::shared_ptr<QuoteEvent> &) { record(1); });
+    size_t indexed = bus.subscribe<QuoteEvent>(EventFilter<QuoteEvent>::fieldEquals(&QuoteEvent::symbol, "IBM"),
+        [&record](const std::shared_ptr<QuoteEvent> &) { record(2); });
+    size_t last = bus.subscribe<QuoteEvent>([&record](const std::shared_ptr<QuoteEvent> &) { record(3); });
+
+    auto quote = std::make_shared<QuoteEvent>();
+    quote->symbol = "IBM";
+    bus.publish(quote);
+    wait_until([&] {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        return order.size() == 3;
+    }, "三个监听器");
+
+    std::cout << "[filter] 调用顺序:";
+    for (int listener : order) {
+        std::cout << " " << listener;
+    }
+    std::cout << std::endl;
+    assert((order == std::vector<int>{1, 2, 3}));
+
+    bus.unsubscribe<QuoteEvent>(first);
+    bus.unsubscribe<QuoteEvent>(indexed);
+    bus.unsubscribe<QuoteEvent>(last);
+}
+
+// 邮箱满时按 DropNewest 丢弃，同步分发不会被慢监听器阻塞
+void actor_overflow_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    ActorOptions options;
+    options.capacity = 4;
+    options.overflow = MailboxOverflowPolicy::DropNewest;
+
+    std::atomic<bool> release(false);
+    size_t id = bus.subscribeActor<TickEvent>([&release](const std::shared_ptr<TickEvent> &) {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }, options);
+
+    const size_t count = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        bus.dispatch(std::make_shared<TickEvent>());
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    ActorStats blocked = bus.getActorStats(id);
+
+    release.store(true);
+    wait_until([&] {
+        ActorStats stats = bus.getActorStats(id);
+        return stats.processed + stats.dropped == count;
+    }, "邮箱清空");
+    ActorStats stats = bus.getActorStats(id);
+    std::cout << "[actor] 分发 " << count << " 个事件耗时 " << elapsed.count() << "ms, 邮箱满时丢弃 "
+              << blocked.dropped << ", 最终处理 " << stats.processed << std::endl;
+    assert(elapsed < std::chrono::milliseconds(100));
+    assert(blocked.pending <= options.capacity && blocked.dropped >= count - options.capacity - 1);
+
+    bus.unsubscribe<TickEvent>(id);
+}
+
+// 延迟发布在到期后只发布一次，周期发布取消后不再发布
+void scheduled_publish_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    std::atomic<int> delayed(0);
+    std::atomic<int> periodic(0);
+    std::atomic<int64_t> delayed_after_ms(0);
+    auto start = std::chrono::steady_clock::now();
+
+    size_t id = bus.subscribe<TickEvent>([&](const std::shared_ptr<TickEvent> &tick) {
+        if (tick->seq == 1) {
+            delayed_after_ms.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            delayed.fetch_add(1);
+        } else {
+            periodic.fetch_add(1);
+        }
+    });
+
+    auto once = std::make_shared<TickEvent>();
+    once->seq = 1;
+    bus.publishAfter(std::chrono::milliseconds(30), once);
+    auto every = std::make_shared<TickEvent>();
+    every->seq = 2;
+    EventSystem::TimerId timer = bus.publishEvery(std::chrono::milliseconds(10), every);
+
+    wait_until([&] { return delayed.load() == 1 && periodic.load() >= 3; }, "延迟和周期事件");
+    [[maybe_unused]] bool stopped = bus.cancelScheduled(timer);
+    assert(stopped);
+    [[maybe_unused]] int after_cancel = periodic.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::cout << "[schedule] 延迟事件在 " << delayed_after_ms.load() << "ms 后发布, 周期事件发布 "
+              << periodic.load() << " 次" << std::endl;
+    // 当前 tick 向下取整，到期时刻最多比请求的延迟早一个 tick
+    assert(delayed.load() == 1 && delayed_after_ms.load() >= 29);
+    assert(periodic.load() <= after_cancel + 1 && bus.getScheduledEventCount() == 0);
+
+    bus.unsubscribe<TickEvent>(id);
+}
+
+// 有应答的请求拿到结果，没有应答的请求在超时后以 RequestError 结束
+void request_reply_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    size_t id = bus.respond<PriceRequest, PriceReply>([](const std::shared_ptr<PriceRequest> &request) {
+        if (request->symbol == "SLOW") {
+            return std::shared_ptr<PriceReply>();
+        }
+        auto reply = std::make_shared<PriceReply>();
+        reply->price = 42;
+        return reply;
+    });
+
+    size_t scheduled_before = bus.getScheduledEventCount();
+    auto request = std::make_shared<PriceRequest>();
+    request->symbol = "AAPL";
+    auto answered = bus.request<PriceRequest, PriceReply>(request, std::chrono::milliseconds(1000));
+    double price = answered.get()->price;
+    // 应答时取消超时定时器，不会留在时间轮里等到期
+    size_t scheduled_after = bus.getScheduledEventCount();
+
+    auto slow = std::make_shared<PriceRequest>();
+    slow->symbol = "SLOW";
+    auto start = std::chrono::steady_clock::now();
+    auto unanswered = bus.request<PriceRequest, PriceReply>(slow, std::chrono::milliseconds(50));
+    bool timed_out = false;
+    try {
+        unanswered.get();
+    } catch (const RequestError &) {
+        timed_out = true;
+    }
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "[request] 应答价格=" << price << ", 应答后剩余定时器 " << scheduled_after
+              << " (请求前 " << scheduled_before << "), 无应答的请求在 " << waited.count() << "ms 后"
+              << (timed_out ? "超时" : "未超时") << std::endl;
+    // 超时与延迟发布共用时间轮，同样可能早一个 tick
+    assert(price == 42 && scheduled_after == scheduled_before);
+    assert(timed_out && waited >= std::chrono::milliseconds(49));
+    assert(bus.getPendingRequestCount() == 0);
+
+    bus.unsubscribe<PriceRequest>(id);
+}
+
+// 超过阈值的监听器调用会发布 SlowListenerEvent，并计入耗时统计
+void slow_listener_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    bus.setSlowListenerThreshold(std::chrono::milliseconds(5));
+
+    std::atomic<int> slow_events(0);
+    std::atomic<size_t> reported_id(0);
+    size_t watcher = bus.subscribe<SlowListenerEvent>([&](const std::shared_ptr<SlowListenerEvent> &event) {
+        reported_id.store(event->listenerId);
+        slow_events.fetch_add(1);
+    });
+    size_t slow = bus.subscribe<QuoteEvent>([](const std::shared_ptr<QuoteEvent> &) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+
+    bus.publish(std::make_shared<QuoteEvent>());
+    wait_until([&] { return slow_events.load() >= 1; }, "慢监听器事件");
+    ListenerStats stats = bus.getListenerStats(slow);
+    std::cout << "[slow] 慢监听器 ID=" << reported_id.load() << ", 慢调用次数=" << stats.slowCalls << std::endl;
+    assert(reported_id.load() == slow && stats.slowCalls >= 1);
+
+    bus.setSlowListenerThreshold(std::chrono::nanoseconds(0));
+    bus.enableListenerStats(false);
+    bus.unsubscribe<SlowListenerEvent>(watcher);
+    bus.unsubscribe<QuoteEvent>(slow);
+}
+
+// 录制的事件流回放后，监听器收到与录制时相同的负载
+void record_replay_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    EventCodecRegistry codecs;
+    codecs.registerFields<TradeEvent>("Trade", &TradeEvent::price, &TradeEvent::volume);
+
+    std::atomic<int> received(0);
+    std::atomic<int64_t> volume(0);
+    std::mutex kept_mutex;
+    std::vector<std::shared_ptr<TradeEvent>> kept;     // 监听器持有收到的事件
+    size_t id = bus.subscribe<TradeEvent>([&](const std::shared_ptr<TradeEvent> &trade) {
+        volume.fetch_add(trade->volume);
+        {
+            std::lock_guard<std::mutex> lock(kept_mutex);
+            kept.push_back(trade);
+        }
+        received.fetch_add(1);
+    });
+
+    const std::string path = (std::filesystem::temp_directory_path() / "codeguide_trades.evrc").string();
+    EventRecorder recorder(codecs);
+    [[maybe_unused]] bool recording = recorder.start(bus, path);
+    assert(recording);
+    for (int i = 1; i <= 5; ++i) {
+        auto trade = std::make_shared<TradeEvent>();
+        trade->price = i * 10.0;
+        trade->volume = i;
+        bus.publish(trade);
+    }
+    wait_until([&] { return received.load() == 5; }, "录制的成交");
+    recorder.stop();
+
+    EventReplayer replayer(codecs);
+    [[maybe_unused]] bool loaded = replayer.load(path);
+    assert(loaded && replayer.size() == 5);
+    ReplayOptions options;
+    options.speed = 0;
+    ReplayStats stats = replayer.replay(bus, options);
+    wait_until([&] { return received.load() == 10; }, "回放的成交");
+    auto first_stamp = kept[5]->timestamp;
+
+    // 再次回放发布的是新解码的对象，第一次回放的事件不会被改写
+    replayer.replay(bus, options);
+    wait_until([&] { return received.load() == 15; }, "第二次回放的成交");
+    bool fresh = kept[5] != kept[10] && kept[5]->timestamp == first_stamp;
+
+    std::cout << "[replay] 录制 " << recorder.getRecordedCount() << " 个事件, 回放 " << stats.published
+              << " 个, 成交量合计 " << volume.load() << ", 再次回放使用新对象: " << (fresh ? "是" : "否") << std::endl;
+    assert(recorder.getRecordedCount() == 5 && stats.published == 5 && volume.load() == 3 * 15);
+    assert(fresh);
+
+    std::remove(path.c_str());
+    bus.unsubscribe<TradeEvent>(id);
+}
+
+// 两个通道都有积压时按权重 3 : 1 轮流出队，低优先级通道不会被饿死
+void priority_lane_test() {
+    EventSystem &bus = EventSystem::getInstance();
+    bus.stop();
+    bus.clearQueue();
+    [[maybe_unused]] bool configured = bus.configurePriorityLanes({{INT_MIN, 1}, {5, 3}});
+    assert(configured);
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+    size_t id = bus.subscribe<TickEvent>([&](const std::shared_ptr<TickEvent> &tick) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(tick->priority);
+    });
+
+    // 处理线程停止时入队，启动后一次看到两个通道的全部积压
+    std::vector<std::shared_ptr<Event>> batch;
+    for (int i = 0; i < 16; ++i) {
+        auto tick = std::make_shared<TickEvent>();
+        tick->priority = i < 8 ? 0 : 5;
+        batch.push_back(tick);
+    }
+    bus.publishBatch(batch);
+    bus.start();
+    wait_until([&] {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        return order.size() == batch.size();
+    }, "两个通道的积压");
+
+    std::vector<int> first(order.begin(), order.begin() + 8);
+    std::cout << "[lanes] 前 8 个事件的优先级:";
+    for (int priority : first) {
+        std::cout << " " << priority;
+    }
+    std::cout << std::endl;
+    assert((first == std::vector<int>{5, 5, 5, 0, 5, 5, 5, 0}));
+
+    bus.unsubscribe<TickEvent>(id);
+    bus.stop();
+    configured = bus.configurePriorityLanes(PriorityLanes::defaultLanes());
+    assert(configured);
+    bus.start();
+}
 
 int main() {
     CodeGuide::traverseDirectory(".", [](const std::string& filename) {
@@ -8,5 +583,23 @@ int main() {
     });
 
     CodeGuide::thread_test();
+    epoch_reclaim_test();
+    epoch_domain_churn_test();
+    thread_pool_shutdown_test();
+    thread_pool_submit_test();
+    timer_wheel_test();
+    static_event_bus_test();
+
+    EventSystem &bus = EventSystem::getInstance();
+    bus.start();
+    event_filter_test();
+    event_filter_order_test();
+    actor_overflow_test();
+    scheduled_publish_test();
+    request_reply_test();
+    slow_listener_test();
+    record_replay_test();
+    priority_lane_test();
+    bus.stop();
     return 0;
 }
@@ -0,0 +1,370 @@
+#include "allocation_trace.h"
+#include "memory_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+constexpr char TRACE_MAGIC[8] = {'M', 'P', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+std::atomic<uint64_t> next_instance{1};
+
+/**
+ * @brief 读取 /proc/self/status 中的某一项（单位 kB），失败返回 0
+ */
+size_t read_status_kb(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t key_length = std::strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, key_length, key) == 0 && line.size() > key_length && line[key_length] == ':') {
+            return std::strtoull(line.c_str() + key_length + 1, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 把 VmHWM 重置为当前 RSS（Linux 4.0+），失败时峰值会包含回放之前的历史
+ */
+bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (!clear_refs) {
+        return false;
+    }
+    clear_refs << "5";
+    return static_cast<bool>(clear_refs);
+}
+
+} // namespace
+
+// ============================================================================
+// AllocationTraceRecorder 实现
+// ============================================================================
+
+AllocationTraceRecorder::AllocationTraceRecorder(const std::string& path, size_t buffer_events)
+    : instance_(next_instance.fetch_add(1)),
+      buffer_events_(buffer_events > 0 ? buffer_events : 1),
+      start_(std::chrono::steady_clock::now()),
+      file_(path, std::ios::out | std::ios::binary | std::ios::trunc),
+      bytes_written_(0), next_thread_(0), event_count_(0) {
+
+    if (!file_) {
+        std::cerr << "[ERROR] 无法创建分配轨迹文件: " << path << std::endl;
+        return;
+    }
+
+    TraceFileHeader header;
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.event_size = sizeof(TraceEvent);
+    header.start_unix_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes_written_ = sizeof(header);
+}
+
+AllocationTraceRecorder::~AllocationTraceRecorder() {
+    flush();
+}
+
+AllocationTraceRecorder::ThreadBuffer* AllocationTraceRecorder::local_buffer() {
+    // 线程退出或改用其他录制器时把缓冲区标记为废弃，由录制器在注册新线程或 flush 时回收
+    struct Cache {
+        uint64_t instance = 0;
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        void release() {
+            if (buffer) {
+                buffer->retired.store(true, std::memory_order_release);
+                buffer.reset();
+            }
+            instance = 0;
+        }
+
+        ~Cache() { release(); }
+    };
+    thread_local Cache cache;
+
+    if (cache.instance == instance_) {
+        return cache.buffer.get();
+    }
+    cache.release();
+
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    reclaim_retired_locked();
+    auto& slot = buffers_[std::this_thread::get_id()];
+    if (!slot) {
+        slot = std::make_shared<ThreadBuffer>();
+        slot->events.reserve(buffer_events_);
+        slot->thread = next_thread_++;
+    }
+    slot->retired.store(false, std::memory_order_relaxed);
+    cache.instance = instance_;
+    cache.buffer = slot;
+    return cache.buffer.get();
+}
+
+void AllocationTraceRecorder::reclaim_retired_locked() {
+    for (auto it = buffers_.begin(); it != buffers_.end();) {
+        ThreadBuffer& buffer = *it->second;
+        if (buffer.retired.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> buffer_lock(buffer.mutex);
+            write_events(buffer);
+            it = buffers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AllocationTraceRecorder::record(TraceOp op, const void* ptr, size_t size, uint8_t tag) {
+    if (!ptr || !file_.is_open()) return;
+
+    TraceEvent event;
+    event.timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+    event.id = reinterpret_cast<uintptr_t>(ptr);
+    event.size = static_cast<uint32_t>(std::min<size_t>(size, std::numeric_limits<uint32_t>::max()));
+    event.op = static_cast<uint8_t>(op);
+    event.tag = tag;
+
+    ThreadBuffer* buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    event.thread = buffer->thread;
+    buffer->events.push_back(event);
+    event_count_.fetch_add(1, std::memory_order_relaxed);
+
+    if (buffer->events.size() >= buffer_events_) {
+        write_events(*buffer);
+    }
+}
+
+void AllocationTraceRecorder::write_events(ThreadBuffer& buffer) {
+    if (buffer.events.empty()) return;
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    size_t bytes = buffer.events.size() * sizeof(TraceEvent);
+    file_.write(reinterpret_cast<const char*>(buffer.events.data()), static_cast<std::streamsize>(bytes));
+    bytes_written_ += bytes;
+    buffer.events.clear();
+}
+
+bool AllocationTraceRecorder::flush() {
+    if (!file_.is_open()) return false;
+
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    reclaim_retired_locked();
+    for (auto& entry : buffers_) {
+        std::lock_guard<std::mutex> buffer_lock(entry.second->mutex);
+        write_events(*entry.second);
+    }
+
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    file_.flush();
+    return static_cast<bool>(file_);
+}
+
+void AllocationTraceRecorder::lock_for_fork() {
+    buffers_mutex_.lock();
+    for (auto& entry : buffers_) {
+        entry.second->mutex.lock();
+    }
+    file_mutex_.lock();
+}
+
+void AllocationTraceRecorder::unlock_after_fork() {
+    file_mutex_.unlock();
+    for (auto& entry : buffers_) {
+        entry.second->mutex.unlock();
+    }
+    buffers_mutex_.unlock();
+}
+
+size_t AllocationTraceRecorder::get_thread_buffer_count() {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    return buffers_.size();
+}
+
+size_t AllocationTraceRecorder::get_bytes_written() const {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    return bytes_written_;
+}
+
+// ============================================================================
+// 轨迹加载
+// ============================================================================
+
+bool load_allocation_trace(const std::string& path, AllocationTrace& trace) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        std::cerr << "[ERROR] 无法打开分配轨迹文件: " << path << std::endl;
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "[ERROR] 不是分配轨迹文件: " << path << std::endl;
+        return false;
+    }
+    if (header.version != AllocationTraceRecorder::FORMAT_VERSION || header.event_size != sizeof(TraceEvent)) {
+        std::cerr << "[ERROR] 不支持的轨迹格式版本: " << header.version << std::endl;
+        return false;
+    }
+
+    std::vector<TraceEvent> raw;
+    TraceEvent event;
+    while (file.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+        raw.push_back(event);
+    }
+    if (file.gcount() != 0) {
+        std::cerr << "[WARNING] 轨迹文件末尾有不完整的事件，已忽略" << std::endl;
+    }
+
+    // 各线程的缓冲区是分批写入的，按时间戳恢复全局顺序
+    std::stable_sort(raw.begin(), raw.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+
+    trace = AllocationTrace();
+    trace.events.reserve(raw.size());
+
+    // 地址改写为稠密编号：分配时分配新编号，释放时查找当前持有该地址的编号
+    std::unordered_map<uint64_t, uint64_t> live;
+    std::vector<uint32_t> sizes;
+    size_t live_bytes = 0;
+    uint16_t max_thread = 0;
+
+    for (TraceEvent e : raw) {
+        if (e.op == static_cast<uint8_t>(TraceOp::ALLOCATE)) {
+            uint64_t id = trace.object_count++;
+            live[e.id] = id;
+            sizes.push_back(e.size);
+            live_bytes += e.size;
+            trace.peak_live_bytes = std::max(trace.peak_live_bytes, live_bytes);
+            e.id = id;
+        } else if (e.op == static_cast<uint8_t>(TraceOp::DEALLOCATE)) {
+            auto it = live.find(e.id);
+            if (it == live.end()) {
+                trace.dropped_frees++;
+                continue;
+            }
+            e.id = it->second;
+            live_bytes -= sizes[e.id];
+            live.erase(it);
+        } else {
+            continue;
+        }
+        max_thread = std::max(max_thread, e.thread);
+        trace.events.push_back(e);
+    }
+
+    if (!trace.events.empty()) {
+        trace.thread_count = static_cast<size_t>(max_thread) + 1;
+        trace.duration_ns = trace.events.back().timestamp_ns - trace.events.front().timestamp_ns;
+    }
+    return true;
+}
+
+// ============================================================================
+// 回放
+// ============================================================================
+
+void* MallocBackend::allocate(size_t size) {
+    return std::malloc(size);
+}
+
+void MallocBackend::deallocate(void* ptr) {
+    std::free(ptr);
+}
+
+PoolBackend::PoolBackend(const MemoryPoolConfig& config, std::string name)
+    : pool_(std::make_unique<MemoryPoolManager>(config)), name_(std::move(name)) {}
+
+PoolBackend::~PoolBackend() = default;
+
+void* PoolBackend::allocate(size_t size) {
+    return pool_->allocate(size);
+}
+
+void PoolBackend::deallocate(void* ptr) {
+    pool_->deallocate(ptr);
+}
+
+ReplayResult replay_trace(const AllocationTrace& trace, ReplayBackend& backend) {
+    ReplayResult result;
+    result.backend = backend.name();
+
+    std::vector<void*> objects(trace.object_count, nullptr);
+    std::vector<uint32_t> sizes(trace.object_count, 0);
+    size_t live_bytes = 0;
+
+    reset_peak_rss();
+    size_t baseline_kb = read_status_kb("VmRSS");
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const TraceEvent& e : trace.events) {
+        if (e.op == static_cast<uint8_t>(TraceOp::ALLOCATE)) {
+            char* ptr = static_cast<char*>(backend.allocate(e.size > 0 ? e.size : 1));
+            if (!ptr) {
+                result.failed_allocations++;
+                continue;
+            }
+            // 真实程序会写入分配到的内存，每页写一个字节让 RSS 反映实际占用
+            for (size_t offset = 0; offset < e.size; offset += 4096) {
+                ptr[offset] = 1;
+            }
+            objects[e.id] = ptr;
+            sizes[e.id] = e.size;
+            live_bytes += e.size;
+            result.peak_live_bytes = std::max(result.peak_live_bytes, live_bytes);
+        } else if (objects[e.id]) {
+            backend.deallocate(objects[e.id]);
+            objects[e.id] = nullptr;
+            live_bytes -= sizes[e.id];
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    size_t peak_kb = read_status_kb("VmHWM");
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    result.peak_rss_bytes = peak_kb > baseline_kb ? (peak_kb - baseline_kb) * 1024 : 0;
+    if (result.peak_rss_bytes > result.peak_live_bytes) {
+        result.fragmentation = 1.0 - static_cast<double>(result.peak_live_bytes) / result.peak_rss_bytes;
+    }
+
+    // 轨迹结束时仍存活的对象（录制期间没有释放）
+    for (void* ptr : objects) {
+        if (ptr) {
+            backend.deallocate(ptr);
+        }
+    }
+
+    return result;
+}
+
+void print_replay_results(const AllocationTrace& trace, const std::vector<ReplayResult>& results) {
+    std::cout << "\n轨迹: " << trace.events.size() << " 个事件，" << trace.object_count << " 次分配，"
+              << trace.thread_count << " 个线程，存活峰值 " << trace.peak_live_bytes / 1024 << " KB，跨度 "
+              << std::fixed << std::setprecision(2) << trace.duration_ns / 1e6 << " ms" << std::endl;
+
+    std::cout << std::left << std::setw(20) << "Backend" << std::right
+              << std::setw(12) << "Time(ms)" << std::setw(12) << "Failed"
+              << std::setw(16) << "PeakLive(KB)" << std::setw(16) << "PeakRSS(KB)"
+              << std::setw(12) << "Frag" << std::endl;
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(20) << r.backend << std::right
+                  << std::setw(12) << std::setprecision(2) << r.elapsed_ms
+                  << std::setw(12) << r.failed_allocations
+                  << std::setw(16) << r.peak_live_bytes / 1024
+                  << std::setw(16) << r.peak_rss_bytes / 1024
+                  << std::setw(11) << std::setprecision(1) << r.fragmentation * 100 << "%" << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
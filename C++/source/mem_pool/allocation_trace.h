@@ -0,0 +1,266 @@
+#ifndef ALLOCATION_TRACE_H
+#define ALLOCATION_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class MemoryPoolManager;
+struct MemoryPoolConfig;
+
+// ============================================================================
+// 分配轨迹录制与回放（Allocation Trace）
+// ============================================================================
+
+/**
+ * @brief 轨迹事件类型
+ */
+enum class TraceOp : uint8_t {
+    ALLOCATE = 1,
+    DEALLOCATE = 2
+};
+
+/**
+ * @brief 轨迹事件（定长 24 字节，直接按二进制写入文件）
+ */
+struct TraceEvent {
+    uint64_t timestamp_ns;      // 相对录制开始的时间
+    uint64_t id;                // 录制时为对象地址，加载后改写为从 0 开始的稠密编号
+    uint32_t size;              // 分配大小，释放事件为 0
+    uint16_t thread;            // 录制线程编号（按首次出现顺序）
+    uint8_t op;                 // TraceOp
+    uint8_t tag;                // 分配标签
+};
+
+static_assert(sizeof(TraceEvent) == 24, "TraceEvent must be 24 bytes");
+
+/**
+ * @brief 轨迹文件头
+ */
+struct TraceFileHeader {
+    char magic[8];              // "MPTRACE\0"
+    uint32_t version;           // 格式版本
+    uint32_t event_size;        // sizeof(TraceEvent)，读取时校验
+    uint64_t start_unix_ns;     // 录制开始的墙上时间，仅用于标识
+};
+
+/**
+ * @brief 分配轨迹录制器
+ *
+ * 1. 每个线程一个事件缓冲区，记录时只加缓冲区自己的锁（几乎没有竞争），写满后整批写入文件
+ * 2. 事件只记录地址，不在录制时维护地址到编号的映射，加载时再按时间排序并改写为稠密编号
+ * 3. 释放事件在真正释放之前记录，分配事件在分配成功之后记录，因此同一地址被复用时
+ *    "释放"的时间戳一定早于下一次"分配"，按时间排序后顺序是正确的
+ */
+class AllocationTraceRecorder {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    /**
+     * @brief 构造函数
+     * @param path 轨迹文件路径（截断写入）
+     * @param buffer_events 每个线程缓冲区的事件数，写满后刷到文件
+     */
+    explicit AllocationTraceRecorder(const std::string& path, size_t buffer_events = 4096);
+
+    /**
+     * @brief 析构函数，刷新所有缓冲区并关闭文件
+     */
+    ~AllocationTraceRecorder();
+
+    AllocationTraceRecorder(const AllocationTraceRecorder&) = delete;
+    AllocationTraceRecorder& operator=(const AllocationTraceRecorder&) = delete;
+
+    /**
+     * @brief 文件是否成功打开
+     */
+    bool is_open() const { return file_.is_open(); }
+
+    /**
+     * @brief 记录一次成功的分配
+     */
+    void record_allocation(const void* ptr, size_t size, uint8_t tag) {
+        record(TraceOp::ALLOCATE, ptr, size, tag);
+    }
+
+    /**
+     * @brief 记录一次释放（在真正释放之前调用）
+     */
+    void record_free(const void* ptr) {
+        record(TraceOp::DEALLOCATE, ptr, 0, 0);
+    }
+
+    /**
+     * @brief 把所有线程缓冲区中的事件写入文件
+     * @return 文件是否仍然可写
+     */
+    bool flush();
+
+    /**
+     * @brief fork 前按加锁顺序（buffers_mutex_ -> 各缓冲区 -> file_mutex_）锁住所有锁
+     */
+    void lock_for_fork();
+
+    /**
+     * @brief fork 后在父进程和子进程中释放 lock_for_fork 持有的锁
+     */
+    void unlock_after_fork();
+
+    /**
+     * @brief 已记录的事件数
+     */
+    size_t get_event_count() const { return event_count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 已写入文件的字节数（含文件头）
+     */
+    size_t get_bytes_written() const;
+
+    /**
+     * @brief 当前持有的线程缓冲区数量（已退出线程的缓冲区在注册新线程或 flush 时回收）
+     */
+    size_t get_thread_buffer_count();
+
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        uint16_t thread = 0;
+        std::atomic<bool> retired{false};       // 所属线程已退出（或改用了其他录制器），等待回收
+    };
+
+    void record(TraceOp op, const void* ptr, size_t size, uint8_t tag);
+
+    /**
+     * @brief 找到当前线程的缓冲区，不存在时注册一个
+     */
+    ThreadBuffer* local_buffer();
+
+    /**
+     * @brief 把缓冲区中的事件写入文件并清空（调用前必须持有 buffer.mutex）
+     */
+    void write_events(ThreadBuffer& buffer);
+
+    /**
+     * @brief 写出并移除已退出线程的缓冲区（调用前必须持有 buffers_mutex_）
+     */
+    void reclaim_retired_locked();
+
+    const uint64_t instance_;                   // 全局唯一编号，区分线程本地缓存属于哪个录制器
+    const size_t buffer_events_;
+    const std::chrono::steady_clock::time_point start_;
+
+    std::ofstream file_;
+    size_t bytes_written_;
+    mutable std::mutex file_mutex_;             // 保护 file_ 和 bytes_written_
+
+    // 线程本地缓存也持有缓冲区，线程退出时只做标记，录制器先销毁也不会访问已释放的内存
+    std::unordered_map<std::thread::id, std::shared_ptr<ThreadBuffer>> buffers_;
+    std::mutex buffers_mutex_;                  // 保护 buffers_ 和 next_thread_
+    uint16_t next_thread_;                      // 下一个线程编号，缓冲区回收后编号不复用
+
+    std::atomic<size_t> event_count_;
+};
+
+// ============================================================================
+// 轨迹加载
+// ============================================================================
+
+/**
+ * @brief 加载后的轨迹
+ */
+struct AllocationTrace {
+    std::vector<TraceEvent> events;     // 按时间排序，id 已改写为稠密编号
+    size_t object_count = 0;            // 分配事件数（id 的取值范围）
+    size_t thread_count = 0;            // 录制时参与的线程数
+    size_t peak_live_bytes = 0;         // 轨迹本身的存活字节峰值（按申请大小）
+    size_t dropped_frees = 0;           // 找不到对应分配的释放事件（录制开始前分配的对象）
+    uint64_t duration_ns = 0;           // 第一个到最后一个事件的时间跨度
+};
+
+/**
+ * @brief 从文件加载轨迹
+ * @return 是否加载成功，失败时打印原因
+ */
+bool load_allocation_trace(const std::string& path, AllocationTrace& trace);
+
+// ============================================================================
+// 回放
+// ============================================================================
+
+/**
+ * @brief 回放目标分配器
+ */
+class ReplayBackend {
+public:
+    virtual ~ReplayBackend() = default;
+    virtual const char* name() const = 0;
+    virtual void* allocate(size_t size) = 0;
+    virtual void deallocate(void* ptr) = 0;
+};
+
+/**
+ * @brief 系统 malloc/free
+ */
+class MallocBackend : public ReplayBackend {
+public:
+    const char* name() const override { return "malloc"; }
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+};
+
+/**
+ * @brief MemoryPoolManager，可以传入不同的配置对比分层参数
+ */
+class PoolBackend : public ReplayBackend {
+public:
+    explicit PoolBackend(const MemoryPoolConfig& config, std::string name = "pool");
+    ~PoolBackend() override;
+
+    const char* name() const override { return name_.c_str(); }
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+
+    MemoryPoolManager& pool() { return *pool_; }
+
+private:
+    std::unique_ptr<MemoryPoolManager> pool_;
+    std::string name_;
+};
+
+/**
+ * @brief 回放结果
+ */
+struct ReplayResult {
+    std::string backend;
+    double elapsed_ms = 0;              // 回放所有事件的耗时（含对每页写一个字节）
+    size_t failed_allocations = 0;      // 后端返回 nullptr 的次数
+    size_t peak_live_bytes = 0;         // 成功分配的存活字节峰值
+    size_t peak_rss_bytes = 0;          // 回放期间常驻内存的增长峰值（VmHWM - 回放前 VmRSS）
+    double fragmentation = 0;           // 1 - peak_live / peak_rss，分配器额外占用的比例
+};
+
+/**
+ * @brief 按时间顺序在单线程中回放轨迹
+ *
+ * 多线程录制的轨迹会被串行化回放，结果反映的是分配器在同样的大小分布和生命周期下的
+ * 内存占用和单线程开销，不反映锁竞争。峰值 RSS 依赖 /proc/self/clear_refs 重置 VmHWM，
+ * 在同一进程中连续回放多个后端时，已被前一个后端占用且未归还的内存会被复用，
+ * 需要隔离测量时请用 trace_replay 工具（每个后端一个子进程）。
+ */
+ReplayResult replay_trace(const AllocationTrace& trace, ReplayBackend& backend);
+
+/**
+ * @brief 打印回放结果表格
+ */
+void print_replay_results(const AllocationTrace& trace, const std::vector<ReplayResult>& results);
+
+#endif // ALLOCATION_TRACE_H
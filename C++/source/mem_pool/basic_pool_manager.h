@@ -0,0 +1,269 @@
+#ifndef BASIC_POOL_MANAGER_H
+#define BASIC_POOL_MANAGER_H
+
+#include "memory_pool.h"
+#include <array>
+
+// ============================================================================
+// 编译期分层配置（Compile-time Tier Configuration）
+// ============================================================================
+
+/**
+ * @brief 一个层级：预先创建 BlockCount 个 BlockSize 字节的 MemoryBlock
+ */
+template<size_t BlockSize, size_t BlockCount>
+struct PoolTier {
+    static_assert(BlockSize > sizeof(MemoryBlockHeader) + MemoryBlock::MIN_BLOCK_SIZE,
+                  "PoolTier block size is too small");
+    static_assert(BlockCount > 0, "PoolTier needs at least one block");
+
+    static constexpr size_t block_size = BlockSize;
+    static constexpr size_t block_count = BlockCount;
+
+    // 单次分配的上限：给块头和拆分后剩余的最小块留出空间（与 MemoryPoolManager 的判断一致）
+    static constexpr size_t max_allocation = BlockSize - sizeof(MemoryBlockHeader) - MemoryBlock::MIN_BLOCK_SIZE;
+};
+
+/**
+ * @brief 层级在编译期确定的内存池管理器
+ *
+ * MemoryPoolManager 的层级数和阈值来自运行时的 MemoryPoolConfig；这里层级作为模板参数给出，
+ * 阈值、层级数和各层块的下标都是 constexpr：
+ * 1. 大小到层级的路由是一次查表：按 ceil(log2(size)) 取出候选层级，再与前一层的上限比较一次
+ *    （比较结果直接参与减法，没有分支）。要求相邻层级的上限至少相差一倍，保证每个 log2 区间
+ *    内最多只有一个层级边界，一次修正就足够
+ * 2. 所有块放在一个定长数组中，分配时从目标层级的第一个块开始顺序查找，放不下时自然落到更大的层级
+ *
+ * @code
+ * using MyPool = BasicPoolManager<PoolTier<64 * 1024, 32>, PoolTier<1024 * 1024, 8>>;
+ * static_assert(MyPool::tier_for(1000) == 0, "");
+ * @endcode
+ */
+template<typename... Tiers>
+class BasicPoolManager {
+public:
+    static_assert(sizeof...(Tiers) > 0, "BasicPoolManager needs at least one tier");
+
+    static constexpr size_t TIER_COUNT = sizeof...(Tiers);
+    static constexpr size_t BLOCK_COUNT = (Tiers::block_count + ...);
+    static constexpr std::array<size_t, TIER_COUNT> TIER_BLOCK_SIZES = {Tiers::block_size...};
+    static constexpr std::array<size_t, TIER_COUNT> TIER_LIMITS = {Tiers::max_allocation...};
+    static constexpr size_t MAX_ALLOCATION = TIER_LIMITS[TIER_COUNT - 1];
+    static constexpr size_t TOTAL_SIZE = ((Tiers::block_size * Tiers::block_count) + ...);
+
+private:
+    static constexpr bool limits_at_least_double() {
+        for (size_t i = 1; i < TIER_COUNT; ++i) {
+            if (TIER_LIMITS[i] < 2 * TIER_LIMITS[i - 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(limits_at_least_double(),
+                  "each PoolTier must hold allocations at least twice as large as the previous one");
+
+    /**
+     * @brief 每个层级第一个块在 blocks_ 中的下标
+     */
+    static constexpr std::array<size_t, TIER_COUNT> make_tier_begin() {
+        constexpr std::array<size_t, TIER_COUNT> counts = {Tiers::block_count...};
+        std::array<size_t, TIER_COUNT> begin{};
+        size_t offset = 0;
+        for (size_t i = 0; i < TIER_COUNT; ++i) {
+            begin[i] = offset;
+            offset += counts[i];
+        }
+        return begin;
+    }
+
+    /**
+     * @brief ceil(log2(size)) -> 能容纳该区间上界的第一个层级（超过最大层级时取最后一层）
+     */
+    static constexpr std::array<uint8_t, 65> make_route_table() {
+        std::array<uint8_t, 65> table{};
+        for (size_t bucket = 0; bucket <= 64; ++bucket) {
+            size_t tier = 0;
+            while (tier + 1 < TIER_COUNT && (bucket >= 64 || TIER_LIMITS[tier] < (size_t(1) << bucket))) {
+                tier++;
+            }
+            table[bucket] = static_cast<uint8_t>(tier);
+        }
+        return table;
+    }
+
+    /**
+     * @brief 前一层级的上限（第 0 层为 0），用于修正查表结果
+     */
+    static constexpr std::array<size_t, TIER_COUNT> make_lower_limits() {
+        std::array<size_t, TIER_COUNT> lower{};
+        for (size_t i = 1; i < TIER_COUNT; ++i) {
+            lower[i] = TIER_LIMITS[i - 1];
+        }
+        return lower;
+    }
+
+    static constexpr std::array<size_t, TIER_COUNT> TIER_BEGIN = make_tier_begin();
+    static constexpr std::array<uint8_t, 65> ROUTE_TABLE = make_route_table();
+    static constexpr std::array<size_t, TIER_COUNT> LOWER_LIMITS = make_lower_limits();
+
+public:
+    /**
+     * @brief 能容纳 size 字节的最小层级（size 必须在 1 ~ MAX_ALLOCATION 之间）
+     */
+    static constexpr size_t tier_for(size_t size) {
+        size_t tier = ROUTE_TABLE[64 - __builtin_clzll((size - 1) | 1)];
+        return tier - (size <= LOWER_LIMITS[tier]);
+    }
+
+    /**
+     * @brief 构造函数，按层级顺序创建所有块
+     * @param verbose 是否打印释放失败等诊断（与 MemoryPoolConfig::verbose 含义相同）
+     */
+    explicit BasicPoolManager(bool verbose = true) : verbose_(verbose), allocation_count_(0), deallocation_count_(0) {
+        constexpr std::array<size_t, TIER_COUNT> counts = {Tiers::block_count...};
+        size_t index = 0;
+        for (size_t tier = 0; tier < TIER_COUNT; ++tier) {
+            for (size_t i = 0; i < counts[tier]; ++i) {
+                blocks_[index++] = std::make_unique<MemoryBlock>(TIER_BLOCK_SIZES[tier]);
+            }
+        }
+    }
+
+    BasicPoolManager(const BasicPoolManager&) = delete;
+    BasicPoolManager& operator=(const BasicPoolManager&) = delete;
+
+    /**
+     * @brief 分配内存
+     * @param size 申请的大小
+     * @return 指向分配内存的指针，超过 MAX_ALLOCATION 或所有可用块都已满时返回nullptr
+     */
+    void* allocate(size_t size) {
+        if (size == 0 || size > MAX_ALLOCATION) return nullptr;
+
+        size_t aligned_size = align_up(size, MemoryBlock::ALIGNMENT);
+
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+        for (size_t i = TIER_BEGIN[tier_for(size)]; i < BLOCK_COUNT; ++i) {
+            // 使用缓存的最大空闲块大小进行快速检查
+            if (blocks_[i]->get_cached_max_free_size() >= aligned_size) {
+                void* ptr = blocks_[i]->allocate(size);
+                if (ptr) {
+                    allocation_count_++;
+                    return ptr;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief 释放内存
+     * @param ptr 待释放的指针
+     * @return 是否释放成功
+     */
+    bool deallocate(void* ptr) {
+        if (!ptr) return false;
+
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+        for (auto& block : blocks_) {
+            if (block->contains(ptr)) {
+                if (block->deallocate(ptr)) {
+                    deallocation_count_++;
+                    return true;
+                }
+                return false;
+            }
+        }
+
+        if (verbose_) {
+            std::cerr << "[WARNING] 无法找到待释放的指针: " << ptr << std::endl;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 指针是否属于本管理器
+     */
+    bool owns(void* ptr) const {
+        for (const auto& block : blocks_) {
+            if (block->contains(ptr)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 把闲置超过 decay 的空闲内存还给操作系统
+     * @return 本次新还回的字节数
+     */
+    size_t purge_idle_memory(std::chrono::milliseconds decay) {
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+        size_t purged = 0;
+        for (auto& block : blocks_) {
+            purged += block->purge_idle(decay);
+        }
+        return purged;
+    }
+
+    /**
+     * @brief 获取分配的总内存大小（编译期常量）
+     */
+    static constexpr size_t get_total_allocated() { return TOTAL_SIZE; }
+
+    /**
+     * @brief 获取使用的总内存大小
+     */
+    size_t get_total_used() const {
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+        size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block->get_used_size();
+        }
+        return total;
+    }
+
+    /**
+     * @brief 打印各层级的统计信息
+     */
+    void print_stats() const {
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+
+        std::cout << std::endl << "========== BasicPoolManager<" << TIER_COUNT << " tiers> Statistics =========="
+                  << std::endl;
+        std::cout << "Total Allocated: " << (double)TOTAL_SIZE / (1024 * 1024) << " MB" << std::endl;
+        std::cout << "Allocation Count: " << allocation_count_.load() << std::endl;
+        std::cout << "Deallocation Count: " << deallocation_count_.load() << std::endl;
+
+        for (size_t tier = 0; tier < TIER_COUNT; ++tier) {
+            size_t end = tier + 1 < TIER_COUNT ? TIER_BEGIN[tier + 1] : BLOCK_COUNT;
+            size_t used = 0;
+            for (size_t i = TIER_BEGIN[tier]; i < end; ++i) {
+                used += blocks_[i]->get_used_size();
+            }
+            std::cout << "Tier " << tier << ": " << end - TIER_BEGIN[tier] << " x "
+                      << TIER_BLOCK_SIZES[tier] / 1024 << " KB, max allocation " << TIER_LIMITS[tier]
+                      << " B, used " << used / 1024 << " KB" << std::endl;
+        }
+        std::cout << "================================================" << std::endl;
+    }
+
+private:
+    std::array<std::unique_ptr<MemoryBlock>, BLOCK_COUNT> blocks_;  // 按层级顺序排列的所有块
+    const bool verbose_;                        // 是否打印诊断信息
+    std::atomic<size_t> allocation_count_;      // 分配计数
+    std::atomic<size_t> deallocation_count_;    // 释放计数
+    mutable std::mutex manager_mutex_;          // 保护管理器结构
+};
+
+/**
+ * @brief 与 MemoryPoolConfig 默认值相同的分层：10 x 256KB、10 x 1MB、10 x 4MB
+ */
+using DefaultPoolManager = BasicPoolManager<
+    PoolTier<256 * 1024, 10>,
+    PoolTier<1024 * 1024, 10>,
+    PoolTier<4 * 1024 * 1024, 10>>;
+
+#endif // BASIC_POOL_MANAGER_H
@@ -1,10 +1,16 @@
 #include "memory_pool.h"
+#include "basic_pool_manager.h"
 #include <thread>
 #include <chrono>
 #include <iostream>
 #include <vector>
 #include <cstring>
 #include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 // ============================================================================
 // 测试用例1：基本内存分配和释放
@@ -134,14 +140,14 @@ void test_object_pool() {
     ObjectPool<TestObject> obj_pool(10, 100);
 
     std::cout << "\n[测试] 创建并获取对象..." << std::endl;
-    std::vector<TestObject*> objects;
+    std::vector<PooledPtr<TestObject>> objects;
 
     for (int i = 0; i < 15; ++i) {
-        TestObject* obj = obj_pool.acquire();
+        PooledPtr<TestObject> obj = obj_pool.acquire();
         if (obj) {
             obj->init(i, i * 3.14);
-            objects.push_back(obj);
             std::cout << "  获取对象 " << i << ": id=" << obj->id << ", value=" << obj->value << std::endl;
+            objects.push_back(std::move(obj));
         } else {
             std::cout << "  [警告] 无法获取对象 " << i << std::endl;
         }
@@ -163,12 +169,17 @@ void test_object_pool() {
         std::cout << "[成功] 所有对象数据验证通过" << std::endl;
     }
 
-    // 释放对象
+    // 释放对象：句柄析构时自动归还
     std::cout << "\n[测试] 释放对象..." << std::endl;
     for (size_t i = 0; i < objects.size(); ++i) {
-        if (obj_pool.release(objects[i])) {
-            std::cout << "  释放对象 " << i << std::endl;
-        }
+        objects[i].reset();
+        std::cout << "  释放对象 " << i << std::endl;
+    }
+
+    // 裸指针接口仍然可用，需要手动归还
+    TestObject* raw = obj_pool.acquire_raw();
+    if (!obj_pool.release(raw) || obj_pool.release(raw)) {
+        std::cout << "  [错误] 裸指针归还结果不正确" << std::endl;
     }
 
     obj_pool.print_stats();
@@ -344,6 +355,867 @@ void test_performance() {
     std::cout << "提高缓存局部性，特别是在频繁分配释放场景。" << std::endl;
 }
 
+// ============================================================================
+// 测试用例7：小对象 slab 分配
+// ============================================================================
+
+void test_small_object_slab() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试7：小对象 slab 分配（<= 256 字节）" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    const int COUNT = 100000;
+
+    // 对比：关闭 slab 时小对象走 MemoryBlock 路径，每个对象带一个块头
+    MemoryPoolConfig block_config;
+    block_config.enable_slab = false;
+    MemoryPoolManager block_pool(block_config);
+    MemoryPoolManager slab_pool;
+
+    std::vector<void*> block_ptrs;
+    std::vector<void*> slab_ptrs;
+    block_ptrs.reserve(COUNT);
+    slab_ptrs.reserve(COUNT);
+
+    std::cout << "\n[测试] 分配 " << COUNT << " 个 1~256 字节的小对象..." << std::endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < COUNT; ++i) {
+        size_t size = 1 + (i * 37) % SlabAllocator::MAX_OBJECT_SIZE;
+        void* ptr = slab_pool.allocate(size);
+        if (!ptr) {
+            std::cerr << "[错误] slab 分配失败，大小: " << size << std::endl;
+            return;
+        }
+        memset(ptr, i & 0xFF, size);
+        slab_ptrs.push_back(ptr);
+    }
+    auto slab_time = std::chrono::high_resolution_clock::now();
+
+    // MemoryBlock 路径是首次适配的线性扫描，只取少量对象对比内存开销
+    const int BLOCK_COUNT = 2000;
+    size_t requested = 0;
+    for (int i = 0; i < BLOCK_COUNT; ++i) {
+        size_t size = 1 + (i * 37) % SlabAllocator::MAX_OBJECT_SIZE;
+        block_ptrs.push_back(block_pool.allocate(size));
+        requested += size;
+    }
+
+    // 验证对齐和数据完整性
+    bool ok = true;
+    for (int i = 0; i < COUNT; ++i) {
+        size_t size = 1 + (i * 37) % SlabAllocator::MAX_OBJECT_SIZE;
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(slab_ptrs[i]);
+        if (reinterpret_cast<uintptr_t>(data) % MemoryBlock::ALIGNMENT != 0 ||
+            data[0] != (i & 0xFF) || data[size - 1] != (i & 0xFF)) {
+            ok = false;
+            break;
+        }
+    }
+    std::cout << (ok ? "[成功] 对齐和数据验证通过" : "[错误] 对齐或数据验证失败") << std::endl;
+
+    PoolStatistics block_stats = block_pool.get_statistics();
+    size_t slab_per_object = slab_pool.get_statistics().slab_bytes / COUNT;
+    size_t block_per_object = (block_stats.total_used + BLOCK_COUNT * sizeof(MemoryBlockHeader)) / BLOCK_COUNT;
+
+    std::cout << "[结果] slab 分配耗时: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(slab_time - start).count()
+              << " us" << std::endl;
+    std::cout << "[结果] 平均申请大小: " << requested / BLOCK_COUNT << " 字节" << std::endl;
+    std::cout << "[结果] 每个对象实际占用: slab " << slab_per_object
+              << " 字节 vs MemoryBlock " << block_per_object << " 字节" << std::endl;
+
+    slab_pool.print_all_stats();
+
+    // 重复释放应当被检测出来
+    void* ptr = slab_pool.allocate(32);
+    slab_pool.deallocate(ptr);
+    if (!slab_pool.deallocate(ptr)) {
+        std::cout << "[成功] 检测到重复释放" << std::endl;
+    }
+
+    for (void* p : slab_ptrs) {
+        slab_pool.deallocate(p);
+    }
+    for (void* p : block_ptrs) {
+        block_pool.deallocate(p);
+    }
+
+    PoolStatistics stats = slab_pool.get_statistics();
+    std::cout << "[结果] 全部释放后 slab 已用: " << stats.slab_used << " 字节，保留 slab: "
+              << stats.slab_bytes / 1024 << " KB" << std::endl;
+}
+
+// ============================================================================
+// 测试用例8：闲置内存归还操作系统
+// ============================================================================
+
+void test_idle_purge() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试8：闲置内存归还操作系统（madvise）" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    MemoryPoolManager pool;
+    const size_t SIZE = 2 * 1024 * 1024;
+
+    std::cout << "\n[测试] 分配并写满 2MB，然后释放..." << std::endl;
+    void* ptr = pool.allocate(SIZE);
+    if (!ptr) {
+        std::cerr << "[错误] 分配失败" << std::endl;
+        return;
+    }
+    memset(ptr, 'P', SIZE);
+    pool.deallocate(ptr);
+
+    // 还没有闲置足够久，不应被归还
+    size_t purged = pool.purge_idle_memory(std::chrono::milliseconds(60 * 1000));
+    std::cout << "[结果] 衰减时间 60s 时归还: " << purged << " 字节" << std::endl;
+
+    purged = pool.purge_idle_memory(std::chrono::milliseconds(0));
+    std::cout << "[结果] 衰减时间 0 时归还: " << (double)purged / (1024 * 1024) << " MB" << std::endl;
+
+    // 已经归还的区间不会重复计算
+    size_t again = pool.purge_idle_memory(std::chrono::milliseconds(0));
+    // MADV_FREE 只是标记为可回收，与 MADV_DONTNEED 立即归还的部分分开统计
+    PoolStatistics stats = pool.get_statistics();
+    size_t released = stats.purged_bytes + stats.advised_bytes;
+    std::cout << "[结果] 再次 purge 新归还: " << again << " 字节，累计归还: "
+              << (double)stats.purged_bytes / (1024 * 1024) << " MB，标记可回收: "
+              << (double)stats.advised_bytes / (1024 * 1024) << " MB" << std::endl;
+
+    // 重新分配后，这部分内存重新常驻，从统计中扣除
+    void* reused = pool.allocate(SIZE / 2);
+    memset(reused, 'Q', SIZE / 2);
+    PoolStatistics after = pool.get_statistics();
+    size_t released_after = after.purged_bytes + after.advised_bytes;
+    std::cout << "[结果] 重新分配 1MB 后归还或可回收: " << (double)released_after / (1024 * 1024) << " MB" << std::endl;
+
+    if (purged > 0 && again == 0 && released == purged && released_after + SIZE / 2 <= released + 4096 * 2 &&
+        reinterpret_cast<char*>(reused)[SIZE / 2 - 1] == 'Q') {
+        std::cout << "[成功] purge 统计与重新分配一致" << std::endl;
+    } else {
+        std::cerr << "[错误] purge 统计不一致" << std::endl;
+    }
+
+    pool.deallocate(reused);
+}
+
+// ============================================================================
+// 测试用例9：采样堆分析
+// ============================================================================
+
+// 两个不同的调用点，用于在 profile 中区分
+__attribute__((noinline)) void* profile_site_buffers(MemoryPoolManager& pool) {
+    return pool.allocate(8 * 1024);
+}
+
+__attribute__((noinline)) void* profile_site_messages(MemoryPoolManager& pool) {
+    return pool.allocate(128);
+}
+
+double time_small_allocations(MemoryPoolManager& pool, int count) {
+    std::vector<void*> ptrs(count);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) {
+        ptrs[i] = pool.allocate(64);
+    }
+    for (int i = 0; i < count; ++i) {
+        pool.deallocate(ptrs[i]);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void test_heap_profiler() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试9：采样堆分析（pprof heap_v2 格式）" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    MemoryPoolConfig config;
+    config.heap_profile_interval = 64 * 1024;   // 测试中用较小的间隔，生产环境默认 512KB
+    MemoryPoolManager pool(config);
+    HeapProfiler* profiler = pool.get_heap_profiler();
+
+    std::vector<void*> buffers;
+    std::vector<void*> messages;
+    for (int i = 0; i < 500; ++i) {
+        buffers.push_back(profile_site_buffers(pool));      // 共 4MB
+        messages.push_back(profile_site_messages(pool));    // 共 64KB
+    }
+
+    // 释放一半 buffer，存活视图应当随之下降
+    for (size_t i = 0; i < buffers.size() / 2; ++i) {
+        pool.deallocate(buffers[i]);
+    }
+
+    HeapProfilerStats stats = profiler->get_stats();
+    std::cout << "\n[结果] 采样分配: " << stats.sampled_allocations << "，采样释放: " << stats.sampled_frees
+              << "，存活采样: " << stats.live_samples << "，调用栈: " << stats.stack_count << std::endl;
+
+    std::string live = profiler->dump(ProfileView::LIVE);
+    std::string cumulative = profiler->dump(ProfileView::CUMULATIVE);
+    std::cout << "[结果] 存活视图头部: " << live.substr(0, live.find('\n')) << std::endl;
+    std::cout << "[结果] 累计视图头部: " << cumulative.substr(0, cumulative.find('\n')) << std::endl;
+
+    if (live.rfind("heap profile: ", 0) == 0 && live.find("@ heap_v2/65536") != std::string::npos &&
+        live.find("MAPPED_LIBRARIES:") != std::string::npos &&
+        stats.sampled_allocations > stats.sampled_frees && stats.sampled_frees > 0) {
+        std::cout << "[成功] profile 格式和存活/累计计数正确" << std::endl;
+    } else {
+        std::cerr << "[错误] profile 内容不符合预期" << std::endl;
+    }
+
+    for (size_t i = buffers.size() / 2; i < buffers.size(); ++i) {
+        pool.deallocate(buffers[i]);
+    }
+    for (void* ptr : messages) {
+        pool.deallocate(ptr);
+    }
+
+    // 默认 512KB 间隔下的开销
+    const int COUNT = 200000;
+    MemoryPoolManager plain_pool;
+    MemoryPoolConfig sampled_config;
+    sampled_config.heap_profile_interval = 512 * 1024;
+    MemoryPoolManager sampled_pool(sampled_config);
+
+    time_small_allocations(plain_pool, COUNT);      // 预热
+    time_small_allocations(sampled_pool, COUNT);
+    double plain_ms = time_small_allocations(plain_pool, COUNT);
+    double sampled_ms = time_small_allocations(sampled_pool, COUNT);
+    std::cout << "[结果] " << COUNT << " 次 64 字节分配/释放：关闭采样 " << std::fixed << std::setprecision(2)
+              << plain_ms << " ms，开启采样 " << sampled_ms << " ms" << std::endl;
+}
+
+// ============================================================================
+// 测试用例10：分配标签与子系统内存预算
+// ============================================================================
+
+void test_memory_tags() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试10：分配标签与子系统内存预算" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    MemoryPoolManager pool;
+    MemoryTag cache_tag = pool.register_tag("cache", 64 * 1024, 128 * 1024);
+    MemoryTag network_tag = pool.register_tag("network");
+
+    std::cout << "\n[测试] cache 子系统持续分配 4KB，直到触发硬限制（128KB）..." << std::endl;
+    std::vector<void*> cache_ptrs;
+    for (int i = 0; i < 64; ++i) {
+        void* ptr = pool.allocate(4096, cache_tag);
+        if (!ptr) {
+            std::cout << "[结果] 第 " << i + 1 << " 次分配被拒绝，cache 占用: "
+                      << pool.get_tag_usage(cache_tag) / 1024 << " KB" << std::endl;
+            break;
+        }
+        cache_ptrs.push_back(ptr);
+    }
+
+    // 作用域标签：小对象和大对象都计入 network
+    std::vector<void*> network_ptrs;
+    {
+        ScopedMemoryTag scope(network_tag);
+        for (int i = 0; i < 100; ++i) {
+            network_ptrs.push_back(pool.allocate(100));
+        }
+        network_ptrs.push_back(pool.allocate(64 * 1024));
+    }
+    void* untagged = pool.allocate(1000);
+
+    PoolStatistics stats = pool.get_statistics();
+    for (const auto& tag : stats.tag_stats) {
+        std::cout << "  " << std::setw(10) << tag.name << ": 占用 " << tag.used << " 字节，峰值 " << tag.peak
+                  << "，分配 " << tag.allocation_count << " 次，拒绝 " << tag.rejected_count
+                  << " 次，超过软限制 " << tag.soft_exceeded << " 次" << std::endl;
+    }
+
+    bool limited = cache_ptrs.size() == 32 && stats.tag_stats[cache_tag].rejected_count == 1 &&
+                   stats.tag_stats[cache_tag].soft_exceeded == 1;
+    bool attributed = stats.tag_stats[network_tag].used == 100 * 112 + 64 * 1024 &&
+                      stats.tag_stats[UNTAGGED].used >= 1000;
+    std::cout << (limited ? "[成功] 硬限制和软限制生效" : "[错误] 限制未按预期生效") << std::endl;
+    std::cout << (attributed ? "[成功] 作用域标签计数正确" : "[错误] 标签计数不正确") << std::endl;
+
+    for (void* ptr : cache_ptrs) {
+        pool.deallocate(ptr);
+    }
+    for (void* ptr : network_ptrs) {
+        pool.deallocate(ptr);
+    }
+    pool.deallocate(untagged);
+
+    stats = pool.get_statistics();
+    bool released = true;
+    for (const auto& tag : stats.tag_stats) {
+        released = released && tag.used == 0;
+    }
+    std::cout << (released ? "[成功] 释放后所有标签归零" : "[错误] 释放后标签未归零") << std::endl;
+}
+
+// ============================================================================
+// 测试用例11：分配轨迹录制与回放
+// ============================================================================
+
+void test_allocation_trace() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试11：分配轨迹录制与回放" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    const std::string trace_path = "/tmp/mem_pool_trace.bin";
+    const int THREADS = 4;
+    const int OPERATIONS = 20000;
+
+    // 录制：多个线程以"请求-响应"的模式分配，大部分对象很快释放，少量长期持有
+    size_t recorded = 0;
+    {
+        MemoryPoolConfig config;
+        config.trace_path = trace_path;
+        MemoryPoolManager pool(config);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&pool, t]() {
+                std::vector<void*> short_lived;
+                std::vector<void*> long_lived;
+                for (int i = 0; i < OPERATIONS; ++i) {
+                    size_t size = (i % 50 == 0) ? 8192 + (i % 7) * 4096 : 16 + ((i * 31 + t) % 480);
+                    void* ptr = pool.allocate(size);
+                    if (!ptr) continue;
+                    if (i % 100 == 0) {
+                        long_lived.push_back(ptr);
+                    } else {
+                        short_lived.push_back(ptr);
+                    }
+                    if (short_lived.size() > 32) {
+                        pool.deallocate(short_lived.front());
+                        short_lived.erase(short_lived.begin());
+                    }
+                }
+                for (void* ptr : short_lived) pool.deallocate(ptr);
+                for (void* ptr : long_lived) pool.deallocate(ptr);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        recorded = pool.get_trace_recorder()->get_event_count();
+        pool.get_trace_recorder()->flush();
+        std::cout << "[INFO] 录制了 " << recorded << " 个事件，文件大小 "
+                  << pool.get_trace_recorder()->get_bytes_written() / 1024 << " KB" << std::endl;
+
+        size_t buffers = pool.get_trace_recorder()->get_thread_buffer_count();
+        std::cout << (buffers == 0 ? "[成功] 录制线程退出后缓冲区已回收" : "[错误] 已退出线程的缓冲区没有回收")
+                  << "（剩余 " << buffers << " 个）" << std::endl;
+    }
+
+    AllocationTrace trace;
+    if (!load_allocation_trace(trace_path, trace)) {
+        std::cerr << "[错误] 轨迹加载失败" << std::endl;
+        return;
+    }
+
+    bool complete = trace.events.size() == recorded && trace.dropped_frees == 0 &&
+                    trace.thread_count == THREADS && trace.object_count * 2 == recorded;
+    std::cout << (complete ? "[成功] 轨迹完整，每次分配都有对应的释放" : "[错误] 轨迹不完整") << std::endl;
+
+    // 同一进程内依次回放（隔离测量请用 trace_replay 工具）
+    std::vector<ReplayResult> results;
+    MallocBackend malloc_backend;
+    results.push_back(replay_trace(trace, malloc_backend));
+
+    PoolBackend pool_backend{MemoryPoolConfig()};
+    results.push_back(replay_trace(trace, pool_backend));
+
+    MemoryPoolConfig no_slab;
+    no_slab.enable_slab = false;
+    PoolBackend no_slab_backend(no_slab, "pool:slab=0");
+    results.push_back(replay_trace(trace, no_slab_backend));
+
+    print_replay_results(trace, results);
+
+    bool replayed = true;
+    for (const auto& result : results) {
+        replayed = replayed && result.failed_allocations == 0 && result.peak_live_bytes == trace.peak_live_bytes;
+    }
+    std::cout << (replayed ? "[成功] 所有后端完整回放" : "[错误] 回放出现失败的分配") << std::endl;
+
+    std::remove(trace_path.c_str());
+}
+
+// ============================================================================
+// 测试用例12：对象池回收与重置钩子
+// ============================================================================
+
+/**
+ * @brief 消息缓冲区：reset() 只清空内容，保留已分配的容量
+ */
+struct MessageBuffer {
+    std::vector<char> payload;
+    std::vector<std::string> headers;
+    int sequence = 0;
+
+    void reset() {
+        payload.clear();
+        headers.clear();
+        sequence = 0;
+    }
+};
+
+/**
+ * @brief 没有 reset() 成员的类型，通过特化 ObjectPoolReset 提供重置逻辑
+ */
+struct RawPacket {
+    char data[256];
+    size_t length = 0;
+};
+
+template<>
+struct ObjectPoolReset<RawPacket> {
+    void operator()(RawPacket& packet) const { packet.length = 0; }
+};
+
+void test_object_recycling() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试12：对象池回收与重置钩子" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    const int WORKERS = 4;
+    const int ROUNDS = 10000;
+    ObjectPool<MessageBuffer> buffers(WORKERS, WORKERS);
+
+    // 预热：每个缓冲区扩展到 4KB
+    {
+        std::vector<PooledPtr<MessageBuffer>> warm;
+        for (int i = 0; i < WORKERS; ++i) {
+            warm.push_back(buffers.acquire());
+            warm.back()->payload.resize(4096);
+            warm.back()->headers.resize(8);
+        }
+    }
+
+    std::cout << "\n[测试] " << WORKERS << " 个线程反复获取/填充/归还消息缓冲区..." << std::endl;
+    std::atomic<size_t> reallocations(0);
+    std::atomic<size_t> dirty(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < WORKERS; ++t) {
+        threads.emplace_back([&buffers, &reallocations, &dirty, t]() {
+            for (int i = 0; i < ROUNDS; ++i) {
+                PooledPtr<MessageBuffer> msg = buffers.acquire();
+                if (!msg) continue;
+                if (!msg->payload.empty() || msg->sequence != 0) {
+                    dirty++;
+                }
+                const char* before = msg->payload.data();
+                msg->payload.resize(1024 + (i + t) % 3072, 'x');
+                if (msg->payload.data() != before) {
+                    reallocations++;
+                }
+                msg->sequence = i;
+            }   // 离开作用域自动归还并重置
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "[结果] 容量: " << buffers.get_capacity() << "，重新分配次数: " << reallocations.load()
+              << "，取到未重置对象: " << dirty.load() << std::endl;
+    bool recycled = buffers.get_capacity() == WORKERS && buffers.get_used_count() == 0 &&
+                    reallocations == 0 && dirty == 0;
+    std::cout << (recycled ? "[成功] 缓冲区被重置且保留容量，稳定状态无重新分配" : "[错误] 缓冲区复用不符合预期")
+              << std::endl;
+
+    // 特化的重置策略
+    ObjectPool<RawPacket> packets(1, 1);
+    {
+        PooledPtr<RawPacket> packet = packets.acquire();
+        packet->length = 128;
+        PooledPtr<RawPacket> none = packets.acquire();
+        std::cout << (none ? "[错误] 池满时仍然返回了对象" : "[成功] 池满时返回空句柄") << std::endl;
+    }
+    PooledPtr<RawPacket> packet = packets.acquire();
+    std::cout << (packet && packet->length == 0 ? "[成功] 特化的重置策略生效" : "[错误] 特化的重置策略未生效")
+              << std::endl;
+}
+
+// ============================================================================
+// 测试用例13：对象池收缩与批量获取/归还
+// ============================================================================
+
+void test_object_pool_trim_and_batch() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试13：对象池收缩与批量获取/归还" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    ObjectPool<MessageBuffer> pool(16, 4096, ObjectPoolTrimPolicy(0.5));
+
+    // 突发：一次性取出 2000 个对象
+    std::cout << "\n[测试] 突发获取 2000 个对象后归还，之后每个周期只用 20 个..." << std::endl;
+    std::vector<PooledPtr<MessageBuffer>> burst;
+    size_t got = pool.acquire_n(2000, burst);
+    size_t returned = pool.release_n(burst);
+    std::cout << "[结果] 批量获取 " << got << " 个，批量归还 " << returned << " 个，容量 " << pool.get_capacity()
+              << std::endl;
+
+    std::vector<size_t> capacities;
+    for (int cycle = 0; cycle < 10; ++cycle) {
+        MessageBuffer* steady[20];
+        size_t n = pool.acquire_n(steady, 20);
+        pool.release_n(steady, n);
+        pool.trim();
+        capacities.push_back(pool.get_capacity());
+    }
+
+    std::cout << "[结果] 每个周期 trim 后的容量:";
+    for (size_t capacity : capacities) {
+        std::cout << " " << capacity;
+    }
+    std::cout << std::endl;
+
+    // 第一个周期仍然包含突发峰值，之后按 0.5 衰减，最终收缩到稳定用量（不低于初始容量）
+    bool gradual = capacities[0] == 2000 && capacities[1] == 1000 && capacities.back() == 20 &&
+                   std::is_sorted(capacities.rbegin(), capacities.rend());
+    std::cout << (gradual ? "[成功] 突发过后容量按衰减高水位逐步收缩" : "[错误] 收缩过程不符合预期") << std::endl;
+    pool.print_stats();
+
+    // 批量接口与逐个接口的开销对比
+    const int ROUNDS = 20000;
+    const size_t BATCH = 32;
+    ObjectPool<MessageBuffer> bench(BATCH, BATCH);
+    MessageBuffer* items[BATCH];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < BATCH; ++i) items[i] = bench.acquire_raw();
+        for (size_t i = 0; i < BATCH; ++i) bench.release(items[i]);
+    }
+    auto single_end = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        size_t n = bench.acquire_n(items, BATCH);
+        bench.release_n(items, n);
+    }
+    auto batch_end = std::chrono::high_resolution_clock::now();
+
+    auto single_us = std::chrono::duration_cast<std::chrono::microseconds>(single_end - start).count();
+    auto batch_us = std::chrono::duration_cast<std::chrono::microseconds>(batch_end - single_end).count();
+    std::cout << "\n[性能] " << ROUNDS << " 轮 x " << BATCH << " 个对象：逐个 " << single_us << " us，批量 "
+              << batch_us << " us" << std::endl;
+}
+
+// ============================================================================
+// 测试用例14：编译期分层配置
+// ============================================================================
+
+using TinyPoolManager = BasicPoolManager<PoolTier<4 * 1024, 4>, PoolTier<64 * 1024, 2>, PoolTier<1024 * 1024, 1>>;
+
+static_assert(DefaultPoolManager::TIER_COUNT == 3, "default tiers");
+static_assert(DefaultPoolManager::tier_for(1) == 0, "tiny allocations go to the first tier");
+static_assert(DefaultPoolManager::tier_for(DefaultPoolManager::TIER_LIMITS[0]) == 0, "tier 0 upper bound");
+static_assert(DefaultPoolManager::tier_for(DefaultPoolManager::TIER_LIMITS[0] + 1) == 1, "tier 1 lower bound");
+static_assert(DefaultPoolManager::tier_for(DefaultPoolManager::MAX_ALLOCATION) == 2, "largest allocation");
+static_assert(TinyPoolManager::get_total_allocated() == 4 * 4096 + 2 * 65536 + 1024 * 1024, "constexpr size");
+
+void test_compile_time_tiers() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试14：编译期分层配置" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    // 查表路由与逐层比较的结果一致
+    std::cout << "\n[测试] 校验查表路由..." << std::endl;
+    size_t mismatches = 0;
+    for (size_t size = 1; size <= TinyPoolManager::MAX_ALLOCATION; size += (size < 70000 ? 1 : 997)) {
+        size_t expected = 0;
+        while (size > TinyPoolManager::TIER_LIMITS[expected]) {
+            expected++;
+        }
+        if (TinyPoolManager::tier_for(size) != expected) {
+            mismatches++;
+        }
+    }
+    std::cout << (mismatches == 0 ? "[成功] 所有大小都路由到能容纳它的最小层级" : "[错误] 路由结果与逐层比较不一致")
+              << std::endl;
+
+    // 小层级放满后落到更大的层级
+    TinyPoolManager tiny;
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 40; ++i) {
+        void* ptr = tiny.allocate(2000);
+        if (!ptr) break;
+        ptrs.push_back(ptr);
+    }
+    bool oversize_rejected = tiny.allocate(TinyPoolManager::MAX_ALLOCATION + 1) == nullptr;
+    tiny.print_stats();
+    std::cout << "[结果] 2000 字节的分配成功 " << ptrs.size() << " 次" << std::endl;
+    for (void* ptr : ptrs) {
+        tiny.deallocate(ptr);
+    }
+    bool released = tiny.get_total_used() == 0;
+    std::cout << (ptrs.size() > 8 && oversize_rejected && released ? "[成功] 层级溢出、超限拒绝和释放均正确"
+                                                                   : "[错误] 分层分配结果不正确")
+              << std::endl;
+
+    // 关闭 verbose 时释放不属于本管理器的指针只返回 false，不写 stderr
+    TinyPoolManager quiet(false);
+    int foreign = 0;
+    std::cout << (!quiet.deallocate(&foreign) ? "[成功] 静默模式下拒绝外部指针" : "[错误] 外部指针被误释放")
+              << std::endl;
+
+    // 与运行时配置的管理器对比（关闭 slab，只比较分层路径）
+    const int COUNT = 20000;
+    MemoryPoolConfig config;
+    config.enable_slab = false;
+    MemoryPoolManager runtime_pool(config);
+    DefaultPoolManager static_pool;
+
+    auto run = [COUNT](auto& pool) {
+        std::vector<void*> live;
+        live.reserve(64);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < COUNT; ++i) {
+            live.push_back(pool.allocate(64 + (i * 97) % 200000));
+            if (live.size() == 64) {
+                for (void* ptr : live) pool.deallocate(ptr);
+                live.clear();
+            }
+        }
+        for (void* ptr : live) pool.deallocate(ptr);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    };
+
+    auto runtime_us = run(runtime_pool);
+    auto static_us = run(static_pool);
+    std::cout << "\n[性能] " << COUNT << " 次分配/释放：MemoryPoolManager " << runtime_us << " us，DefaultPoolManager "
+              << static_us << " us" << std::endl;
+}
+
+// ============================================================================
+// 测试用例15：指针归属与可用大小（malloc 替换层依赖的接口）
+// ============================================================================
+
+void test_owns_and_usable_size() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试15：指针归属与可用大小" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    MemoryPoolConfig config;
+    config.verbose = false;     // malloc 替换层中不能打印
+    MemoryPoolManager pool(config);
+
+    void* small = pool.allocate(100);       // slab
+    void* medium = pool.allocate(5000);     // MemoryBlock
+    void* foreign = std::malloc(100);
+
+    bool owned = pool.owns(small) && pool.owns(medium) && !pool.owns(foreign);
+    bool usable = pool.usable_size(small) >= 100 && pool.usable_size(medium) >= 5000 &&
+                  pool.usable_size(foreign) == 0;
+    std::cout << "[结果] slab 对象可用 " << pool.usable_size(small) << " 字节，块对象可用 "
+              << pool.usable_size(medium) << " 字节" << std::endl;
+    std::cout << (owned ? "[成功] 指针归属判断正确" : "[错误] 指针归属判断错误") << std::endl;
+    std::cout << (usable ? "[成功] 可用大小不小于申请大小" : "[错误] 可用大小不正确") << std::endl;
+
+    // 超过最大块的申请在 verbose 关闭时静默失败
+    void* oversized = pool.allocate(config.large_block_size * 2);
+    std::cout << (oversized == nullptr ? "[成功] 超大申请静默返回nullptr" : "[错误] 超大申请没有失败") << std::endl;
+
+    pool.deallocate(small);
+    pool.deallocate(medium);
+    std::free(foreign);
+
+    std::cout << "[INFO] 整个进程的堆路由到内存池：LD_PRELOAD=libmemory_pool_shim.so ./app" << std::endl;
+}
+
+// ============================================================================
+// 测试用例16：内存压力回调与软限制
+// ============================================================================
+
+/**
+ * @brief 等待条件成立（回调在通知线程中异步执行）
+ */
+template<typename Predicate>
+static bool wait_until_true(Predicate pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void test_memory_pressure() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试16：内存压力回调与软限制" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    MemoryPoolConfig config;
+    config.verbose = false;
+    config.soft_memory_limit = 1024 * 1024;     // 1MB，只用于计算使用比例
+    MemoryPoolManager pool(config);
+
+    // 模拟缓存：4KB 的条目，压力到 95% 时淘汰最旧的条目直到 50% 以下
+    std::mutex cache_mutex;
+    std::vector<void*> cache;
+    std::mutex events_mutex;
+    std::vector<double> fired;
+    std::atomic<size_t> shed_count{0};
+
+    auto record = [&](const MemoryPressureEvent& event) {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        fired.push_back(event.threshold);
+    };
+    auto fired_count = [&]() {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        return fired.size();
+    };
+
+    pool.register_pressure_callback(0.70, record);
+    pool.register_pressure_callback(0.85, record);
+    size_t shed_id = pool.register_pressure_callback(0.95, [&](const MemoryPressureEvent& event) {
+        record(event);
+        if (event.source != PressureSource::POOL_USAGE) return;
+
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        size_t target = pool.get_memory_limit() / 2;
+        size_t shed = 0;
+        while (!cache.empty() && pool.get_bytes_in_use() > target) {
+            pool.deallocate(cache.front());
+            cache.erase(cache.begin());
+            shed++;
+        }
+        shed_count.fetch_add(shed);
+    });
+
+    // 按本次新增的字节数计算填充量，回调在填充过程中淘汰条目也不会让填充无限进行
+    auto fill_to = [&](double ratio) {
+        double target = ratio * pool.get_memory_limit() - pool.get_bytes_in_use();
+        double added = 0;
+        while (added < target) {
+            void* ptr = pool.allocate(4096);
+            if (!ptr) break;
+            added += pool.usable_size(ptr);
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            cache.push_back(ptr);
+        }
+    };
+
+    std::cout << "\n[测试] 缓存填充到 96%，依次跨过 70% / 85% / 95%..." << std::endl;
+    fill_to(0.96);
+    bool first_round = wait_until_true([&]() { return fired_count() >= 3 && shed_count.load() > 0; });
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        bool ordered = first_round && fired.size() == 3 && std::is_sorted(fired.begin(), fired.end());
+        std::cout << "[结果] 回调顺序:";
+        for (double threshold : fired) {
+            std::cout << " " << static_cast<int>(threshold * 100 + 0.5) << "%";
+        }
+        std::cout << "，95% 回调淘汰了 " << shed_count.load() << " 个缓存条目，当前使用 "
+                  << pool.get_bytes_in_use() / 1024 << " KB" << std::endl;
+        std::cout << (ordered ? "[成功] 每个阈值只触发一次，且按阈值从低到高" : "[错误] 回调次数或顺序不正确") << std::endl;
+    }
+
+    std::cout << "\n[测试] 淘汰后回落到阈值以下重新布防，再填充到 90%..." << std::endl;
+    fill_to(0.90);
+    bool rearmed = wait_until_true([&]() { return fired_count() >= 5; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        size_t high = static_cast<size_t>(std::count(fired.begin(), fired.end(), 0.95));
+        std::cout << "[结果] 共触发 " << fired.size() << " 次回调" << std::endl;
+        std::cout << (rearmed && fired.size() == 5 && high == 1 ? "[成功] 70% / 85% 重新触发，95% 未触发"
+                                                                 : "[错误] 重新布防不正确") << std::endl;
+    }
+
+    bool removed = pool.unregister_pressure_callback(shed_id) && !pool.unregister_pressure_callback(shed_id);
+    std::cout << (removed ? "[成功] 注销回调" : "[错误] 注销回调失败") << std::endl;
+
+    // 内核 PSI：系统或所在 cgroup 因内存不足停顿时以 SYSTEM_PSI 调用所有回调
+    if (pool.enable_psi_monitor()) {
+        std::cout << "[INFO] 已注册 PSI 触发器（some 150ms / 2s），系统内存紧张时会通知缓存收缩" << std::endl;
+    } else {
+        std::cout << "[INFO] 当前环境不支持 PSI，只使用池内使用量阈值" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (void* ptr : cache) {
+        pool.deallocate(ptr);
+    }
+    cache.clear();
+}
+
+// ============================================================================
+// 测试用例17：启动预热（预缺页与 mlock）
+// ============================================================================
+
+/**
+ * @brief 在 3 个大块中各分配 3MB 并写满，返回耗时（毫秒）
+ */
+static double time_first_touch(MemoryPoolManager& pool) {
+    const size_t size = 3 * 1024 * 1024;
+    std::vector<void*> ptrs;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        void* ptr = pool.allocate(size);
+        if (ptr) {
+            std::memset(ptr, 0x5A, size);
+            ptrs.push_back(ptr);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    for (void* ptr : ptrs) {
+        pool.deallocate(ptr);
+    }
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void test_warm_up() {
+    std::cout << "\n" << std::string(80, '=') << std::endl;
+    std::cout << "测试17：启动预热（预缺页与 mlock）" << std::endl;
+    std::cout << std::string(80, '=') << std::endl;
+
+    MemoryPoolConfig config(256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 4);
+    config.verbose = false;
+    config.purge_decay_ms = 0;      // 避免释放后被 purge 影响对比
+
+    std::cout << "\n[测试] 未预热：首次写入 9MB 在请求路径上缺页..." << std::endl;
+    MemoryPoolManager cold(config);
+    double cold_ms = time_first_touch(cold);
+
+    std::cout << "[测试] 预热后：同样的写入不再缺页..." << std::endl;
+    MemoryPoolManager warm(config);
+    WarmUpReport report = warm.warm_up();
+    double warm_ms = time_first_touch(warm);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "[结果] 预热 " << report.blocks << " 个块 " << report.bytes_prefaulted / (1024 * 1024) << " MB，"
+              << report.threads << " 个线程，" << report.numa_nodes << " 个 NUMA 节点，"
+              << (report.populate_supported ? "MADV_POPULATE_WRITE" : "逐页写入") << "，耗时 "
+              << report.elapsed_ms << " ms" << std::endl;
+    std::cout << "[结果] 首次写入耗时：未预热 " << cold_ms << " ms，预热后 " << warm_ms << " ms" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+
+    std::cout << (report.bytes_prefaulted >= warm.get_total_allocated() ? "[成功] 所有层级都已预缺页"
+                                                                         : "[错误] 预缺页字节数不足") << std::endl;
+    std::cout << (warm_ms < cold_ms ? "[成功] 预热后首次写入更快" : "[警告] 预热后首次写入没有变快") << std::endl;
+
+    std::cout << "\n[测试] 预热并 mlock 锁定..." << std::endl;
+    MemoryPoolConfig small_config(64 * 1024, 256 * 1024, 1024 * 1024, 2);
+    small_config.verbose = false;
+    MemoryPoolManager locked(small_config);
+    WarmUpPolicy policy;
+    policy.threads = 2;
+    policy.lock_memory = true;
+    WarmUpReport lock_report = locked.warm_up(policy);
+    std::cout << "[结果] 锁定 " << lock_report.bytes_locked / 1024 << " KB，失败 "
+              << lock_report.lock_failures << " 个块" << std::endl;
+    bool no_purge = locked.purge_idle_memory(std::chrono::milliseconds(0)) == 0 || lock_report.bytes_locked == 0;
+    std::cout << (no_purge ? "[成功] 锁定的块不会被 purge" : "[错误] 锁定的块被 purge") << std::endl;
+}
+
 // ============================================================================
 // 主函数
 // ============================================================================
@@ -359,6 +1231,17 @@ int main() {
     std::cout << "║  ✓ 灵活的对象池管理                                                          ║" << std::endl;
     std::cout << "║  ✓ 内存对齐支持（SSE/AVX优化）                                              ║" << std::endl;
     std::cout << "║  ✓ 全面的统计和监控                                                          ║" << std::endl;
+    std::cout << "║  ✓ 小对象 slab 快速路径（无对象头）                                          ║" << std::endl;
+    std::cout << "║  ✓ 闲置内存按衰减时间归还操作系统                                            ║" << std::endl;
+    std::cout << "║  ✓ 采样堆分析，导出 pprof 格式                                              ║" << std::endl;
+    std::cout << "║  ✓ 分配标签与子系统内存预算                                                  ║" << std::endl;
+    std::cout << "║  ✓ 分配轨迹录制与回放对比                                                    ║" << std::endl;
+    std::cout << "║  ✓ 对象池 RAII 句柄与重置钩子                                                ║" << std::endl;
+    std::cout << "║  ✓ 对象池衰减高水位收缩与批量接口                                            ║" << std::endl;
+    std::cout << "║  ✓ 编译期分层配置与查表路由                                                  ║" << std::endl;
+    std::cout << "║  ✓ malloc/new 替换层（LD_PRELOAD）                                           ║" << std::endl;
+    std::cout << "║  ✓ 内存压力回调与 PSI 监听                                                   ║" << std::endl;
+    std::cout << "║  ✓ 启动预热（预缺页、NUMA 本地、mlock）                                      ║" << std::endl;
     std::cout << "╚════════════════════════════════════════════════════════════════════════════╝" << std::endl;
 
     try {
@@ -368,6 +1251,17 @@ int main() {
         test_memory_alignment();
         test_thread_safety();
         test_performance();
+        test_small_object_slab();
+        test_idle_purge();
+        test_heap_profiler();
+        test_memory_tags();
+        test_allocation_trace();
+        test_object_recycling();
+        test_object_pool_trim_and_batch();
+        test_compile_time_tiers();
+        test_owns_and_usable_size();
+        test_memory_pressure();
+        test_warm_up();
 
         std::cout << "\n" << std::string(80, '=') << std::endl;
         std::cout << "✓ 所有测试完成！" << std::endl;
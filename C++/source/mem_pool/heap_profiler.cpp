@@ -0,0 +1,272 @@
+#include "heap_profiler.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifndef HEAP_PROFILER_FRAME_POINTERS
+#include <execinfo.h>
+#endif
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t hash_stack(void* const* pcs, uint32_t depth) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ depth;
+    for (uint32_t i = 0; i < depth; ++i) {
+        h = mix64(h ^ reinterpret_cast<uintptr_t>(pcs[i]));
+    }
+    return h == 0 ? 1 : h;
+}
+
+/**
+ * @brief 抓取调用栈，跳过 skip 层（分析器和内存池自身）
+ */
+uint32_t capture_stack(void** pcs, uint32_t max_depth, uint32_t skip) {
+#ifdef HEAP_PROFILER_FRAME_POINTERS
+    // 沿帧指针链回溯：要求编译时带 -fno-omit-frame-pointer，开销只有几次内存读取
+    void** frame = static_cast<void**>(__builtin_frame_address(0));
+    uint32_t depth = 0;
+    while (frame && depth < max_depth + skip) {
+        void* ret = frame[1];
+        if (!ret) {
+            break;
+        }
+        if (depth >= skip) {
+            pcs[depth - skip] = ret;
+        }
+        depth++;
+
+        void** next = static_cast<void**>(frame[0]);
+        // 栈向低地址增长，调用者的帧一定在更高的地址，否则说明链已断开
+        if (next <= frame || reinterpret_cast<uintptr_t>(next) - reinterpret_cast<uintptr_t>(frame) > (1u << 20)) {
+            break;
+        }
+        frame = next;
+    }
+    return depth > skip ? depth - skip : 0;
+#else
+    void* buffer[HeapProfiler::MAX_DEPTH + 8];
+    int total = backtrace(buffer, static_cast<int>(max_depth + skip));
+    if (total <= static_cast<int>(skip)) {
+        return 0;
+    }
+    uint32_t depth = static_cast<uint32_t>(total) - skip;
+    std::memcpy(pcs, buffer + skip, depth * sizeof(void*));
+    return depth;
+#endif
+}
+
+} // namespace
+
+HeapProfiler::HeapProfiler(size_t sample_interval)
+    : sample_interval_(sample_interval > 0 ? sample_interval : 1),
+      stacks_(new StackEntry[STACK_TABLE_SIZE]),
+      pointers_(new PointerEntry[POINTER_TABLE_SIZE]),
+      filter_(new std::atomic<uint16_t>[FILTER_SIZE]),
+      stack_count_(0), live_samples_(0), sampled_allocations_(0), sampled_frees_(0), dropped_samples_(0) {
+    for (size_t i = 0; i < FILTER_SIZE; ++i) {
+        filter_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+HeapProfiler::~HeapProfiler() = default;
+
+bool HeapProfiler::reset_interval(ThreadState& state) {
+    bool first = state.owner != this;
+    if (state.rng == 0) {
+        state.rng = mix64(reinterpret_cast<uintptr_t>(&state) ^
+                          std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+    }
+
+    // xorshift64* 生成 (0, 1] 的均匀分布，再变换为均值 sample_interval_ 的指数分布
+    state.rng ^= state.rng >> 12;
+    state.rng ^= state.rng << 25;
+    state.rng ^= state.rng >> 27;
+    double u = static_cast<double>((state.rng * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+    double interval = -std::log(1.0 - u) * static_cast<double>(sample_interval_);
+
+    // 第一次进入时只初始化间隔，不采样；否则超出部分计入下一个间隔
+    int64_t overshoot = first ? 0 : -state.bytes_until_sample;
+    state.owner = this;
+    state.bytes_until_sample = static_cast<int64_t>(interval) + 1 - overshoot;
+    return !first;
+}
+
+size_t HeapProfiler::intern_stack(void* const* pcs, uint32_t depth) {
+    uint64_t hash = hash_stack(pcs, depth);
+
+    for (size_t probe = 0; probe < STACK_TABLE_SIZE; ++probe) {
+        size_t index = (hash + probe) & (STACK_TABLE_SIZE - 1);
+        StackEntry& entry = stacks_[index];
+
+        uint64_t current = entry.hash.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (entry.hash.compare_exchange_strong(current, hash, std::memory_order_acq_rel)) {
+                entry.depth = depth;
+                std::memcpy(entry.pcs, pcs, depth * sizeof(void*));
+                entry.ready.store(true, std::memory_order_release);
+                stack_count_.fetch_add(1, std::memory_order_relaxed);
+                return index;
+            }
+            // 被其他线程抢先占用，current 已更新为对方的哈希，继续比较
+        }
+
+        if (current == hash) {
+            // 等待插入者写完调用栈（只有几十条指令）
+            while (!entry.ready.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            if (entry.depth == depth && std::memcmp(entry.pcs, pcs, depth * sizeof(void*)) == 0) {
+                return index;
+            }
+        }
+    }
+
+    return STACK_TABLE_SIZE;
+}
+
+void HeapProfiler::record_allocation(void* ptr, size_t size) {
+    if (!ptr) return;
+
+    void* pcs[MAX_DEPTH];
+    uint32_t depth = capture_stack(pcs, MAX_DEPTH, 2);
+
+    size_t stack = intern_stack(pcs, depth);
+    if (stack == STACK_TABLE_SIZE) {
+        dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    StackEntry& entry = stacks_[stack];
+    entry.alloc_count.fetch_add(1, std::memory_order_relaxed);
+    entry.alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    sampled_allocations_.fetch_add(1, std::memory_order_relaxed);
+
+    // 登记到存活对象表，释放时据此扣减
+    uintptr_t key = reinterpret_cast<uintptr_t>(ptr);
+    size_t start = static_cast<size_t>(mix64(key));
+    for (size_t probe = 0; probe < MAX_PROBE; ++probe) {
+        PointerEntry& slot = pointers_[(start + probe) & (POINTER_TABLE_SIZE - 1)];
+        uintptr_t current = slot.key.load(std::memory_order_relaxed);
+        if ((current == EMPTY || current == TOMBSTONE) &&
+            slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+            slot.stack.store(static_cast<uint32_t>(stack), std::memory_order_relaxed);
+            slot.size.store(size, std::memory_order_relaxed);
+            entry.live_count.fetch_add(1, std::memory_order_relaxed);
+            entry.live_bytes.fetch_add(size, std::memory_order_relaxed);
+            live_samples_.fetch_add(1, std::memory_order_relaxed);
+            filter_[filter_index(ptr)].fetch_add(1, std::memory_order_release);
+            return;
+        }
+    }
+
+    // 存活表满：累计视图仍然有效，只是这个对象不会出现在存活视图中
+    dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HeapProfiler::record_free_slow(void* ptr) {
+    uintptr_t key = reinterpret_cast<uintptr_t>(ptr);
+    size_t start = static_cast<size_t>(mix64(key));
+
+    for (size_t probe = 0; probe < MAX_PROBE; ++probe) {
+        PointerEntry& slot = pointers_[(start + probe) & (POINTER_TABLE_SIZE - 1)];
+        uintptr_t current = slot.key.load(std::memory_order_acquire);
+        if (current == EMPTY) {
+            return;     // 不是采样对象
+        }
+        if (current == key) {
+            size_t stack = slot.stack.load(std::memory_order_relaxed);
+            size_t size = slot.size.load(std::memory_order_relaxed);
+            if (!slot.key.compare_exchange_strong(current, TOMBSTONE, std::memory_order_acq_rel)) {
+                return;
+            }
+
+            StackEntry& entry = stacks_[stack];
+            entry.live_count.fetch_sub(1, std::memory_order_relaxed);
+            entry.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+            live_samples_.fetch_sub(1, std::memory_order_relaxed);
+            sampled_frees_.fetch_add(1, std::memory_order_relaxed);
+            filter_[filter_index(ptr)].fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+std::string HeapProfiler::dump(ProfileView view) const {
+    std::ostringstream body;
+    size_t total_live_count = 0;
+    size_t total_live_bytes = 0;
+    size_t total_alloc_count = 0;
+    size_t total_alloc_bytes = 0;
+
+    for (size_t i = 0; i < STACK_TABLE_SIZE; ++i) {
+        const StackEntry& entry = stacks_[i];
+        if (!entry.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        size_t live_count = entry.live_count.load(std::memory_order_relaxed);
+        size_t live_bytes = entry.live_bytes.load(std::memory_order_relaxed);
+        size_t alloc_count = entry.alloc_count.load(std::memory_order_relaxed);
+        size_t alloc_bytes = entry.alloc_bytes.load(std::memory_order_relaxed);
+
+        total_live_count += live_count;
+        total_live_bytes += live_bytes;
+        total_alloc_count += alloc_count;
+        total_alloc_bytes += alloc_bytes;
+
+        if (view == ProfileView::LIVE && live_count == 0) {
+            continue;
+        }
+
+        body << live_count << ": " << live_bytes << " [" << alloc_count << ": " << alloc_bytes << "] @";
+        for (uint32_t d = 0; d < entry.depth; ++d) {
+            body << " 0x" << std::hex << reinterpret_cast<uintptr_t>(entry.pcs[d]) << std::dec;
+        }
+        body << "\n";
+    }
+
+    std::ostringstream out;
+    out << "heap profile: " << total_live_count << ": " << total_live_bytes
+        << " [" << total_alloc_count << ": " << total_alloc_bytes << "] @ heap_v2/" << sample_interval_ << "\n";
+    out << body.str();
+
+    // pprof 用内存映射把地址还原为符号
+    out << "\nMAPPED_LIBRARIES:\n";
+    std::ifstream maps("/proc/self/maps");
+    if (maps) {
+        out << maps.rdbuf();
+    }
+
+    return out.str();
+}
+
+bool HeapProfiler::write_profile(const std::string& path, ProfileView view) const {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << dump(view);
+    return static_cast<bool>(file);
+}
+
+HeapProfilerStats HeapProfiler::get_stats() const {
+    HeapProfilerStats stats;
+    stats.sampled_allocations = sampled_allocations_.load();
+    stats.sampled_frees = sampled_frees_.load();
+    stats.live_samples = live_samples_.load();
+    stats.stack_count = stack_count_.load();
+    stats.dropped_samples = dropped_samples_.load();
+    return stats;
+}
@@ -0,0 +1,175 @@
+#ifndef HEAP_PROFILER_H
+#define HEAP_PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ============================================================================
+// 采样堆分析器（Sampling Heap Profiler）
+// ============================================================================
+
+/**
+ * @brief 导出视图
+ */
+enum class ProfileView {
+    LIVE,           // 只导出仍有存活对象的调用栈（内存增长时看谁持有内存）
+    CUMULATIVE      // 导出所有采样过的调用栈（看谁分配得最多）
+};
+
+/**
+ * @brief 分析器统计信息
+ */
+struct HeapProfilerStats {
+    size_t sampled_allocations;   // 累计采样的分配次数
+    size_t sampled_frees;         // 累计采样对象的释放次数
+    size_t live_samples;          // 当前存活的采样对象数
+    size_t stack_count;           // 不同调用栈数量
+    size_t dropped_samples;       // 表满而丢弃的采样数
+};
+
+/**
+ * @brief 采样堆分析器
+ *
+ * 参考 tcmalloc 的做法：每个线程维护"距离下一次采样还剩多少字节"，按指数分布随机抽取采样间隔
+ * （均值 sample_interval，默认 512KB），这样每个字节被采样的概率相同，大对象几乎必然被采样。
+ *
+ * 1. 快速路径只有一次线程本地变量的减法和比较，未命中采样时不访问任何共享数据
+ * 2. 命中采样时抓取调用栈（默认 backtrace()，定义 HEAP_PROFILER_FRAME_POINTERS 时直接走帧指针链），
+ *    写入无锁的调用栈表和指针表，都是开放寻址 + CAS，不加锁
+ * 3. 释放时先查一个 8KB 的计数过滤器，只有可能是采样对象时才查指针表，命中后扣减对应调用栈的存活计数
+ * 4. 导出为 gperftools 的 heap profile 文本格式（heap_v2），可直接用 pprof 打开：
+ *      pprof --inuse_space ./app heap.prof     # 存活视图
+ *      pprof --alloc_space ./app heap.prof     # 累计视图
+ *    文件中记录的是原始采样值，pprof 根据头部的采样间隔自行还原为估计值
+ */
+class HeapProfiler {
+public:
+    static constexpr size_t MAX_DEPTH = 32;             // 调用栈最大深度
+    static constexpr size_t STACK_TABLE_SIZE = 4096;    // 调用栈表容量（2的幂）
+    static constexpr size_t POINTER_TABLE_SIZE = 65536; // 存活采样对象表容量（2的幂）
+
+    /**
+     * @brief 构造函数
+     * @param sample_interval 平均采样间隔（字节）
+     */
+    explicit HeapProfiler(size_t sample_interval = 512 * 1024);
+
+    ~HeapProfiler();
+
+    HeapProfiler(const HeapProfiler&) = delete;
+    HeapProfiler& operator=(const HeapProfiler&) = delete;
+
+    /**
+     * @brief 判断这次分配是否需要采样（快速路径）
+     * @param size 分配大小
+     */
+    bool should_sample(size_t size) {
+        ThreadState& state = thread_state();
+        if (state.owner == this && (state.bytes_until_sample -= static_cast<int64_t>(size)) > 0) {
+            return false;
+        }
+        return reset_interval(state);
+    }
+
+    /**
+     * @brief 记录一次被采样的分配（抓取调用栈）
+     * @param ptr 分配得到的指针
+     * @param size 分配大小
+     */
+    void record_allocation(void* ptr, size_t size);
+
+    /**
+     * @brief 记录一次释放，ptr 不是采样对象时直接返回
+     */
+    void record_free(void* ptr) {
+        // 先查计数过滤器（8KB，常驻 L1），绝大多数非采样指针在这里返回，不会访问 1.5MB 的指针表
+        if (filter_[filter_index(ptr)].load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        record_free_slow(ptr);
+    }
+
+    /**
+     * @brief 导出 pprof 兼容的 heap profile 文本
+     */
+    std::string dump(ProfileView view = ProfileView::LIVE) const;
+
+    /**
+     * @brief 导出到文件
+     * @return 是否写入成功
+     */
+    bool write_profile(const std::string& path, ProfileView view = ProfileView::LIVE) const;
+
+    HeapProfilerStats get_stats() const;
+
+    size_t get_sample_interval() const { return sample_interval_; }
+
+private:
+    struct ThreadState {
+        const HeapProfiler* owner = nullptr;    // 计数属于哪个分析器，切换实例时重新抽取间隔
+        int64_t bytes_until_sample = 0;         // 距离下一次采样还剩的字节数
+        uint64_t rng = 0;                       // 线程本地随机数状态
+    };
+
+    struct StackEntry {
+        std::atomic<uint64_t> hash{0};          // 0 表示空槽
+        std::atomic<bool> ready{false};         // pcs 写入完成
+        uint32_t depth = 0;
+        void* pcs[MAX_DEPTH];
+        std::atomic<size_t> live_count{0};
+        std::atomic<size_t> live_bytes{0};
+        std::atomic<size_t> alloc_count{0};
+        std::atomic<size_t> alloc_bytes{0};
+    };
+
+    struct PointerEntry {
+        std::atomic<uintptr_t> key{0};          // 0 空槽，1 墓碑
+        std::atomic<uint32_t> stack{0};
+        std::atomic<size_t> size{0};
+    };
+
+    static constexpr uintptr_t EMPTY = 0;
+    static constexpr uintptr_t TOMBSTONE = 1;
+    // 存活表的最大探测长度：墓碑会随时间积累，限制探测长度保证释放路径的开销有上界
+    static constexpr size_t MAX_PROBE = 64;
+    static constexpr size_t FILTER_SIZE = 4096;
+
+    static size_t filter_index(const void* ptr) {
+        return static_cast<size_t>((reinterpret_cast<uintptr_t>(ptr) >> 4) * 0x9E3779B97F4A7C15ULL >> 52);
+    }
+
+    static ThreadState& thread_state() {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    /**
+     * @brief 抽取下一个采样间隔
+     * @return 当前这次分配是否被采样
+     */
+    bool reset_interval(ThreadState& state);
+
+    /**
+     * @brief 在调用栈表中查找或插入调用栈
+     * @return 表下标，表满时返回 STACK_TABLE_SIZE
+     */
+    size_t intern_stack(void* const* pcs, uint32_t depth);
+
+    void record_free_slow(void* ptr);
+
+    size_t sample_interval_;
+    std::unique_ptr<StackEntry[]> stacks_;
+    std::unique_ptr<PointerEntry[]> pointers_;
+    std::unique_ptr<std::atomic<uint16_t>[]> filter_;   // 存活采样对象的计数过滤器
+
+    std::atomic<size_t> stack_count_;
+    std::atomic<size_t> live_samples_;
+    std::atomic<size_t> sampled_allocations_;
+    std::atomic<size_t> sampled_frees_;
+    std::atomic<size_t> dropped_samples_;
+};
+
+#endif // HEAP_PROFILER_H
@@ -0,0 +1,552 @@
+#include "memory_pool.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <new>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ============================================================================
+// malloc/new 替换层（Malloc Interposition Shim）
+//
+// 编译为共享库 libmemory_pool_shim.so，两种用法：
+//   LD_PRELOAD=./libmemory_pool_shim.so ./service       # 不重新编译，整体 A/B
+//   target_link_libraries(service PRIVATE memory_pool_shim)
+//
+// 路由规则：
+//   1. size <= 池的最大分配（大块大小减去块头）：MemoryPoolManager（<= 256 字节走 slab）
+//   2. 更大的分配：直接 mmap，登记在一张定长表中，释放时 munmap
+//   3. 池尚未初始化、池已满、对齐要求大于 16 字节，或者在池内部递归分配时：glibc（__libc_malloc 等）
+// 释放时按地址判断归属：池的地址范围 -> mmap 登记表 -> glibc，所以三类指针可以混用
+//
+// fork：与 glibc 的 arena 一样用 pthread_atfork 在 fork 前锁住池的所有锁、fork 后在父子进程中释放，
+// 子进程不会继承一把被其它线程持有的锁（否则子进程第一次 malloc 就会死锁）
+//
+// 环境变量：
+//   MEMPOOL_SHIM_DISABLE=1        全部交给 glibc（用于对照组）
+//   MEMPOOL_SHIM_BLOCK_COUNT=N    每个层级的块数量（默认 10）
+//   MEMPOOL_SHIM_STATS=1          进程退出时把路由计数打印到 stderr
+// ============================================================================
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+enum class ShimState : int {
+    UNINITIALIZED = 0,
+    INITIALIZING = 1,   // 某个线程正在构造池，其他线程先用 glibc
+    READY = 2,
+    DISABLED = 3
+};
+
+std::atomic<int> shim_state{static_cast<int>(ShimState::UNINITIALIZED)};
+
+// 池放在静态存储中，不注册析构：进程退出期间仍然会有 free 调用进来
+alignas(MemoryPoolManager) unsigned char pool_storage[sizeof(MemoryPoolManager)];
+MemoryPoolManager* pool = nullptr;
+size_t pool_max_allocation = 0;
+
+// 线程正在执行池的代码：期间池内部（vector、map、iostream 等）的分配全部交给 glibc。
+// initial-exec 模型直接按偏移访问 TLS，不会在首次访问时调用 malloc
+__attribute__((tls_model("initial-exec"))) thread_local bool in_pool = false;
+
+/**
+ * @brief 进入池代码时设置递归标记，离开时恢复
+ */
+class PoolScope {
+public:
+    PoolScope() { in_pool = true; }
+    ~PoolScope() { in_pool = false; }
+};
+
+// 路由计数
+std::atomic<size_t> pool_allocations{0};
+std::atomic<size_t> libc_allocations{0};
+std::atomic<size_t> huge_allocations{0};
+
+// ============================================================================
+// 超大分配：直接 mmap，地址登记在开放寻址表中（只有 CAS，不加锁）
+// ============================================================================
+
+constexpr size_t HUGE_TABLE_SIZE = 4096;
+constexpr size_t HUGE_MAX_PROBE = 64;
+constexpr uintptr_t HUGE_EMPTY = 0;
+constexpr uintptr_t HUGE_TOMBSTONE = 1;
+
+struct HugeEntry {
+    std::atomic<uintptr_t> address;
+    std::atomic<size_t> length;
+};
+
+HugeEntry huge_table[HUGE_TABLE_SIZE];
+std::atomic<size_t> huge_live{0};
+
+size_t huge_slot(uintptr_t address) {
+    return static_cast<size_t>((address >> 12) * 0x9E3779B97F4A7C15ULL >> 52) & (HUGE_TABLE_SIZE - 1);
+}
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+void* huge_allocate(size_t size) {
+    size_t length = align_up(size, page_size());
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    size_t start = huge_slot(address);
+    for (size_t probe = 0; probe < HUGE_MAX_PROBE; ++probe) {
+        HugeEntry& entry = huge_table[(start + probe) & (HUGE_TABLE_SIZE - 1)];
+        uintptr_t current = entry.address.load(std::memory_order_relaxed);
+        if ((current == HUGE_EMPTY || current == HUGE_TOMBSTONE) &&
+            entry.address.compare_exchange_strong(current, address, std::memory_order_acq_rel)) {
+            entry.length.store(length, std::memory_order_release);
+            huge_live.fetch_add(1, std::memory_order_relaxed);
+            huge_allocations.fetch_add(1, std::memory_order_relaxed);
+            return ptr;
+        }
+    }
+
+    // 登记表满（同时存活的超大分配过多），交给 glibc
+    munmap(ptr, length);
+    return nullptr;
+}
+
+HugeEntry* huge_find(const void* ptr) {
+    if (huge_live.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    if (address & (page_size() - 1)) {
+        return nullptr;     // mmap 返回的地址一定按页对齐
+    }
+
+    size_t start = huge_slot(address);
+    for (size_t probe = 0; probe < HUGE_MAX_PROBE; ++probe) {
+        HugeEntry& entry = huge_table[(start + probe) & (HUGE_TABLE_SIZE - 1)];
+        uintptr_t current = entry.address.load(std::memory_order_acquire);
+        if (current == address) {
+            return &entry;
+        }
+        if (current == HUGE_EMPTY) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool huge_free(void* ptr) {
+    HugeEntry* entry = huge_find(ptr);
+    if (!entry) {
+        return false;
+    }
+    uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    size_t length = entry->length.load(std::memory_order_acquire);
+    if (!entry->address.compare_exchange_strong(address, HUGE_TOMBSTONE, std::memory_order_acq_rel)) {
+        return false;
+    }
+    huge_live.fetch_sub(1, std::memory_order_relaxed);
+    munmap(ptr, length);
+    return true;
+}
+
+// ============================================================================
+// 初始化
+// ============================================================================
+
+bool pool_ready() {
+    return shim_state.load(std::memory_order_acquire) == static_cast<int>(ShimState::READY);
+}
+
+// fork_prepare 是否锁住了池（fork 期间池可能恰好完成初始化，释放时不能只看当前状态）
+bool fork_locked = false;
+
+/**
+ * @brief fork 前锁住池，fork 期间其它线程的分配和释放等在锁上
+ */
+void fork_prepare() {
+    fork_locked = pool_ready();
+    if (fork_locked) {
+        pool->lock_for_fork();
+    }
+}
+
+/**
+ * @brief fork 后释放 fork_prepare 持有的锁（父进程和子进程都调用）
+ */
+void fork_release() {
+    if (fork_locked) {
+        fork_locked = false;
+        pool->unlock_after_fork();
+    }
+}
+
+void print_shim_stats() {
+    char buffer[256];
+    int length = snprintf(buffer, sizeof(buffer),
+                          "[INFO] memory_pool_shim: pool %zu, libc %zu, mmap %zu allocations\n",
+                          pool_allocations.load(), libc_allocations.load(), huge_allocations.load());
+    if (length > 0) {
+        ssize_t ignored = write(STDERR_FILENO, buffer, static_cast<size_t>(length));
+        (void)ignored;
+    }
+}
+
+/**
+ * @brief 确保池已初始化，返回池是否可用
+ */
+bool ensure_pool() {
+    int state = shim_state.load(std::memory_order_acquire);
+    if (state == static_cast<int>(ShimState::READY)) {
+        return true;
+    }
+    if (state != static_cast<int>(ShimState::UNINITIALIZED)) {
+        return false;
+    }
+
+    int expected = static_cast<int>(ShimState::UNINITIALIZED);
+    if (!shim_state.compare_exchange_strong(expected, static_cast<int>(ShimState::INITIALIZING),
+                                            std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    // getenv 不分配内存，可以在这里安全调用
+    const char* disable = getenv("MEMPOOL_SHIM_DISABLE");
+    if (disable && disable[0] == '1') {
+        shim_state.store(static_cast<int>(ShimState::DISABLED), std::memory_order_release);
+        return false;
+    }
+
+    PoolScope scope;
+    MemoryPoolConfig config;
+    config.verbose = false;
+    const char* count = getenv("MEMPOOL_SHIM_BLOCK_COUNT");
+    if (count) {
+        size_t value = strtoull(count, nullptr, 10);
+        if (value > 0) {
+            config.block_count = value;
+        }
+    }
+
+    try {
+        pool = new (pool_storage) MemoryPoolManager(config);
+    } catch (...) {
+        shim_state.store(static_cast<int>(ShimState::DISABLED), std::memory_order_release);
+        return false;
+    }
+    pool_max_allocation = config.large_block_size - sizeof(MemoryBlockHeader) - MemoryBlock::MIN_BLOCK_SIZE;
+
+    const char* stats = getenv("MEMPOOL_SHIM_STATS");
+    if (stats && stats[0] == '1') {
+        atexit(print_shim_stats);
+    }
+
+    // 注册时 glibc 可能分配内存，此时处于 PoolScope 中，会直接走 glibc
+    pthread_atfork(fork_prepare, fork_release, fork_release);
+
+    shim_state.store(static_cast<int>(ShimState::READY), std::memory_order_release);
+    return true;
+}
+
+// ============================================================================
+// 分配路由
+// ============================================================================
+
+void* shim_malloc(size_t size) {
+    if (size == 0) {
+        size = 1;   // malloc(0) 也要返回可以 free 的唯一指针
+    }
+
+    if (!in_pool && ensure_pool()) {
+        if (size <= pool_max_allocation) {
+            PoolScope scope;
+            void* ptr = pool->allocate(size, UNTAGGED);
+            if (ptr) {
+                pool_allocations.fetch_add(1, std::memory_order_relaxed);
+                return ptr;
+            }
+        } else {
+            void* ptr = huge_allocate(size);
+            if (ptr) {
+                return ptr;
+            }
+        }
+    }
+
+    libc_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void shim_free(void* ptr) {
+    if (!ptr) return;
+
+    if (pool_ready() && pool->owns(ptr)) {
+        PoolScope scope;
+        pool->deallocate(ptr);
+        return;
+    }
+    if (huge_free(ptr)) {
+        return;
+    }
+    __libc_free(ptr);
+}
+
+size_t libc_usable_size(void* ptr) {
+    using UsableSizeFn = size_t (*)(void*);
+    static UsableSizeFn next = nullptr;
+    if (!next) {
+        // dlsym 内部可能分配内存，标记为递归，让它直接走 glibc
+        bool saved = in_pool;
+        in_pool = true;
+        next = reinterpret_cast<UsableSizeFn>(dlsym(RTLD_NEXT, "malloc_usable_size"));
+        in_pool = saved;
+    }
+    return next ? next(ptr) : 0;
+}
+
+size_t shim_usable_size(void* ptr) {
+    if (!ptr) return 0;
+    if (pool_ready() && pool->owns(ptr)) {
+        return pool->usable_size(ptr);
+    }
+    if (HugeEntry* entry = huge_find(ptr)) {
+        return entry->length.load(std::memory_order_acquire);
+    }
+    return libc_usable_size(ptr);
+}
+
+void* shim_realloc(void* ptr, size_t size) {
+    if (!ptr) {
+        return shim_malloc(size);
+    }
+    if (size == 0) {
+        shim_free(ptr);
+        return nullptr;
+    }
+
+    bool in_pool_memory = pool_ready() && pool->owns(ptr);
+    HugeEntry* huge = in_pool_memory ? nullptr : huge_find(ptr);
+    if (!in_pool_memory && !huge) {
+        // glibc 的指针继续留在 glibc
+        return __libc_realloc(ptr, size);
+    }
+
+    size_t old_size = in_pool_memory ? pool->usable_size(ptr) : huge->length.load(std::memory_order_acquire);
+    if (size <= old_size && (huge == nullptr || size > old_size / 2)) {
+        return ptr;     // 原地满足（缩小不超过一半时不搬移）
+    }
+
+    void* fresh = shim_malloc(size);
+    if (!fresh) {
+        return nullptr;
+    }
+    std::memcpy(fresh, ptr, size < old_size ? size : old_size);
+    shim_free(ptr);
+    return fresh;
+}
+
+void* shim_memalign(size_t alignment, size_t size) {
+    // 池和 slab 的数据区都是 16 字节对齐，更大的对齐交给 glibc
+    if (alignment <= MemoryBlock::ALIGNMENT) {
+        return shim_malloc(size);
+    }
+    libc_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void* new_impl(size_t size) {
+    for (;;) {
+        void* ptr = shim_malloc(size);
+        if (ptr) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* aligned_new_impl(size_t size, std::align_val_t alignment) {
+    for (;;) {
+        void* ptr = shim_memalign(static_cast<size_t>(alignment), size == 0 ? 1 : size);
+        if (ptr) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// C 接口
+// ============================================================================
+
+extern "C" {
+
+void* malloc(size_t size) {
+    return shim_malloc(size);
+}
+
+void free(void* ptr) {
+    shim_free(ptr);
+}
+
+void* calloc(size_t count, size_t size) {
+    size_t total = 0;
+    if (__builtin_mul_overflow(count, size, &total)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    void* ptr = shim_malloc(total);
+    // 池中的内存会被复用，需要清零；mmap 和 glibc 的新内存清零一次也无妨
+    if (ptr) {
+        std::memset(ptr, 0, total);
+    }
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    return shim_realloc(ptr, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* ptr = shim_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return shim_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    return shim_memalign(alignment, size);
+}
+
+void* valloc(size_t size) {
+    return shim_memalign(page_size(), size);
+}
+
+void* pvalloc(size_t size) {
+    return shim_memalign(page_size(), align_up(size == 0 ? 1 : size, page_size()));
+}
+
+size_t malloc_usable_size(void* ptr) {
+    return shim_usable_size(ptr);
+}
+
+} // extern "C"
+
+// ============================================================================
+// C++ 全局 operator new/delete
+// ============================================================================
+
+void* operator new(size_t size) {
+    return new_impl(size);
+}
+
+void* operator new[](size_t size) {
+    return new_impl(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return shim_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return shim_malloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return aligned_new_impl(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return aligned_new_impl(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return shim_memalign(static_cast<size_t>(alignment), size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return shim_memalign(static_cast<size_t>(alignment), size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    shim_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    shim_free(ptr);
+}
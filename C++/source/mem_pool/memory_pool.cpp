@@ -1,18 +1,174 @@
 #include "memory_pool.h"
 #include <cstring>
 #include <iomanip>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
 
 // ============================================================================
 // MemoryBlock 实现
 // ============================================================================
 
+namespace {
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint32_t now_ms() {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief 分配/释放路径上的告警：格式化到栈上的缓冲区后直接 write(2)
+ * 作为 malloc 替换时这些路径运行在 malloc()/free() 内部，iostream 可能分配内存或加锁，会重入 shim 或死锁
+ */
+void heap_warning(const char* message, const void* ptr = nullptr) {
+    char line[192];
+    int length = ptr ? std::snprintf(line, sizeof(line), "[WARNING] %s: %p\n", message, ptr)
+                     : std::snprintf(line, sizeof(line), "[WARNING] %s\n", message);
+    if (length > 0) {
+        ssize_t ignored = write(STDERR_FILENO, line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+        (void)ignored;
+    }
+}
+
+/**
+ * @brief 页区间的归还结果
+ */
+enum class PageRelease {
+    FAILED,     // madvise 失败，页仍然常驻
+    LAZY,       // MADV_FREE：只标记为可回收，内核内存紧张时才真正回收
+    IMMEDIATE   // MADV_DONTNEED：立即还给操作系统
+};
+
+/**
+ * @brief 把页区间还给操作系统
+ * MADV_FREE 只在内存紧张时才回收，再次写入不会缺页清零，优先使用；
+ * 旧内核返回 EINVAL 后记住结果，之后直接用 MADV_DONTNEED
+ */
+PageRelease release_pages(void* addr, size_t length) {
+#ifdef MADV_FREE
+    static std::atomic<bool> madv_free_supported{true};
+    if (madv_free_supported.load(std::memory_order_relaxed)) {
+        if (madvise(addr, length, MADV_FREE) == 0) {
+            return PageRelease::LAZY;
+        }
+        if (errno != EINVAL) {
+            return PageRelease::FAILED;
+        }
+        madv_free_supported.store(false, std::memory_order_relaxed);
+    }
+#endif
+    return madvise(addr, length, MADV_DONTNEED) == 0 ? PageRelease::IMMEDIATE : PageRelease::FAILED;
+}
+
+#ifdef MADV_POPULATE_WRITE
+std::atomic<bool> populate_write_supported{true};
+#else
+std::atomic<bool> populate_write_supported{false};
+#endif
+
+/**
+ * @brief 让页区间常驻（预缺页）
+ * MADV_POPULATE_WRITE 一次系统调用完成整个区间，旧内核返回 EINVAL 后记住结果，之后逐页写入
+ */
+void populate_pages(char* addr, size_t length) {
+#ifdef MADV_POPULATE_WRITE
+    if (populate_write_supported.load(std::memory_order_relaxed)) {
+        if (madvise(addr, length, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+        if (errno == EINVAL) {
+            populate_write_supported.store(false, std::memory_order_relaxed);
+        }
+    }
+#endif
+    // 原子地加 0：触发写缺页但不改变内容，页中已有对象时也不会与使用者产生数据竞争
+    size_t page = page_size();
+    for (size_t offset = 0; offset < length; offset += page) {
+        __atomic_fetch_add(addr + offset, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 解析 sysfs 中的编号列表（例如 "0-3,8-11"）
+ */
+std::vector<int> parse_id_list(const std::string& text) {
+    std::vector<int> ids;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        int first = 0;
+        int last = 0;
+        int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (fields <= 0) continue;
+        if (fields == 1) last = first;
+        for (int id = first; id <= last; ++id) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+/**
+ * @brief 在线 NUMA 节点的 CPU 列表（没有 CPU 的纯内存节点不计入，没有 sysfs 信息时返回空）
+ */
+std::vector<std::vector<int>> numa_node_cpus() {
+    std::vector<std::vector<int>> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string line;
+    if (!std::getline(online, line)) {
+        return nodes;
+    }
+    for (int node : parse_id_list(line)) {
+        std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string cpus;
+        if (std::getline(cpulist, cpus)) {
+            std::vector<int> ids = parse_id_list(cpus);
+            if (!ids.empty()) {
+                nodes.push_back(std::move(ids));
+            }
+        }
+    }
+    return nodes;
+}
+
+/**
+ * @brief 把当前线程绑定到给定的 CPU 集合
+ */
+void bind_current_thread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+} // namespace
+
 MemoryBlock::MemoryBlock(size_t size)
-    : total_size_(size), used_size_(0), cached_max_free_size_(0), first_block_(nullptr) {
+    : total_size_(size), used_size_(0), cached_max_free_size_(0), first_block_(nullptr), purged_bytes_(0),
+      advised_bytes_(0), locked_(false) {
 
-    // 分配原始内存
-    raw_memory_ = new char[size];
+    // 分配原始内存：使用 mmap 保证页对齐，空闲部分才能按页还给操作系统
+    mapped_size_ = align_up(size, page_size());
+    raw_memory_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-    if (!raw_memory_) {
+    if (raw_memory_ == MAP_FAILED) {
+        raw_memory_ = nullptr;
         throw std::bad_alloc();
     }
 
@@ -21,9 +177,11 @@ MemoryBlock::MemoryBlock(size_t size)
     header->magic = MAGIC_NUMBER;
     header->block_size = size - sizeof(MemoryBlockHeader);
     header->is_free = 1;  // 初始为空闲
+    header->tag = UNTAGGED;
     header->alignment_padding = 0;
     header->next = nullptr;
     header->prev = nullptr;
+    header->free_since = now_ms();
 
     first_block_ = header;
 
@@ -33,12 +191,12 @@ MemoryBlock::MemoryBlock(size_t size)
 
 MemoryBlock::~MemoryBlock() {
     if (raw_memory_) {
-        delete[] reinterpret_cast<char*>(raw_memory_);
+        munmap(raw_memory_, mapped_size_);
         raw_memory_ = nullptr;
     }
 }
 
-void* MemoryBlock::allocate(size_t size) {
+void* MemoryBlock::allocate(size_t size, MemoryTag tag) {
     if (size == 0) return nullptr;
 
     std::lock_guard<std::mutex> lock(block_mutex_);
@@ -58,14 +216,23 @@ void* MemoryBlock::allocate(size_t size) {
     }
 
     // 如果块太大，拆分它
-    if (block->block_size > aligned_size + sizeof(MemoryBlockHeader) + MIN_BLOCK_SIZE) {
+    bool split = block->block_size > aligned_size + sizeof(MemoryBlockHeader) + MIN_BLOCK_SIZE;
+    if (split) {
         split_block(block, aligned_size);
     }
 
+    // 分配出去的区域（拆分时还包括剩余部分的新块头）即将被写入，不再算作已还回
+    if (!purged_.empty()) {
+        char* begin = reinterpret_cast<char*>(block);
+        char* end = begin + sizeof(MemoryBlockHeader) + block->block_size + (split ? sizeof(MemoryBlockHeader) : 0);
+        mark_resident(begin, end);
+    }
+
     // 标记块为已使用
     block->is_free = 0;
+    block->tag = tag;
     size_t actual_size = align_up(size, ALIGNMENT);
-    block->alignment_padding = actual_size - size;
+    block->alignment_padding = static_cast<uint16_t>(actual_size - size);
 
     // 更新已使用内存统计
     used_size_ += block->block_size;
@@ -77,7 +244,7 @@ void* MemoryBlock::allocate(size_t size) {
     return reinterpret_cast<void*>(reinterpret_cast<char*>(block) + sizeof(MemoryBlockHeader));
 }
 
-bool MemoryBlock::deallocate(void* ptr) {
+bool MemoryBlock::deallocate(void* ptr, MemoryTag* tag, size_t* size) {
     if (!ptr) return false;
 
     std::lock_guard<std::mutex> lock(block_mutex_);
@@ -94,12 +261,17 @@ bool MemoryBlock::deallocate(void* ptr) {
     }
 
     if (header->is_free) {
-        std::cerr << "[WARNING] 尝试释放已经释放的内存块" << std::endl;
+        heap_warning("尝试释放已经释放的内存块", ptr);
         return false;
     }
 
+    if (tag) *tag = header->tag;
+    if (size) *size = header->block_size;
+
     // 标记为空闲
     header->is_free = 1;
+    header->tag = UNTAGGED;
+    header->free_since = now_ms();
     used_size_ -= header->block_size;
 
     // 尝试合并相邻的空闲块
@@ -154,9 +326,11 @@ void MemoryBlock::split_block(MemoryBlockHeader* header, size_t needed_size) {
     new_header->magic = MAGIC_NUMBER;
     new_header->block_size = header->block_size - needed_size - sizeof(MemoryBlockHeader);
     new_header->is_free = 1;
+    new_header->tag = UNTAGGED;
     new_header->alignment_padding = 0;
     new_header->next = header->next;
     new_header->prev = header;
+    new_header->free_since = header->free_since;
 
     // 更新原块
     header->block_size = needed_size;
@@ -178,8 +352,9 @@ void MemoryBlock::merge_free_blocks(MemoryBlockHeader* header) {
         }
     }
 
-    // 尝试与前一个块合并
+    // 尝试与前一个块合并（合并后的块从现在开始重新计算闲置时间）
     if (header->prev && header->prev->is_free) {
+        header->prev->free_since = header->free_since;
         header->prev->block_size += sizeof(MemoryBlockHeader) + header->block_size;
         header->prev->next = header->next;
         if (header->next) {
@@ -305,12 +480,406 @@ size_t MemoryBlock::get_internal_fragmentation() const {
     return (total_free - max_free) * 100 / total_free;
 }
 
+size_t MemoryBlock::purge_idle(std::chrono::milliseconds decay) {
+    std::lock_guard<std::mutex> lock(block_mutex_);
+
+    // 锁定的页不能归还（madvise 对 mlock 区域返回 EINVAL）
+    if (locked_.load()) {
+        return 0;
+    }
+
+    // 32 位毫秒时间戳按无符号减法比较，回绕后仍然正确（闲置超过 49 天的 chunk 最多推迟一个周期）
+    uint32_t now = now_ms();
+    uint64_t threshold = static_cast<uint64_t>(decay.count());
+    uintptr_t page_mask = page_size() - 1;
+    size_t purged = 0;
+
+    for (MemoryBlockHeader* current = first_block_; current; current = current->next) {
+        if (!current->is_free || static_cast<uint32_t>(now - current->free_since) < threshold) {
+            continue;
+        }
+
+        // 只还回 chunk 内部的整页，块头所在的页保持常驻
+        uintptr_t data = reinterpret_cast<uintptr_t>(current) + sizeof(MemoryBlockHeader);
+        uintptr_t begin = (data + page_mask) & ~page_mask;
+        uintptr_t end = (data + current->block_size) & ~page_mask;
+        if (begin < end) {
+            purged += purge_range(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(end));
+        }
+    }
+
+    return purged;
+}
+
+size_t MemoryBlock::prefault(bool lock_pages, bool* locked) {
+    std::lock_guard<std::mutex> lock(block_mutex_);
+
+    char* begin = static_cast<char*>(raw_memory_);
+    populate_pages(begin, mapped_size_);
+
+    // 之前还回的页也已重新常驻
+    purged_.clear();
+    purged_bytes_ = 0;
+    advised_bytes_ = 0;
+
+    bool is_locked = locked_.load();
+    if (lock_pages && !is_locked) {
+        is_locked = mlock(begin, mapped_size_) == 0;
+        locked_.store(is_locked);
+    }
+    if (locked) *locked = is_locked;
+
+    return mapped_size_;
+}
+
+void MemoryBlock::mark_resident(char* begin, char* end) {
+    // 写入页内任意字节都会让整页重新常驻，按页扩展区间
+    uintptr_t page_mask = page_size() - 1;
+    uintptr_t b = reinterpret_cast<uintptr_t>(begin) & ~page_mask;
+    uintptr_t e = (reinterpret_cast<uintptr_t>(end) + page_mask) & ~page_mask;
+
+    auto it = purged_.upper_bound(b);
+    if (it != purged_.begin() && std::prev(it)->second.end > b) {
+        --it;
+    }
+
+    while (it != purged_.end() && it->first < e) {
+        uintptr_t start = it->first;
+        uintptr_t stop = it->second.end;
+        bool lazy = it->second.lazy;
+        it = purged_.erase(it);
+        released_counter(lazy) -= stop - start;
+
+        // 保留区间两侧不重叠的部分
+        if (start < b) {
+            purged_.emplace(start, ReleasedRange{b, lazy});
+            released_counter(lazy) += b - start;
+        }
+        if (stop > e) {
+            it = purged_.emplace(e, ReleasedRange{stop, lazy}).first;
+            released_counter(lazy) += stop - e;
+            ++it;
+        }
+    }
+}
+
+size_t MemoryBlock::purge_range(char* begin, char* end) {
+    uintptr_t b = reinterpret_cast<uintptr_t>(begin);
+    uintptr_t e = reinterpret_cast<uintptr_t>(end);
+
+    // 找到第一个可能与 [b, e) 重叠的区间
+    auto it = purged_.upper_bound(b);
+    if (it != purged_.begin() && std::prev(it)->second.end > b) {
+        --it;
+    }
+
+    // 先收集尚未还回的空隙，遍历结束后再插入，插入时的合并不会让遍历中的迭代器失效
+    std::vector<std::pair<uintptr_t, uintptr_t>> gaps;
+    uintptr_t cursor = b;
+    for (; it != purged_.end() && it->first < e; ++it) {
+        if (it->first > cursor) {
+            gaps.emplace_back(cursor, it->first);
+        }
+        cursor = std::max(cursor, it->second.end);
+    }
+    if (cursor < e) {
+        gaps.emplace_back(cursor, e);
+    }
+
+    // 只对空隙调用 madvise，失败的空隙仍然常驻，不记录
+    size_t purged = 0;
+    for (const auto& gap : gaps) {
+        PageRelease result = release_pages(reinterpret_cast<void*>(gap.first), gap.second - gap.first);
+        if (result == PageRelease::FAILED) {
+            continue;
+        }
+        insert_released(gap.first, gap.second, result == PageRelease::LAZY);
+        purged += gap.second - gap.first;
+    }
+
+    return purged;
+}
+
+void MemoryBlock::insert_released(uintptr_t begin, uintptr_t end, bool lazy) {
+    released_counter(lazy) += end - begin;
+
+    // 与右侧紧邻的同类区间合并
+    auto next = purged_.lower_bound(begin);
+    if (next != purged_.end() && next->first == end && next->second.lazy == lazy) {
+        end = next->second.end;
+        next = purged_.erase(next);
+    }
+
+    // 与左侧紧邻的同类区间合并
+    if (next != purged_.begin()) {
+        auto prev = std::prev(next);
+        if (prev->second.end == begin && prev->second.lazy == lazy) {
+            prev->second.end = end;
+            return;
+        }
+    }
+    purged_.emplace_hint(next, begin, ReleasedRange{end, lazy});
+}
+
+// ============================================================================
+// SlabAllocator 实现
+// ============================================================================
+
+SlabAllocator::SlabAllocator(size_t region_size)
+    : region_(nullptr), region_end_(nullptr), mapping_(nullptr), mapping_size_(0),
+      next_slab_(nullptr), slab_count_(0), used_bytes_(0) {
+
+    size_t size = align_up(region_size > SLAB_SIZE ? region_size : SLAB_SIZE, SLAB_SIZE);
+
+    // 多映射一个 slab，用于把起始地址对齐到 SLAB_SIZE
+    mapping_size_ = size + SLAB_SIZE;
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::bad_alloc();
+    }
+
+    uintptr_t base = align_up(reinterpret_cast<uintptr_t>(mapping_), SLAB_SIZE);
+    region_ = reinterpret_cast<char*>(base);
+    region_end_ = region_ + size;
+    next_slab_ = region_;
+}
+
+SlabAllocator::~SlabAllocator() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+}
+
+void SlabAllocator::push_partial(SizeClass& sc, SlabHeader* slab) {
+    slab->prev = nullptr;
+    slab->next = sc.partial;
+    if (sc.partial) {
+        sc.partial->prev = slab;
+    }
+    sc.partial = slab;
+    slab->in_partial = true;
+}
+
+void SlabAllocator::remove_partial(SizeClass& sc, SlabHeader* slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        sc.partial = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = nullptr;
+    slab->prev = nullptr;
+    slab->in_partial = false;
+}
+
+SlabHeader* SlabAllocator::acquire_slab(size_t class_index) {
+    char* memory = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(region_mutex_);
+        if (!free_slabs_.empty()) {
+            memory = free_slabs_.back();
+            free_slabs_.pop_back();
+        } else if (next_slab_ < region_end_) {
+            memory = next_slab_;
+            next_slab_ += SLAB_SIZE;
+        }
+    }
+
+    if (!memory) {
+        return nullptr;
+    }
+
+    size_t object_size = (class_index + 1) * SIZE_CLASS_STEP;
+
+    // 每个对象占 object_size 字节加 1 字节标签，对象区按 64 字节对齐（预留最多 63 字节的对齐空隙）
+    size_t capacity = (SLAB_SIZE - sizeof(SlabHeader) - 63) / (object_size + 1);
+    size_t first_offset = align_up(sizeof(SlabHeader) + capacity, 64);
+
+    SlabHeader* slab = reinterpret_cast<SlabHeader*>(memory);
+    slab->magic = SLAB_MAGIC;
+    slab->size_class = static_cast<uint16_t>(class_index);
+    slab->object_size = static_cast<uint16_t>(object_size);
+    slab->capacity = static_cast<uint32_t>(capacity);
+    slab->free_count = slab->capacity;
+    slab->first_offset = static_cast<uint32_t>(first_offset);
+    slab->search_hint = 0;
+    slab->next = nullptr;
+    slab->prev = nullptr;
+    slab->in_partial = false;
+    std::memset(slab->bitmap, 0, sizeof(slab->bitmap));
+
+    // 超出容量的位预先标记为已占用，查找空闲位时不需要再判断边界
+    for (uint32_t bit = slab->capacity; bit < 64 * 64; ++bit) {
+        slab->bitmap[bit >> 6] |= 1ull << (bit & 63);
+    }
+
+    slab_count_++;
+    return slab;
+}
+
+void SlabAllocator::release_slab(SlabHeader* slab) {
+    slab->magic = 0;
+    slab_count_--;
+
+    std::lock_guard<std::mutex> lock(region_mutex_);
+    free_slabs_.push_back(reinterpret_cast<char*>(slab));
+}
+
+void* SlabAllocator::allocate(size_t size, MemoryTag tag) {
+    if (size == 0 || size > MAX_OBJECT_SIZE) return nullptr;
+
+    size_t class_index = size_class_of(size);
+    SizeClass& sc = classes_[class_index];
+
+    std::lock_guard<std::mutex> lock(sc.mutex);
+
+    SlabHeader* slab = sc.partial;
+    if (!slab) {
+        slab = acquire_slab(class_index);
+        if (!slab) {
+            return nullptr;
+        }
+        sc.slab_count++;
+        push_partial(sc, slab);
+    }
+
+    // 从上次的位置开始找第一个有空闲位的字
+    uint32_t word = slab->search_hint;
+    while (slab->bitmap[word] == ~0ull) {
+        word = (word + 1) & 63;
+    }
+    uint32_t bit = static_cast<uint32_t>(__builtin_ctzll(~slab->bitmap[word]));
+    slab->bitmap[word] |= 1ull << bit;
+    slab->search_hint = word;
+
+    if (--slab->free_count == 0) {
+        remove_partial(sc, slab);
+    }
+
+    sc.used_objects++;
+    used_bytes_ += slab->object_size;
+
+    uint32_t index = word * 64 + bit;
+    reinterpret_cast<uint8_t*>(slab + 1)[index] = tag;
+    return reinterpret_cast<char*>(slab) + slab->first_offset + static_cast<size_t>(index) * slab->object_size;
+}
+
+bool SlabAllocator::deallocate(void* ptr, MemoryTag* tag, size_t* size) {
+    if (!owns(ptr)) return false;
+
+    SlabHeader* slab = reinterpret_cast<SlabHeader*>(
+        reinterpret_cast<uintptr_t>(ptr) & ~(static_cast<uintptr_t>(SLAB_SIZE) - 1));
+
+    if (slab->magic != SLAB_MAGIC) {
+        heap_warning("释放的指针不在有效的 slab 中", ptr);
+        return false;
+    }
+
+    SizeClass& sc = classes_[slab->size_class];
+    std::lock_guard<std::mutex> lock(sc.mutex);
+
+    size_t offset = reinterpret_cast<char*>(ptr) - reinterpret_cast<char*>(slab);
+    if (offset < slab->first_offset || (offset - slab->first_offset) % slab->object_size != 0) {
+        heap_warning("释放的指针不是对象起始地址", ptr);
+        return false;
+    }
+
+    uint32_t index = static_cast<uint32_t>((offset - slab->first_offset) / slab->object_size);
+    uint64_t mask = 1ull << (index & 63);
+    if (index >= slab->capacity || !(slab->bitmap[index >> 6] & mask)) {
+        heap_warning("尝试释放已经释放的内存块", ptr);
+        return false;
+    }
+
+    if (tag) *tag = reinterpret_cast<uint8_t*>(slab + 1)[index];
+    if (size) *size = slab->object_size;
+
+    slab->bitmap[index >> 6] &= ~mask;
+    slab->free_count++;
+    sc.used_objects--;
+    used_bytes_ -= slab->object_size;
+
+    if (!slab->in_partial) {
+        // 满 slab 重新有了空位
+        push_partial(sc, slab);
+    } else if (slab->free_count == slab->capacity && (slab->prev || slab->next)) {
+        // 完全空闲且本大小类还有其他可用 slab，归还给全局空闲列表
+        remove_partial(sc, slab);
+        sc.slab_count--;
+        release_slab(slab);
+    }
+
+    return true;
+}
+
+size_t SlabAllocator::usable_size(const void* ptr) const {
+    if (!owns(ptr)) return 0;
+
+    const SlabHeader* slab = reinterpret_cast<const SlabHeader*>(
+        reinterpret_cast<uintptr_t>(ptr) & ~(static_cast<uintptr_t>(SLAB_SIZE) - 1));
+    return slab->magic == SLAB_MAGIC ? slab->object_size : 0;
+}
+
+void SlabAllocator::print_stats() const {
+    std::cout << "\n--- Small Object Slabs (" << SLAB_SIZE / 1024 << "KB each) ---" << std::endl;
+    std::cout << "Slab Memory: " << get_slab_bytes() / 1024 << " KB, Used: "
+              << get_used_bytes() / 1024 << " KB" << std::endl;
+
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        const SizeClass& sc = classes_[i];
+        std::lock_guard<std::mutex> lock(sc.mutex);
+        if (sc.slab_count == 0) {
+            continue;
+        }
+        std::cout << "Class " << std::setw(3) << (i + 1) * SIZE_CLASS_STEP << "B: "
+                  << sc.slab_count << " slabs, " << sc.used_objects << " objects" << std::endl;
+    }
+}
+
+void SlabAllocator::lock_for_fork() {
+    for (auto& sc : classes_) {
+        sc.mutex.lock();
+    }
+    region_mutex_.lock();
+}
+
+void SlabAllocator::unlock_after_fork() {
+    region_mutex_.unlock();
+    for (size_t i = SIZE_CLASS_COUNT; i > 0; --i) {
+        classes_[i - 1].mutex.unlock();
+    }
+}
+
 // ============================================================================
 // MemoryPoolManager 实现
 // ============================================================================
 
 MemoryPoolManager::MemoryPoolManager(const MemoryPoolConfig& config)
-    : config_(config), total_allocated_(0), allocation_count_(0), deallocation_count_(0) {
+    : config_(config), total_allocated_(0), allocation_count_(0), deallocation_count_(0),
+      last_purge_ms_(now_ms()), purge_cursor_(0), tag_count_(1) {
+
+    tags_[UNTAGGED].name = "untagged";
+
+    // 初始化小对象 slab 分配器
+    if (config_.enable_slab) {
+        slab_ = std::make_unique<SlabAllocator>(config_.slab_region_size);
+    }
+
+    if (config_.heap_profile_interval > 0) {
+        profiler_ = std::make_unique<HeapProfiler>(config_.heap_profile_interval);
+    }
+
+    if (!config_.trace_path.empty()) {
+        recorder_ = std::make_unique<AllocationTraceRecorder>(config_.trace_path);
+        if (!recorder_->is_open()) {
+            recorder_.reset();
+        }
+    }
 
     // 初始化小块池
     for (size_t i = 0; i < config_.block_count; ++i) {
@@ -330,6 +899,14 @@ MemoryPoolManager::MemoryPoolManager(const MemoryPoolConfig& config)
         total_allocated_ += config_.large_block_size;
     }
 
+    size_t limit = config_.soft_memory_limit;
+    if (limit == 0) {
+        limit = total_allocated_ + (slab_ ? config_.slab_region_size : 0);
+    }
+    pressure_ = std::make_unique<MemoryPressureMonitor>(limit);
+
+    if (!config_.verbose) return;
+
     std::cout << "[INFO] MemoryPoolManager initialized with " << config_.block_count
               << " blocks per size category" << std::endl;
     std::cout << "[INFO] Total memory allocated: " << (double)total_allocated_ / (1024 * 1024)
@@ -337,13 +914,18 @@ MemoryPoolManager::MemoryPoolManager(const MemoryPoolConfig& config)
 }
 
 MemoryPoolManager::~MemoryPoolManager() {
+    // 先停止通知线程，回调中可能还在访问管理器
+    pressure_.reset();
+
     std::lock_guard<std::mutex> lock(manager_mutex_);
 
     small_blocks_.clear();
     medium_blocks_.clear();
     large_blocks_.clear();
 
-    std::cout << "[INFO] MemoryPoolManager destroyed" << std::endl;
+    if (config_.verbose) {
+        std::cout << "[INFO] MemoryPoolManager destroyed" << std::endl;
+    }
 }
 
 MemoryBlock* MemoryPoolManager::select_block_for_allocation(size_t size) {
@@ -353,28 +935,27 @@ MemoryBlock* MemoryPoolManager::select_block_for_allocation(size_t size) {
     // 计算需要的总大小（包括对齐）
     size_t aligned_size = align_up(size, MemoryBlock::ALIGNMENT);
 
-    // 尝试顺序：小块 -> 中块 -> 大块
-    std::vector<std::vector<std::unique_ptr<MemoryBlock>>*> pools_to_try;
-
-    // 根据申请大小确定起始池
-    if (size <= config_.small_block_size - sizeof(MemoryBlockHeader) - MemoryBlock::MIN_BLOCK_SIZE) {
-        pools_to_try.push_back(&small_blocks_);
-        pools_to_try.push_back(&medium_blocks_);
-        pools_to_try.push_back(&large_blocks_);
-    } else if (size <= config_.medium_block_size - sizeof(MemoryBlockHeader) - MemoryBlock::MIN_BLOCK_SIZE) {
-        pools_to_try.push_back(&medium_blocks_);
-        pools_to_try.push_back(&large_blocks_);
-    } else if (size <= config_.large_block_size - sizeof(MemoryBlockHeader) - MemoryBlock::MIN_BLOCK_SIZE) {
-        pools_to_try.push_back(&large_blocks_);
-    } else {
-        std::cerr << "[ERROR] 申请大小 " << size << " 超过最大块大小 "
-                  << config_.large_block_size << std::endl;
+    // 尝试顺序：小块 -> 中块 -> 大块，从能容纳该大小的最小层级开始（固定数组，不在分配路径上构造容器）
+    std::vector<std::unique_ptr<MemoryBlock>>* const tiers[] = {&small_blocks_, &medium_blocks_, &large_blocks_};
+    const size_t tier_sizes[] = {config_.small_block_size, config_.medium_block_size, config_.large_block_size};
+    constexpr size_t TIER_COUNT = sizeof(tiers) / sizeof(tiers[0]);
+
+    size_t first = 0;
+    while (first < TIER_COUNT &&
+           size > tier_sizes[first] - sizeof(MemoryBlockHeader) - MemoryBlock::MIN_BLOCK_SIZE) {
+        first++;
+    }
+    if (first == TIER_COUNT) {
+        if (config_.verbose) {
+            std::cerr << "[ERROR] 申请大小 " << size << " 超过最大块大小 "
+                      << config_.large_block_size << std::endl;
+        }
         return nullptr;
     }
 
     // 在各个池中依次尝试查找（使用缓存值快速筛选）
-    for (auto target_pool : pools_to_try) {
-        for (auto& block : *target_pool) {
+    for (size_t tier = first; tier < TIER_COUNT; ++tier) {
+        for (auto& block : *tiers[tier]) {
             // 使用缓存的最大空闲块大小进行快速检查（无锁）
             if (block->get_cached_max_free_size() >= aligned_size) {
                 return block.get();
@@ -409,21 +990,74 @@ MemoryBlock* MemoryPoolManager::find_block_for_pointer(void* ptr) {
 }
 
 void* MemoryPoolManager::allocate(size_t size) {
+    return allocate(size, current_memory_tag());
+}
+
+void* MemoryPoolManager::allocate(size_t size, MemoryTag tag) {
     if (size == 0) return nullptr;
 
-    std::lock_guard<std::mutex> lock(manager_mutex_);
+    if (tag >= tag_count_.load(std::memory_order_acquire)) {
+        tag = UNTAGGED;
+    }
+
+    // 先按对齐后的大小预留标签预算，超过硬限制直接拒绝
+    size_t charged = align_up(size, MemoryBlock::ALIGNMENT);
+    if (!charge_tag(tag, charged)) {
+        return nullptr;
+    }
+
+    // 小对象快速路径：只持有大小类的锁，slab 区域耗尽时退回到普通路径
+    if (slab_ && size <= SlabAllocator::MAX_OBJECT_SIZE) {
+        void* ptr = slab_->allocate(size, tag);
+        if (ptr) {
+            allocation_count_++;
+            if (profiler_ && profiler_->should_sample(size)) {
+                profiler_->record_allocation(ptr, size);
+            }
+            if (recorder_) {
+                recorder_->record_allocation(ptr, size, tag);
+            }
+            return ptr;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(manager_mutex_);
 
     MemoryBlock* target_block = select_block_for_allocation(size);
 
     if (!target_block) {
-        std::cerr << "[ERROR] 无法为大小为 " << size << " 的内存分配寻找合适的块" << std::endl;
+        uncharge_tag(tag, charged);
+        if (config_.verbose) {
+            std::cerr << "[ERROR] 无法为大小为 " << size << " 的内存分配寻找合适的块" << std::endl;
+        }
         return nullptr;
     }
 
-    void* ptr = target_block->allocate(size);
+    void* ptr = target_block->allocate(size, tag);
 
-    if (ptr) {
-        allocation_count_++;
+    if (!ptr) {
+        uncharge_tag(tag, charged);
+        return nullptr;
+    }
+
+    allocation_count_++;
+
+    // 块无法拆分时会多占一些，按实际大小修正（可能略微超过硬限制，不超过一个最小块）
+    size_t actual = MemoryBlock::chunk_size(ptr);
+    if (actual > charged) {
+        tags_[tag].used.fetch_add(actual - charged, std::memory_order_relaxed);
+        pressure_->on_allocate(actual - charged);
+    }
+
+    lock.unlock();
+
+    // 采样要回溯调用栈，轨迹缓冲区写满时要写文件，都放在全局锁外，其他线程的分配不会排在后面。
+    // 指针还没有返回给调用者，不会有并发的释放，录制顺序仍然是"分配在前、释放在后"
+    if (profiler_ && profiler_->should_sample(size)) {
+        profiler_->record_allocation(ptr, size);
+    }
+    if (recorder_) {
+        recorder_->record_allocation(ptr, size, tag);
     }
 
     return ptr;
@@ -432,22 +1066,68 @@ void* MemoryPoolManager::allocate(size_t size) {
 bool MemoryPoolManager::deallocate(void* ptr) {
     if (!ptr) return false;
 
-    std::lock_guard<std::mutex> lock(manager_mutex_);
+    if (profiler_) {
+        profiler_->record_free(ptr);
+    }
+    if (recorder_) {
+        recorder_->record_free(ptr);
+    }
+
+    MemoryTag tag = UNTAGGED;
+    size_t size = 0;
+
+    if (slab_ && slab_->owns(ptr)) {
+        if (slab_->deallocate(ptr, &tag, &size)) {
+            uncharge_tag(tag, size);
+            deallocation_count_++;
+            return true;
+        }
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(manager_mutex_);
 
     // 优化：先精确定位指针所属的块，避免在所有块中尝试
     MemoryBlock* target_block = find_block_for_pointer(ptr);
 
     if (target_block) {
-        if (target_block->deallocate(ptr)) {
+        if (target_block->deallocate(ptr, &tag, &size)) {
+            uncharge_tag(tag, size);
             deallocation_count_++;
+            lock.unlock();
+            maybe_purge();
             return true;
         }
     }
 
-    std::cerr << "[WARNING] 无法找到待释放的指针: " << ptr << std::endl;
+    if (config_.verbose) {
+        std::cerr << "[WARNING] 无法找到待释放的指针: " << ptr << std::endl;
+    }
     return false;
 }
 
+bool MemoryPoolManager::owns(const void* ptr) const {
+    if (slab_ && slab_->owns(ptr)) {
+        return true;
+    }
+    for (const auto* blocks : {&small_blocks_, &medium_blocks_, &large_blocks_}) {
+        for (const auto& block : *blocks) {
+            if (block->contains(const_cast<void*>(ptr))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t MemoryPoolManager::usable_size(const void* ptr) const {
+    if (slab_ && slab_->owns(ptr)) {
+        return slab_->usable_size(ptr);
+    }
+    // 块头中的 block_size 就是数据区大小（拆分不了时会大于申请的大小）
+    return owns(ptr) ? MemoryBlock::chunk_size(ptr) : 0;
+}
+
 PoolStatistics MemoryPoolManager::get_statistics() const {
     std::lock_guard<std::mutex> lock(manager_mutex_);
 
@@ -500,6 +1180,34 @@ PoolStatistics MemoryPoolManager::get_statistics() const {
         stats.fragmentation_ratio = 0;  // 没有使用任何块，碎片率为0
     }
 
+    stats.slab_bytes = slab_ ? slab_->get_slab_bytes() : 0;
+    stats.slab_used = slab_ ? slab_->get_used_bytes() : 0;
+
+    size_t tag_count = tag_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < tag_count; ++i) {
+        const TagState& state = tags_[i];
+        TagStatistics tag_stats;
+        tag_stats.tag = static_cast<MemoryTag>(i);
+        tag_stats.name = state.name;
+        tag_stats.used = state.used.load(std::memory_order_relaxed);
+        tag_stats.peak = state.peak.load(std::memory_order_relaxed);
+        tag_stats.soft_limit = state.soft_limit.load(std::memory_order_relaxed);
+        tag_stats.hard_limit = state.hard_limit.load(std::memory_order_relaxed);
+        tag_stats.allocation_count = state.allocation_count.load(std::memory_order_relaxed);
+        tag_stats.rejected_count = state.rejected_count.load(std::memory_order_relaxed);
+        tag_stats.soft_exceeded = state.soft_exceeded.load(std::memory_order_relaxed);
+        stats.tag_stats.push_back(std::move(tag_stats));
+    }
+
+    stats.purged_bytes = 0;
+    stats.advised_bytes = 0;
+    for (const auto* blocks : {&small_blocks_, &medium_blocks_, &large_blocks_}) {
+        for (const auto& block : *blocks) {
+            stats.purged_bytes += block->get_purged_bytes();
+            stats.advised_bytes += block->get_advised_bytes();
+        }
+    }
+
     return stats;
 }
 
@@ -521,6 +1229,16 @@ void MemoryPoolManager::print_all_stats() const {
         total_used += block->get_used_size();
     }
     std::cout << "Total Used: " << (double)total_used / (1024 * 1024) << " MB" << std::endl;
+    size_t purged = 0;
+    size_t advised = 0;
+    for (const auto* blocks : {&small_blocks_, &medium_blocks_, &large_blocks_}) {
+        for (const auto& block : *blocks) {
+            purged += block->get_purged_bytes();
+            advised += block->get_advised_bytes();
+        }
+    }
+    std::cout << "Purged (returned to OS): " << (double)purged / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "Advised (MADV_FREE, reclaimable): " << (double)advised / (1024 * 1024) << " MB" << std::endl;
     std::cout << "Allocation Count: " << allocation_count_.load() << std::endl;
     std::cout << "Deallocation Count: " << deallocation_count_.load() << std::endl;
 
@@ -548,6 +1266,25 @@ void MemoryPoolManager::print_all_stats() const {
               << avg_utilization << "%" << std::endl;
     std::cout << "Fragmentation Ratio: " << fragmentation_ratio << "%" << std::endl;
 
+    size_t tag_count = tag_count_.load(std::memory_order_acquire);
+    std::cout << "\n--- Memory Tags ---" << std::endl;
+    for (size_t i = 0; i < tag_count; ++i) {
+        const TagState& state = tags_[i];
+        std::cout << std::setw(12) << state.name << ": " << state.used.load() / 1024 << " KB"
+                  << " (peak " << state.peak.load() / 1024 << " KB";
+        if (state.soft_limit.load() > 0) {
+            std::cout << ", soft " << state.soft_limit.load() / 1024 << " KB";
+        }
+        if (state.hard_limit.load() > 0) {
+            std::cout << ", hard " << state.hard_limit.load() / 1024 << " KB";
+        }
+        std::cout << ", rejected " << state.rejected_count.load() << ")" << std::endl;
+    }
+
+    if (slab_) {
+        slab_->print_stats();
+    }
+
     std::cout << "\n--- Small Blocks (" << config_.small_block_size / 1024 << "KB) ---" << std::endl;
     for (size_t i = 0; i < small_blocks_.size(); ++i) {
         std::cout << "Block " << i << ": " << small_blocks_[i]->get_used_size() << " / "
@@ -572,7 +1309,9 @@ void MemoryPoolManager::print_all_stats() const {
 void MemoryPoolManager::compact_all() {
     std::lock_guard<std::mutex> lock(manager_mutex_);
 
-    std::cout << "[INFO] 开始对所有内存块进行碎片整理..." << std::endl;
+    if (config_.verbose) {
+        std::cout << "[INFO] 开始对所有内存块进行碎片整理..." << std::endl;
+    }
 
     for (auto& block : small_blocks_) {
         block->compact();
@@ -586,7 +1325,9 @@ void MemoryPoolManager::compact_all() {
         block->compact();
     }
 
-    std::cout << "[INFO] 碎片整理完成" << std::endl;
+    if (config_.verbose) {
+        std::cout << "[INFO] 碎片整理完成" << std::endl;
+    }
 }
 
 void MemoryPoolManager::reset_statistics() {
@@ -595,5 +1336,261 @@ void MemoryPoolManager::reset_statistics() {
     allocation_count_ = 0;
     deallocation_count_ = 0;
 
-    std::cout << "[INFO] 统计信息已重置" << std::endl;
+    if (config_.verbose) {
+        std::cout << "[INFO] 统计信息已重置" << std::endl;
+    }
+}
+
+WarmUpReport MemoryPoolManager::warm_up(const WarmUpPolicy& policy) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(manager_mutex_);
+
+    // 大块在前，线程按顺序领取时负载更均衡
+    std::vector<MemoryBlock*> blocks;
+    for (auto* tier : {&large_blocks_, &medium_blocks_, &small_blocks_}) {
+        for (auto& block : *tier) {
+            blocks.push_back(block.get());
+        }
+    }
+
+    // 单节点机器上不绑定 CPU
+    std::vector<std::vector<int>> nodes;
+    if (policy.numa_aware) {
+        nodes = numa_node_cpus();
+        if (nodes.size() < 2) {
+            nodes.clear();
+        }
+    }
+    size_t node_count = nodes.empty() ? 1 : nodes.size();
+
+    // 块轮流分给各节点，每个节点的线程只预热分给本节点的块
+    std::vector<std::vector<MemoryBlock*>> node_blocks(node_count);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        node_blocks[i % node_count].push_back(blocks[i]);
+    }
+
+    size_t threads = policy.threads > 0 ? policy.threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t threads_per_node = std::max<size_t>(1, threads / node_count);
+
+    std::vector<std::atomic<size_t>> next_block(node_count);
+    std::atomic<size_t> bytes_prefaulted{0};
+    std::atomic<size_t> bytes_locked{0};
+    std::atomic<size_t> lock_failures{0};
+
+    auto worker = [&](size_t node) {
+        if (!nodes.empty()) {
+            bind_current_thread(nodes[node]);
+        }
+        const auto& list = node_blocks[node];
+        for (size_t i = next_block[node]++; i < list.size(); i = next_block[node]++) {
+            bool locked = false;
+            size_t bytes = list[i]->prefault(policy.lock_memory, &locked);
+            bytes_prefaulted += bytes;
+            if (policy.lock_memory) {
+                if (locked) {
+                    bytes_locked += bytes;
+                } else {
+                    lock_failures++;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t node = 0; node < node_count; ++node) {
+        size_t count = std::min(threads_per_node, node_blocks[node].size());
+        for (size_t i = 0; i < count; ++i) {
+            workers.emplace_back(worker, node);
+        }
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    WarmUpReport report;
+    report.blocks = blocks.size();
+    report.bytes_prefaulted = bytes_prefaulted.load();
+    report.bytes_locked = bytes_locked.load();
+    report.lock_failures = lock_failures.load();
+    report.threads = workers.size();
+    report.numa_nodes = node_count;
+    report.populate_supported = populate_write_supported.load();
+    report.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (report.lock_failures > 0) {
+        std::cerr << "[WARNING] " << report.lock_failures << " 个块 mlock 失败，请检查 RLIMIT_MEMLOCK" << std::endl;
+    }
+    if (config_.verbose) {
+        std::cout << "[INFO] 预热完成: " << report.blocks << " 个块, "
+                  << (double)report.bytes_prefaulted / (1024 * 1024) << " MB, "
+                  << report.threads << " 个线程, " << report.numa_nodes << " 个 NUMA 节点, 耗时 "
+                  << report.elapsed_ms << " ms" << std::endl;
+    }
+
+    return report;
+}
+
+size_t MemoryPoolManager::purge_idle_memory(std::chrono::milliseconds decay) {
+    std::lock_guard<std::mutex> lock(manager_mutex_);
+    last_purge_ms_ = now_ms();
+    return purge_all_unlocked(decay);
+}
+
+void MemoryPoolManager::lock_for_fork() {
+    pressure_->lock_for_fork();
+    tags_mutex_.lock();
+    if (recorder_) {
+        recorder_->lock_for_fork();
+    }
+    if (slab_) {
+        slab_->lock_for_fork();
+    }
+    manager_mutex_.lock();
+    for (auto* blocks : {&small_blocks_, &medium_blocks_, &large_blocks_}) {
+        for (auto& block : *blocks) {
+            block->lock_for_fork();
+        }
+    }
+}
+
+void MemoryPoolManager::unlock_after_fork() {
+    for (auto* blocks : {&large_blocks_, &medium_blocks_, &small_blocks_}) {
+        for (auto it = blocks->rbegin(); it != blocks->rend(); ++it) {
+            (*it)->unlock_after_fork();
+        }
+    }
+    manager_mutex_.unlock();
+    if (slab_) {
+        slab_->unlock_after_fork();
+    }
+    if (recorder_) {
+        recorder_->unlock_after_fork();
+    }
+    tags_mutex_.unlock();
+    pressure_->unlock_after_fork();
+}
+
+size_t MemoryPoolManager::purge_all_unlocked(std::chrono::milliseconds decay) {
+    size_t purged = 0;
+    for (auto* blocks : {&small_blocks_, &medium_blocks_, &large_blocks_}) {
+        for (auto& block : *blocks) {
+            purged += block->purge_idle(decay);
+        }
+    }
+    return purged;
+}
+
+void MemoryPoolManager::maybe_purge() {
+    if (config_.purge_decay_ms == 0) {
+        return;
+    }
+
+    // 持锁只做选块：一次 madvise 遍历可能很慢，不能让其它线程的分配和释放等在 manager_mutex_ 上
+    MemoryBlock* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+        if (purge_cursor_ == 0 &&
+            static_cast<uint32_t>(now_ms() - last_purge_ms_) < config_.purge_interval_ms) {
+            return;
+        }
+
+        // 块在构造后不再增删，按 小 -> 中 -> 大 的顺序每次取一个
+        size_t index = purge_cursor_;
+        for (auto* blocks : {&small_blocks_, &medium_blocks_, &large_blocks_}) {
+            if (index < blocks->size()) {
+                block = (*blocks)[index].get();
+                break;
+            }
+            index -= blocks->size();
+        }
+
+        if (block) {
+            ++purge_cursor_;
+        } else {
+            purge_cursor_ = 0;
+            last_purge_ms_ = now_ms();
+            return;
+        }
+    }
+
+    // 只持有块自己的锁
+    block->purge_idle(std::chrono::milliseconds(config_.purge_decay_ms));
+}
+
+MemoryTag MemoryPoolManager::register_tag(const std::string& name, size_t soft_limit, size_t hard_limit) {
+    std::lock_guard<std::mutex> lock(tags_mutex_);
+
+    size_t index = tag_count_.load(std::memory_order_relaxed);
+    if (index >= MAX_MEMORY_TAGS) {
+        if (config_.verbose) {
+            std::cerr << "[ERROR] 内存标签数量超过上限 " << MAX_MEMORY_TAGS << "，" << name << " 按未标记处理" << std::endl;
+        }
+        return UNTAGGED;
+    }
+
+    TagState& state = tags_[index];
+    state.name = name;
+    state.soft_limit.store(soft_limit, std::memory_order_relaxed);
+    state.hard_limit.store(hard_limit, std::memory_order_relaxed);
+
+    // 先写好标签信息再发布
+    tag_count_.store(index + 1, std::memory_order_release);
+    return static_cast<MemoryTag>(index);
+}
+
+bool MemoryPoolManager::set_tag_limits(MemoryTag tag, size_t soft_limit, size_t hard_limit) {
+    if (tag >= tag_count_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    tags_[tag].soft_limit.store(soft_limit, std::memory_order_relaxed);
+    tags_[tag].hard_limit.store(hard_limit, std::memory_order_relaxed);
+    return true;
+}
+
+size_t MemoryPoolManager::get_tag_usage(MemoryTag tag) const {
+    if (tag >= tag_count_.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    return tags_[tag].used.load(std::memory_order_relaxed);
+}
+
+bool MemoryPoolManager::charge_tag(MemoryTag tag, size_t bytes) {
+    TagState& state = tags_[tag];
+
+    size_t used = state.used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t hard = state.hard_limit.load(std::memory_order_relaxed);
+    if (hard > 0 && used > hard) {
+        state.used.fetch_sub(bytes, std::memory_order_relaxed);
+        state.rejected_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    state.allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    size_t peak = state.peak.load(std::memory_order_relaxed);
+    while (used > peak && !state.peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+
+    // 跨过软限制时只告警一次，回落到软限制以下后重新计
+    size_t soft = state.soft_limit.load(std::memory_order_relaxed);
+    if (soft > 0 && used > soft && !state.over_soft.exchange(true, std::memory_order_relaxed)) {
+        state.soft_exceeded.fetch_add(1, std::memory_order_relaxed);
+        if (config_.verbose) {
+            std::cerr << "[WARNING] 内存标签 " << state.name << " 超过软限制: " << used << " / " << soft << " 字节" << std::endl;
+        }
+    }
+
+    pressure_->on_allocate(bytes);
+    return true;
+}
+
+void MemoryPoolManager::uncharge_tag(MemoryTag tag, size_t bytes) {
+    TagState& state = tags_[tag];
+    size_t used = state.used.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+    pressure_->on_free(bytes);
+
+    size_t soft = state.soft_limit.load(std::memory_order_relaxed);
+    if (used <= soft && state.over_soft.load(std::memory_order_relaxed)) {
+        state.over_soft.store(false, std::memory_order_relaxed);
+    }
 }
@@ -12,6 +12,15 @@
 #include <atomic>
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <type_traits>
+#include <typeinfo>
+#include "heap_profiler.h"
+#include "allocation_trace.h"
+#include "memory_pressure.h"
 
 // ============================================================================
 // 内存对齐工具
@@ -27,6 +36,54 @@ inline constexpr size_t align_up(size_t size, size_t alignment) {
     return (size + alignment - 1) & ~(alignment - 1);
 }
 
+// ============================================================================
+// 分配标签（Allocation Tag）
+// ============================================================================
+
+/**
+ * @brief 分配标签，用于按子系统统计内存和限制预算
+ * 0 表示未标记，其他值由 MemoryPoolManager::register_tag 分配
+ */
+using MemoryTag = uint8_t;
+
+constexpr MemoryTag UNTAGGED = 0;
+constexpr size_t MAX_MEMORY_TAGS = 64;
+
+/**
+ * @brief 线程本地的当前标签，allocate(size) 未显式指定标签时使用
+ */
+inline MemoryTag& current_memory_tag() {
+    thread_local MemoryTag tag = UNTAGGED;
+    return tag;
+}
+
+/**
+ * @brief 作用域内的分配默认使用指定标签，离开作用域时恢复
+ *
+ * @code
+ * {
+ *     ScopedMemoryTag scope(network_tag);
+ *     void* buffer = pool.allocate(4096);   // 计入 network_tag
+ * }
+ * @endcode
+ */
+class ScopedMemoryTag {
+public:
+    explicit ScopedMemoryTag(MemoryTag tag) : previous_(current_memory_tag()) {
+        current_memory_tag() = tag;
+    }
+
+    ~ScopedMemoryTag() {
+        current_memory_tag() = previous_;
+    }
+
+    ScopedMemoryTag(const ScopedMemoryTag&) = delete;
+    ScopedMemoryTag& operator=(const ScopedMemoryTag&) = delete;
+
+private:
+    MemoryTag previous_;
+};
+
 // ============================================================================
 // 内存块管理（Block Management）
 // ============================================================================
@@ -39,14 +96,22 @@ struct MemoryBlockHeader {
     uint32_t magic;           // 魔数，用于验证块的有效性
     uint32_t block_size;      // 块的大小
     uint8_t is_free;          // 是否空闲（1=空闲，0=被占用）
-    uint32_t alignment_padding; // 对齐填充大小
+    uint8_t tag;              // 分配标签（MemoryTag），占用原有的填充字节
+    uint16_t alignment_padding; // 对齐填充大小（小于 ALIGNMENT）
+    uint32_t free_since;      // 变为空闲的时间（steady_clock 毫秒，按 32 位回绕），用于判断是否闲置足够久
     MemoryBlockHeader* next;   // 指向下一个块
     MemoryBlockHeader* prev;   // 指向上一个块
 };
 
+// 块头大小必须是 ALIGNMENT 的整数倍，数据区才能保持 16 字节对齐
+static_assert(sizeof(MemoryBlockHeader) % 16 == 0, "MemoryBlockHeader must keep 16-byte alignment");
+
 /**
  * @brief 内存池中的内存块类
  * 管理预分配的内存块，支持分割和合并
+ *
+ * 内存通过 mmap 获取，闲置超过衰减时间的空闲 chunk 可以用 madvise 把内部整页还给操作系统（purge），
+ * 被还回的页区间记录在 purged_ 中：再次分配时从记录中扣除，重复 purge 时跳过，统计不会重复计算。
  */
 class MemoryBlock {
 public:
@@ -68,16 +133,27 @@ public:
     /**
      * @brief 分配内存
      * @param size 申请的大小
+     * @param tag 分配标签，记录在块头中
      * @return 指向分配内存的指针，失败返回nullptr
      */
-    void* allocate(size_t size);
+    void* allocate(size_t size, MemoryTag tag = UNTAGGED);
 
     /**
      * @brief 释放内存
      * @param ptr 待释放的指针
+     * @param tag 输出参数（可选），释放的块的标签
+     * @param size 输出参数（可选），释放的块的大小
      * @return 释放是否成功
      */
-    bool deallocate(void* ptr);
+    bool deallocate(void* ptr, MemoryTag* tag = nullptr, size_t* size = nullptr);
+
+    /**
+     * @brief 已分配块的实际大小（调用者持有该块，块头不会被并发修改）
+     */
+    static size_t chunk_size(const void* ptr) {
+        return reinterpret_cast<const MemoryBlockHeader*>(
+            reinterpret_cast<const char*>(ptr) - sizeof(MemoryBlockHeader))->block_size;
+    }
 
     /**
      * @brief 获取块中的空闲内存大小
@@ -149,6 +225,45 @@ public:
      */
     size_t get_internal_fragmentation() const;
 
+    /**
+     * @brief 把闲置时间超过 decay 的空闲 chunk 的内部整页还给操作系统
+     * 优先使用 MADV_FREE（内存压力下才真正回收，开销小），内核不支持时退回 MADV_DONTNEED
+     * @param decay 闲置时间阈值，0 表示所有空闲 chunk
+     * @return 本次新还回或新标记为可回收的字节数
+     */
+    size_t purge_idle(std::chrono::milliseconds decay);
+
+    /**
+     * @brief 用 MADV_DONTNEED 还给操作系统（已不常驻）的字节数
+     */
+    size_t get_purged_bytes() const { return purged_bytes_.load(); }
+
+    /**
+     * @brief fork 前后锁住/释放块结构的锁（见 MemoryPoolManager::lock_for_fork）
+     */
+    void lock_for_fork() { block_mutex_.lock(); }
+    void unlock_after_fork() { block_mutex_.unlock(); }
+
+    /**
+     * @brief 用 MADV_FREE 标记为可回收的字节数
+     * 内核只在内存紧张时才真正回收这些页，回收之前仍然计入 RSS
+     */
+    size_t get_advised_bytes() const { return advised_bytes_.load(); }
+
+    /**
+     * @brief 预先让整个块的物理页常驻（预缺页），避免首次写入时在请求路径上缺页
+     * 优先使用 MADV_POPULATE_WRITE（Linux 5.14+），不支持时逐页做一次不改变内容的原子写
+     * @param lock_pages 是否用 mlock 锁定在内存中（锁定后 purge_idle 不再归还这些页）
+     * @param locked 输出参数（可选），是否锁定成功（超过 RLIMIT_MEMLOCK 时失败）
+     * @return 预缺页的字节数
+     */
+    size_t prefault(bool lock_pages, bool* locked = nullptr);
+
+    /**
+     * @brief 是否已被 mlock 锁定
+     */
+    bool is_locked() const { return locked_.load(); }
+
 private:
     /**
      * @brief 查找足够大小的空闲块
@@ -182,39 +297,161 @@ private:
      */
     void update_cached_max_free_size();
 
-    void* raw_memory_;           // 原始内存指针
+    /**
+     * @brief 把 [begin, end) 所在的页从 purged_ 中移除（这些页即将被写入，重新常驻）
+     * 调用前必须已持有 block_mutex_
+     */
+    void mark_resident(char* begin, char* end);
+
+    /**
+     * @brief 对页对齐区间 [begin, end) 中尚未还回的部分调用 madvise，并记录到 purged_
+     * 调用前必须已持有 block_mutex_
+     * @return 新还回或新标记为可回收的字节数
+     */
+    size_t purge_range(char* begin, char* end);
+
+    /**
+     * @brief 把 [begin, end) 记录到 purged_，与相邻的同类区间合并
+     * 调用前必须已持有 block_mutex_，且区间与已有记录不重叠
+     */
+    void insert_released(uintptr_t begin, uintptr_t end, bool lazy);
+
+    /**
+     * @brief 按归还方式选择统计计数器
+     */
+    std::atomic<size_t>& released_counter(bool lazy) { return lazy ? advised_bytes_ : purged_bytes_; }
+
+    /**
+     * @brief 已归还的页区间
+     */
+    struct ReleasedRange {
+        uintptr_t end;  // 结束地址
+        bool lazy;      // true 表示 MADV_FREE，false 表示 MADV_DONTNEED
+    };
+
+    void* raw_memory_;           // 原始内存指针（mmap 获得，页对齐）
     size_t total_size_;          // 总内存大小
+    size_t mapped_size_;         // mmap 的大小（按页向上取整）
     std::atomic<size_t> used_size_;  // 已使用内存大小（线程安全）
     std::atomic<size_t> cached_max_free_size_;  // 缓存的最大空闲块大小
     MemoryBlockHeader* first_block_; // 首个块的指针
     mutable std::mutex block_mutex_;     // 保护块结构的互斥锁（mutable允许在const函数中使用）
+
+    std::map<uintptr_t, ReleasedRange> purged_;  // 已还给操作系统的页区间：起始地址 -> 结束地址和归还方式
+    std::atomic<size_t> purged_bytes_;       // purged_ 中 MADV_DONTNEED 区间的总字节数
+    std::atomic<size_t> advised_bytes_;      // purged_ 中 MADV_FREE 区间的总字节数
+    std::atomic<bool> locked_;               // 是否已被 mlock 锁定
 };
 
 // ============================================================================
 // 对象池管理（Object Pool Management）
 // ============================================================================
 
+template<typename T>
+class ObjectPool;
+
+/**
+ * @brief 对象归还时的重置策略
+ * 默认：T 有 reset() 成员时调用它，否则什么都不做。重置只应清空状态、保留已分配的缓冲区
+ * （例如 vector::clear() 而不是 shrink_to_fit），这样回收的对象下次使用时不需要重新分配。
+ * 不方便修改的类型可以特化：
+ * @code
+ * template<> struct ObjectPoolReset<std::string> {
+ *     void operator()(std::string& s) const { s.clear(); }
+ * };
+ * @endcode
+ */
+template<typename T, typename = void>
+struct ObjectPoolReset {
+    void operator()(T&) const {}
+};
+
+template<typename T>
+struct ObjectPoolReset<T, std::void_t<decltype(std::declval<T&>().reset())>> {
+    void operator()(T& obj) const { obj.reset(); }
+};
+
+/**
+ * @brief PooledPtr 的删除器，把对象归还给所属的对象池
+ */
+template<typename T>
+class PoolDeleter {
+public:
+    PoolDeleter() noexcept : pool_(nullptr) {}
+    explicit PoolDeleter(ObjectPool<T>* pool) noexcept : pool_(pool) {}
+
+    void operator()(T* obj) const {
+        if (pool_) {
+            pool_->release(obj);
+        } else {
+            delete obj;
+        }
+    }
+
+    ObjectPool<T>* get_pool() const noexcept { return pool_; }
+
+private:
+    ObjectPool<T>* pool_;
+};
+
+/**
+ * @brief 从对象池获取的对象句柄，离开作用域时自动归还（对象池必须比句柄活得久）
+ */
+template<typename T>
+using PooledPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+/**
+ * @brief 对象池的收缩策略
+ * 每次 trim 时把高水位衰减为 max(上个周期的峰值, 高水位 * decay)，只保留高水位以内的对象：
+ * 突发流量过后，多出来的空闲对象在几个周期内逐步释放，而稳定的负载不会被反复收缩和重建
+ */
+struct ObjectPoolTrimPolicy {
+    double decay;               // 每个周期高水位的衰减系数（0~1），越小收缩越快
+    size_t interval_ms;         // 自动 trim 的周期，0 表示只在手动调用 trim() 时收缩
+
+    ObjectPoolTrimPolicy(double decay_factor = 0.5, size_t interval = 0)
+        : decay(decay_factor), interval_ms(interval) {}
+};
+
 /**
  * @brief 通用对象池类
- * 支持预创建固定数量的对象，提供快速的获取和归还机制
+ * 支持预创建固定数量的对象，提供快速的获取和归还机制：
+ * 1. acquire() 返回 PooledPtr，析构时自动归还，不会因为忘记 release 而泄漏到池销毁
+ * 2. 归还时调用 ObjectPoolReset<T>（默认是 T::reset()），对象保留内部缓冲区以便复用
+ * 3. 空闲对象按后进先出复用（最近归还的对象还在缓存中），对象创建后登记一次，
+ *    稳定状态下 acquire/release 不再有任何堆分配
+ * 4. acquire_n/release_n 在一次加锁内批量获取和归还；trim() 按衰减高水位释放多余的空闲对象
  */
 template<typename T>
 class ObjectPool {
 public:
     /**
      * @brief 构造函数
-     * @param initial_capacity 初始对象数量
+     * @param initial_capacity 初始对象数量（trim 不会收缩到这个数量以下）
      * @param max_capacity 最大对象数量
+     * @param policy 收缩策略
      */
-    ObjectPool(size_t initial_capacity = 100, size_t max_capacity = 1000)
+    ObjectPool(size_t initial_capacity = 100, size_t max_capacity = 1000,
+               const ObjectPoolTrimPolicy& policy = ObjectPoolTrimPolicy())
         : initial_capacity_(initial_capacity),
           max_capacity_(max_capacity),
           current_size_(0),
-          peak_used_(0) {
+          used_count_(0),
+          peak_used_(0),
+          policy_(policy),
+          window_peak_(0),
+          decayed_peak_(0),
+          trimmed_count_(0),
+          releases_since_check_(0),
+          last_trim_(std::chrono::steady_clock::now()) {
 
         // 预创建初始对象
+        free_objects_.reserve(initial_capacity_);
+        objects_.reserve(initial_capacity_);
         for (size_t i = 0; i < initial_capacity_; ++i) {
-            free_objects_.push(new T());
+            T* obj = new T();
+            objects_.emplace(obj, false);
+            free_objects_.push_back(obj);
         }
         current_size_ = initial_capacity_;
     }
@@ -225,69 +462,222 @@ public:
     ~ObjectPool() {
         std::lock_guard<std::mutex> lock(pool_mutex_);
 
-        while (!free_objects_.empty()) {
-            T* obj = free_objects_.front();
-            free_objects_.pop();
-            delete obj;
+        // 删除所有对象（包括仍在使用中的）
+        for (auto& entry : objects_) {
+            delete entry.first;
         }
+        objects_.clear();
+        free_objects_.clear();
+    }
 
-        // 删除已使用的对象
-        for (auto obj : used_objects_) {
-            delete obj;
-        }
-        used_objects_.clear();
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * @brief 获取一个对象，句柄析构时自动归还
+     * @return 对象句柄，池已满时为空
+     */
+    PooledPtr<T> acquire() {
+        return PooledPtr<T>(acquire_raw(), PoolDeleter<T>(this));
     }
 
     /**
-     * @brief 获取一个对象
-     * @return 指向对象的指针
+     * @brief 获取一个对象（裸指针），必须手动调用 release 归还
+     * @return 指向对象的指针，池已满时返回nullptr
      */
-    T* acquire() {
+    T* acquire_raw() {
         std::lock_guard<std::mutex> lock(pool_mutex_);
-
-        T* obj = nullptr;
-
-        if (!free_objects_.empty()) {
-            obj = free_objects_.front();
-            free_objects_.pop();
-        } else if (current_size_ < max_capacity_) {
-            // 动态扩展
-            obj = new T();
-            current_size_++;
-        } else {
-            // 池已满，返回nullptr
-            return nullptr;
+        T* obj = take_locked();
+        if (obj) {
+            update_peak_locked();
         }
+        return obj;
+    }
 
-        used_objects_.insert(obj);
-
-        // 更新峰值使用数
-        if (used_objects_.size() > peak_used_) {
-            peak_used_ = used_objects_.size();
+    /**
+     * @brief 在一次加锁内获取最多 n 个对象
+     * @param out 输出数组，至少能容纳 n 个指针
+     * @param n 期望的数量
+     * @return 实际获取的数量（池已满时可能少于 n）
+     */
+    size_t acquire_n(T** out, size_t n) {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        size_t count = 0;
+        while (count < n) {
+            T* obj = take_locked();
+            if (!obj) break;
+            out[count++] = obj;
+        }
+        if (count > 0) {
+            update_peak_locked();
         }
+        return count;
+    }
 
-        return obj;
+    /**
+     * @brief 在一次加锁内获取最多 n 个对象，以句柄形式追加到 out
+     * @return 实际获取的数量
+     */
+    size_t acquire_n(size_t n, std::vector<PooledPtr<T>>& out) {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        size_t count = 0;
+        while (count < n) {
+            T* obj = take_locked();
+            if (!obj) break;
+            out.emplace_back(obj, PoolDeleter<T>(this));
+            count++;
+        }
+        if (count > 0) {
+            update_peak_locked();
+        }
+        return count;
     }
 
     /**
-     * @brief 归还一个对象
+     * @brief 归还一个对象，归还前调用 ObjectPoolReset<T> 重置状态
      * @param obj 待归还的对象指针
      * @return 是否成功归还
      */
     bool release(T* obj) {
         if (!obj) return false;
 
-        std::lock_guard<std::mutex> lock(pool_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            if (!mark_free_locked(obj)) {
+                return false;
+            }
+        }
 
-        // 从使用集合中移除（O(1) 平均复杂度）
-        auto it = used_objects_.find(obj);
-        if (it != used_objects_.end()) {
-            used_objects_.erase(it);
-            free_objects_.push(obj);
-            return true;
+        // 重置可能比较耗时（清空缓冲区等），不持有锁。对象此时已标记为空闲但还不在空闲列表中，
+        // 不会被其他线程取走
+        bool reusable = reset_object(obj);
+
+        bool should_trim = false;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            if (reusable) {
+                free_objects_.push_back(obj);
+            } else {
+                discard_locked(obj);
+            }
+            should_trim = trim_due_locked(1);
+        }
+        if (!reusable) {
+            delete obj;
+        }
+        if (should_trim) {
+            trim();
+        }
+        return true;
+    }
+
+    /**
+     * @brief 批量归还：验证和入队各只加一次锁
+     * @param objs 待归还的对象指针
+     * @param n 数量
+     * @return 成功归还的数量
+     */
+    size_t release_n(T* const* objs, size_t n) {
+        // 线程本地的暂存区只增长不收缩，稳定状态下不分配
+        thread_local std::vector<T*> accepted;
+        accepted.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            for (size_t i = 0; i < n; ++i) {
+                if (objs[i] && mark_free_locked(objs[i])) {
+                    accepted.push_back(objs[i]);
+                }
+            }
+        }
+
+        // 重置失败的对象移到末尾，之后统一删除
+        size_t reusable = 0;
+        for (size_t i = 0; i < accepted.size(); ++i) {
+            if (reset_object(accepted[i])) {
+                std::swap(accepted[reusable++], accepted[i]);
+            }
         }
 
-        return false;
+        bool should_trim = false;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            free_objects_.insert(free_objects_.end(), accepted.begin(), accepted.begin() + reusable);
+            for (size_t i = reusable; i < accepted.size(); ++i) {
+                discard_locked(accepted[i]);
+            }
+            should_trim = trim_due_locked(accepted.size());
+        }
+        for (size_t i = reusable; i < accepted.size(); ++i) {
+            delete accepted[i];
+        }
+        if (should_trim) {
+            trim();
+        }
+        return accepted.size();
+    }
+
+    /**
+     * @brief 批量归还句柄，归还后 handles 被清空
+     * @return 成功归还的数量
+     */
+    size_t release_n(std::vector<PooledPtr<T>>& handles) {
+        thread_local std::vector<T*> raw;
+        raw.clear();
+        for (auto& handle : handles) {
+            // 只接管属于本池的句柄，其他句柄随 clear() 按各自的删除器处理
+            if (handle && handle.get_deleter().get_pool() == this) {
+                raw.push_back(handle.release());
+            }
+        }
+        handles.clear();
+        return release_n(raw.data(), raw.size());
+    }
+
+    /**
+     * @brief 按衰减高水位释放多余的空闲对象
+     * 高水位 = max(上次 trim 以来的使用峰值, 上一次高水位 * decay)，保留 max(高水位, initial_capacity) 个对象
+     * @return 本次释放的对象数
+     */
+    size_t trim() {
+        std::vector<T*> victims;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            decayed_peak_ = std::max(static_cast<double>(window_peak_), decayed_peak_ * policy_.decay);
+            window_peak_ = used_count_;
+            last_trim_ = std::chrono::steady_clock::now();
+            releases_since_check_ = 0;
+
+            size_t target = std::max(initial_capacity_, static_cast<size_t>(std::ceil(decayed_peak_)));
+            size_t current = current_size_;
+            if (current <= target) {
+                return 0;
+            }
+
+            // 后进先出的栈底是最久没有用过的对象，优先释放
+            size_t excess = std::min(current - target, free_objects_.size());
+            victims.assign(free_objects_.begin(), free_objects_.begin() + excess);
+            free_objects_.erase(free_objects_.begin(), free_objects_.begin() + excess);
+            for (T* obj : victims) {
+                objects_.erase(obj);
+            }
+            current_size_ -= excess;
+            trimmed_count_ += excess;
+        }
+
+        // 析构可能比较耗时，不持有锁
+        for (T* obj : victims) {
+            delete obj;
+        }
+        return victims.size();
+    }
+
+    /**
+     * @brief 修改收缩策略
+     */
+    void set_trim_policy(const ObjectPoolTrimPolicy& policy) {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        policy_ = policy;
     }
 
     /**
@@ -303,7 +693,7 @@ public:
      */
     size_t get_used_count() const {
         std::lock_guard<std::mutex> lock(pool_mutex_);
-        return used_objects_.size();
+        return used_count_;
     }
 
     /**
@@ -322,6 +712,14 @@ public:
         return current_size_;
     }
 
+    /**
+     * @brief 获取 trim 累计释放的对象数
+     */
+    size_t get_trimmed_count() const {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        return trimmed_count_;
+    }
+
     /**
      * @brief 打印对象池的统计信息
      */
@@ -329,21 +727,258 @@ public:
         std::lock_guard<std::mutex> lock(pool_mutex_);
         std::cout << "ObjectPool<" << typeid(T).name() << "> Statistics:" << std::endl;
         std::cout << "  Free Objects: " << free_objects_.size() << std::endl;
-        std::cout << "  Used Objects: " << used_objects_.size() << std::endl;
+        std::cout << "  Used Objects: " << used_count_ << std::endl;
         std::cout << "  Peak Used: " << peak_used_ << std::endl;
+        std::cout << "  Decayed High-Water Mark: " << static_cast<size_t>(std::ceil(decayed_peak_)) << std::endl;
+        std::cout << "  Trimmed Objects: " << trimmed_count_ << std::endl;
         std::cout << "  Total Capacity: " << current_size_ << std::endl;
     }
 
 private:
-    std::queue<T*> free_objects_;              // 空闲对象队列
-    std::unordered_set<T*> used_objects_;      // 使用中的对象集合（O(1) 查找/删除）
+    /**
+     * @brief 取出一个空闲对象，没有时在容量范围内创建（调用前必须持有 pool_mutex_）
+     */
+    T* take_locked() {
+        T* obj = nullptr;
+
+        if (!free_objects_.empty()) {
+            obj = free_objects_.back();
+            free_objects_.pop_back();
+            objects_[obj] = true;
+        } else if (current_size_ < max_capacity_) {
+            // 动态扩展
+            obj = new T();
+            objects_.emplace(obj, true);
+            current_size_++;
+        } else {
+            // 池已满
+            return nullptr;
+        }
+
+        ++used_count_;
+        return obj;
+    }
+
+    /**
+     * @brief 更新峰值使用数（调用前必须持有 pool_mutex_）
+     */
+    void update_peak_locked() {
+        if (used_count_ > peak_used_) {
+            peak_used_ = used_count_;
+        }
+        window_peak_ = std::max(window_peak_, used_count_);
+    }
+
+    /**
+     * @brief 只接受本池创建且正在使用中的对象，标记为空闲（调用前必须持有 pool_mutex_）
+     */
+    bool mark_free_locked(T* obj) {
+        auto it = objects_.find(obj);
+        if (it == objects_.end() || !it->second) {
+            return false;
+        }
+        it->second = false;
+        --used_count_;
+        return true;
+    }
+
+    /**
+     * @brief 从池中移除一个对象，由调用者在锁外删除（调用前必须持有 pool_mutex_）
+     */
+    void discard_locked(T* obj) {
+        objects_.erase(obj);
+        current_size_--;
+    }
+
+    /**
+     * @brief 重置对象，失败时返回false（对象状态不可信，应当丢弃）
+     */
+    static bool reset_object(T* obj) {
+        try {
+            ObjectPoolReset<T>()(*obj);
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "[WARNING] 对象重置失败，丢弃该对象: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    /**
+     * @brief 是否到了自动 trim 的时间，每 64 次归还才读一次时钟（调用前必须持有 pool_mutex_）
+     */
+    bool trim_due_locked(size_t released) {
+        if (policy_.interval_ms == 0) return false;
+        releases_since_check_ += released;
+        if (releases_since_check_ < 64) return false;
+        releases_since_check_ = 0;
+        return std::chrono::steady_clock::now() - last_trim_ >= std::chrono::milliseconds(policy_.interval_ms);
+    }
+
+    std::vector<T*> free_objects_;             // 空闲对象栈（后进先出，只增长不收缩）
+    std::unordered_map<T*, bool> objects_;     // 本池创建的所有对象 -> 是否使用中（创建时登记一次）
     size_t initial_capacity_;                  // 初始容量
     size_t max_capacity_;                      // 最大容量
     std::atomic<size_t> current_size_;         // 当前创建的对象总数
+    size_t used_count_;                        // 使用中的对象数
     std::atomic<size_t> peak_used_;            // 峰值使用数
+
+    // 收缩策略
+    ObjectPoolTrimPolicy policy_;
+    size_t window_peak_;                       // 上次 trim 以来的使用峰值
+    double decayed_peak_;                      // 衰减高水位
+    size_t trimmed_count_;                     // 累计释放的对象数
+    size_t releases_since_check_;              // 距离上次检查时钟的归还次数
+    std::chrono::steady_clock::time_point last_trim_;
+
     mutable std::mutex pool_mutex_;            // 保护池结构的互斥锁
 };
 
+// ============================================================================
+// 小对象 Slab 分配器（Small Object Slab Allocator）
+// ============================================================================
+
+/**
+ * @brief Slab 页头，位于每个 64KB slab 的起始位置
+ * slab 按 SLAB_SIZE 对齐，对象地址屏蔽低位即可找到所属 slab，对象本身不带任何头部
+ */
+struct SlabHeader {
+    uint32_t magic;             // 魔数，校验 slab 有效性
+    uint16_t size_class;        // 大小类下标
+    uint16_t object_size;       // 对象大小
+    uint32_t capacity;          // 对象总数
+    uint32_t free_count;        // 空闲对象数
+    uint32_t first_offset;      // 第一个对象相对 slab 起始的偏移
+    uint32_t search_hint;       // 下次从哪个位图字开始查找空闲位
+    SlabHeader* next;           // 同一大小类的 partial 链表
+    SlabHeader* prev;
+    bool in_partial;            // 是否在 partial 链表中
+    uint64_t bitmap[64];        // 占用位图，1=已分配（64KB / 16B = 4096 位）
+    // 紧跟页头的是每个对象一个字节的标签数组（capacity 字节），之后才是对象区
+};
+
+/**
+ * @brief 小对象分配器
+ * 处理 <= 256 字节的分配，按 16 字节分为 16 个大小类，每个大小类由若干 64KB slab 组成：
+ * 1. slab 从一次 mmap(MAP_NORESERVE) 预留的连续地址空间中切出，物理页在首次写入时才分配
+ * 2. 通过地址范围判断指针是否属于 slab 区域，通过屏蔽低位找到 slab 头，释放是 O(1) 的
+ * 3. 每个大小类一把锁，不同大小的分配互不竞争，也不经过 MemoryPoolManager 的全局锁
+ * 4. 完全空闲的 slab 归还到全局空闲列表，可以被其他大小类复用
+ */
+class SlabAllocator {
+public:
+    static constexpr size_t SLAB_SIZE = 64 * 1024;          // 每个 slab 的大小
+    static constexpr size_t SIZE_CLASS_STEP = 16;           // 大小类步长
+    static constexpr size_t MAX_OBJECT_SIZE = 256;          // 走 slab 路径的最大分配
+    static constexpr size_t SIZE_CLASS_COUNT = MAX_OBJECT_SIZE / SIZE_CLASS_STEP;
+    static constexpr uint32_t SLAB_MAGIC = 0x51AB51AB;
+
+    /**
+     * @brief 构造函数
+     * @param region_size 预留的地址空间大小（按 SLAB_SIZE 向上取整）
+     */
+    explicit SlabAllocator(size_t region_size);
+
+    ~SlabAllocator();
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    /**
+     * @brief 分配小对象
+     * @param size 申请大小（1 ~ MAX_OBJECT_SIZE）
+     * @param tag 分配标签，记录在 slab 的标签数组中
+     * @return 16 字节对齐的指针，预留区域耗尽时返回nullptr
+     */
+    void* allocate(size_t size, MemoryTag tag = UNTAGGED);
+
+    /**
+     * @brief 释放小对象
+     * @param ptr 由 allocate 返回的指针
+     * @param tag 输出参数（可选），对象的标签
+     * @param size 输出参数（可选），对象大小
+     * @return 是否释放成功（重复释放或非法指针返回false）
+     */
+    bool deallocate(void* ptr, MemoryTag* tag = nullptr, size_t* size = nullptr);
+
+    /**
+     * @brief 判断指针是否位于 slab 区域（无锁）
+     */
+    bool owns(const void* ptr) const {
+        return ptr >= region_ && ptr < region_end_;
+    }
+
+    /**
+     * @brief 获取对象所在大小类的对象大小
+     */
+    size_t usable_size(const void* ptr) const;
+
+    /**
+     * @brief 大小到大小类下标的映射
+     */
+    static size_t size_class_of(size_t size) {
+        return (size + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP - 1;
+    }
+
+    /**
+     * @brief 已切出的 slab 占用的字节数
+     */
+    size_t get_slab_bytes() const { return slab_count_.load() * SLAB_SIZE; }
+
+    /**
+     * @brief 已分配对象的总字节数（按大小类计）
+     */
+    size_t get_used_bytes() const { return used_bytes_.load(); }
+
+    /**
+     * @brief 打印每个大小类的统计信息
+     */
+    void print_stats() const;
+
+    /**
+     * @brief fork 前按加锁顺序（各大小类 -> region_mutex_）锁住所有锁
+     */
+    void lock_for_fork();
+
+    /**
+     * @brief fork 后在父进程和子进程中释放 lock_for_fork 持有的锁
+     */
+    void unlock_after_fork();
+
+private:
+    struct SizeClass {
+        mutable std::mutex mutex;           // 保护本大小类的 partial 链表和 slab 位图
+        SlabHeader* partial = nullptr;      // 还有空闲对象的 slab
+        size_t slab_count = 0;              // 本大小类持有的 slab 数量
+        size_t used_objects = 0;            // 已分配对象数
+    };
+
+    /**
+     * @brief 为大小类准备一个新的 slab（优先复用空闲 slab）
+     */
+    SlabHeader* acquire_slab(size_t class_index);
+
+    /**
+     * @brief 把完全空闲的 slab 归还到全局空闲列表
+     */
+    void release_slab(SlabHeader* slab);
+
+    static void push_partial(SizeClass& sc, SlabHeader* slab);
+    static void remove_partial(SizeClass& sc, SlabHeader* slab);
+
+    char* region_;                          // 预留区域起始（SLAB_SIZE 对齐）
+    char* region_end_;                      // 预留区域结束
+    void* mapping_;                         // mmap 返回的原始地址
+    size_t mapping_size_;                   // mmap 的原始大小
+
+    std::mutex region_mutex_;               // 保护 next_slab_ 和 free_slabs_
+    char* next_slab_;                       // 下一个未使用的 slab
+    std::vector<char*> free_slabs_;         // 已归还的空闲 slab
+
+    SizeClass classes_[SIZE_CLASS_COUNT];
+    std::atomic<size_t> slab_count_;        // 已切出（未归还）的 slab 数量
+    std::atomic<size_t> used_bytes_;        // 已分配对象的总字节数
+};
+
 // ============================================================================
 // 多层级内存池管理器（Tiered Memory Pool Manager）
 // ============================================================================
@@ -356,6 +991,14 @@ struct MemoryPoolConfig {
     size_t medium_block_size;   // 中块大小（字节）
     size_t large_block_size;    // 大块大小（字节）
     size_t block_count;         // 每种大小的块数量
+    bool enable_slab;           // 是否启用小对象 slab 分配器（<= 256 字节）
+    size_t slab_region_size;    // slab 预留的地址空间大小（字节）
+    size_t purge_decay_ms;      // 空闲 chunk 闲置超过该时间后把物理页还给操作系统，0 表示不自动 purge
+    size_t purge_interval_ms;   // 自动 purge 的最小间隔
+    size_t heap_profile_interval; // 堆分析平均采样间隔（字节），0 表示关闭
+    std::string trace_path;     // 分配轨迹文件路径，为空表示不录制
+    bool verbose;               // 是否打印初始化信息和分配失败等诊断（作为 malloc 替换时必须关闭）
+    size_t soft_memory_limit;   // 压力回调计算使用比例的基准（字节），0 表示池的总容量；只用于通知，不拒绝分配
 
     MemoryPoolConfig(
         size_t small = 256 * 1024,      // 256KB
@@ -365,7 +1008,55 @@ struct MemoryPoolConfig {
     ) : small_block_size(small),
         medium_block_size(medium),
         large_block_size(large),
-        block_count(count) {}
+        block_count(count),
+        enable_slab(true),
+        slab_region_size(64 * 1024 * 1024),   // 64MB，MAP_NORESERVE 只占地址空间
+        purge_decay_ms(10000),                // 与 jemalloc 默认的 dirty decay 一致
+        purge_interval_ms(1000),
+        heap_profile_interval(0),
+        trace_path(),
+        verbose(true),
+        soft_memory_limit(0) {}
+};
+
+/**
+ * @brief 启动预热策略
+ */
+struct WarmUpPolicy {
+    size_t threads;         // 预热线程总数，0 表示硬件线程数（不超过块数）
+    bool numa_aware;        // 多 NUMA 节点时把块分给各节点，线程绑定到节点的 CPU 上预缺页（首次写入决定页所在节点）
+    bool lock_memory;       // 是否 mlock 锁定所有块，防止被换出
+
+    WarmUpPolicy() : threads(0), numa_aware(true), lock_memory(false) {}
+};
+
+/**
+ * @brief 预热结果
+ */
+struct WarmUpReport {
+    size_t blocks;              // 预热的块数
+    size_t bytes_prefaulted;    // 预缺页的字节数
+    size_t bytes_locked;        // 成功 mlock 的字节数
+    size_t lock_failures;       // mlock 失败的块数（通常是 RLIMIT_MEMLOCK 不够）
+    size_t threads;             // 实际使用的线程数
+    size_t numa_nodes;          // 参与预热的 NUMA 节点数
+    bool populate_supported;    // 是否使用了 MADV_POPULATE_WRITE（否则逐页写入）
+    double elapsed_ms;          // 总耗时
+};
+
+/**
+ * @brief 单个标签的统计信息
+ */
+struct TagStatistics {
+    MemoryTag tag;            // 标签
+    std::string name;         // 标签名
+    size_t used;              // 当前占用（字节）
+    size_t peak;              // 峰值占用
+    size_t soft_limit;        // 软限制，0 表示不限制
+    size_t hard_limit;        // 硬限制，0 表示不限制
+    size_t allocation_count;  // 成功分配次数
+    size_t rejected_count;    // 因超过硬限制被拒绝的次数
+    size_t soft_exceeded;     // 超过软限制的次数
 };
 
 /**
@@ -377,6 +1068,11 @@ struct PoolStatistics {
     size_t fragmentation_ratio; // 碎片率
     size_t block_count;       // 块总数
     double avg_utilization;   // 平均利用率
+    size_t slab_bytes;        // 小对象 slab 占用的内存
+    size_t slab_used;         // 小对象已分配的内存
+    size_t purged_bytes;      // 已用 MADV_DONTNEED 还给操作系统的内存（不计入常驻内存）
+    size_t advised_bytes;     // 已用 MADV_FREE 标记为可回收的内存（内核回收之前仍计入常驻内存）
+    std::vector<TagStatistics> tag_stats; // 每个标签的占用（包括 UNTAGGED）
 };
 
 /**
@@ -397,12 +1093,20 @@ public:
     ~MemoryPoolManager();
 
     /**
-     * @brief 分配内存
+     * @brief 分配内存，计入当前线程作用域的标签（见 ScopedMemoryTag）
      * @param size 申请的大小
      * @return 指向分配内存的指针
      */
     void* allocate(size_t size);
 
+    /**
+     * @brief 分配内存并计入指定标签
+     * @param size 申请的大小
+     * @param tag 分配标签，未注册的标签按 UNTAGGED 处理
+     * @return 指向分配内存的指针，超过标签的硬限制时返回nullptr
+     */
+    void* allocate(size_t size, MemoryTag tag);
+
     /**
      * @brief 释放内存
      * @param ptr 待释放的指针
@@ -410,6 +1114,43 @@ public:
      */
     bool deallocate(void* ptr);
 
+    /**
+     * @brief 指针是否由本管理器分配（只比较地址范围，不加锁：块和 slab 区域在构造后不再变化）
+     */
+    bool owns(const void* ptr) const;
+
+    /**
+     * @brief 指针实际可用的字节数（不小于申请的大小），不属于本管理器时返回0
+     */
+    size_t usable_size(const void* ptr) const;
+
+    /**
+     * @brief 启动预热：在开始接收请求之前让所有层级的块常驻内存
+     * 预热期间持有管理器锁，并发的分配会等待预热完成（slab 区域按需使用，不预热）
+     * @param policy 线程数、NUMA 绑定和 mlock 选项
+     * @return 预热结果和耗时
+     */
+    WarmUpReport warm_up(const WarmUpPolicy& policy = WarmUpPolicy());
+
+    /**
+     * @brief 注册一个分配标签（例如 cache / network / event）
+     * @param name 标签名
+     * @param soft_limit 软限制（字节），超过时打印警告并计数，0 表示不限制
+     * @param hard_limit 硬限制（字节），超过时分配失败，0 表示不限制
+     * @return 标签，标签数量达到 MAX_MEMORY_TAGS 时返回 UNTAGGED
+     */
+    MemoryTag register_tag(const std::string& name, size_t soft_limit = 0, size_t hard_limit = 0);
+
+    /**
+     * @brief 调整标签的限制
+     */
+    bool set_tag_limits(MemoryTag tag, size_t soft_limit, size_t hard_limit);
+
+    /**
+     * @brief 标签当前占用的字节数
+     */
+    size_t get_tag_usage(MemoryTag tag) const;
+
     /**
      * @brief 获取当前内存统计信息
      */
@@ -456,6 +1197,73 @@ public:
      */
     void reset_statistics();
 
+    /**
+     * @brief 立即把闲置超过 decay 的空闲内存还给操作系统
+     * @param decay 闲置时间阈值，0 表示所有空闲内存
+     * @return 本次新还回的字节数
+     */
+    size_t purge_idle_memory(std::chrono::milliseconds decay);
+
+    /**
+     * @brief fork 前锁住管理器用到的所有锁
+     * 顺序与正常路径一致：压力监控 -> tags_mutex_ -> 轨迹录制器 -> slab -> manager_mutex_ -> 各块的 block_mutex_
+     * （前三者持锁时可能分配内存，进入后面的锁；分配路径不会反过来持有池锁去拿前三者）。
+     * 作为 malloc 替换时由 pthread_atfork 的 prepare 回调调用，保证子进程继承的池结构是一致的，
+     * 不会继承一把被其它线程持有、永远不会释放的锁。堆分析器的表是无锁的，不需要处理
+     */
+    void lock_for_fork();
+
+    /**
+     * @brief fork 后在父进程和子进程中释放 lock_for_fork 持有的锁（与加锁顺序相反）
+     */
+    void unlock_after_fork();
+
+    /**
+     * @brief 获取堆分析器，未启用（heap_profile_interval == 0）时返回nullptr
+     * 导出示例：pool.get_heap_profiler()->write_profile("heap.prof", ProfileView::LIVE)
+     */
+    HeapProfiler* get_heap_profiler() const { return profiler_.get(); }
+
+    /**
+     * @brief 获取分配轨迹录制器，未启用（trace_path 为空）时返回nullptr
+     * 录制的轨迹可以用 trace_replay 工具在不同后端上回放
+     */
+    AllocationTraceRecorder* get_trace_recorder() const { return recorder_.get(); }
+
+    /**
+     * @brief 注册内存压力回调
+     * 使用量（所有标签之和）跨过 threshold * soft_memory_limit 时在通知线程中调用一次，
+     * 回落到阈值以下 5% 后重新布防。回调中可以释放内存（例如让缓存淘汰条目）
+     * @param threshold 使用比例阈值（0, 1]，例如 0.7 / 0.85 / 0.95
+     * @return 回调编号（用于注销），失败返回0
+     */
+    size_t register_pressure_callback(double threshold, PressureCallback callback) {
+        return pressure_->add_callback(threshold, std::move(callback));
+    }
+
+    /**
+     * @brief 注销内存压力回调
+     */
+    bool unregister_pressure_callback(size_t id) { return pressure_->remove_callback(id); }
+
+    /**
+     * @brief 同时监听内核 PSI（/proc/pressure/memory），系统内存紧张时以 SYSTEM_PSI 调用所有回调
+     * @return 内核不支持 PSI 或没有权限时返回false
+     */
+    bool enable_psi_monitor(size_t stall_us = 150000, size_t window_us = 2000000) {
+        return pressure_->enable_psi(stall_us, window_us);
+    }
+
+    /**
+     * @brief 当前使用量（所有标签之和，无锁）
+     */
+    size_t get_bytes_in_use() const { return pressure_->bytes_in_use(); }
+
+    /**
+     * @brief 压力回调计算使用比例的基准
+     */
+    size_t get_memory_limit() const { return pressure_->limit(); }
+
 private:
     /**
      * @brief 选择合适的块来分配内存
@@ -471,16 +1279,71 @@ private:
      */
     MemoryBlock* find_block_for_pointer(void* ptr);
 
+    /**
+     * @brief 自动 purge 的一步：距离上次 purge 超过 purge_interval_ms 时开始一轮，
+     * 之后每次调用只处理一个块，madvise 在 manager_mutex_ 之外进行
+     * 调用前不能持有 manager_mutex_
+     */
+    void maybe_purge();
+
+    /**
+     * @brief 对所有块执行 purge（调用前必须已持有 manager_mutex_）
+     */
+    size_t purge_all_unlocked(std::chrono::milliseconds decay);
+
     // 不同大小的内存块管理
     std::vector<std::unique_ptr<MemoryBlock>> small_blocks_;   // 小块池
     std::vector<std::unique_ptr<MemoryBlock>> medium_blocks_;  // 中块池
     std::vector<std::unique_ptr<MemoryBlock>> large_blocks_;   // 大块池
 
+    // 小对象分配器（<= 256 字节），有自己的分级锁，不经过 manager_mutex_
+    std::unique_ptr<SlabAllocator> slab_;
+
+    // 采样堆分析器（可选），自身无锁
+    std::unique_ptr<HeapProfiler> profiler_;
+
+    // 分配轨迹录制器（可选），每线程缓冲
+    std::unique_ptr<AllocationTraceRecorder> recorder_;
+
+    // 内存压力监视器，第一次注册回调时才启动通知线程
+    std::unique_ptr<MemoryPressureMonitor> pressure_;
+
     // 配置和统计
     MemoryPoolConfig config_;
     size_t total_allocated_;        // 总分配的内存
     std::atomic<size_t> allocation_count_;  // 分配计数
     std::atomic<size_t> deallocation_count_; // 释放计数
+    uint32_t last_purge_ms_;        // 上次自动 purge 一轮结束的时间
+    size_t purge_cursor_;           // 本轮自动 purge 下一个要处理的块，0 表示没有进行中的一轮
+
+    /**
+     * @brief 标签的预算和计数，全部是原子变量，分配路径不加锁
+     */
+    struct TagState {
+        std::string name;
+        std::atomic<size_t> soft_limit{0};
+        std::atomic<size_t> hard_limit{0};
+        std::atomic<size_t> used{0};
+        std::atomic<size_t> peak{0};
+        std::atomic<size_t> allocation_count{0};
+        std::atomic<size_t> rejected_count{0};
+        std::atomic<size_t> soft_exceeded{0};
+        std::atomic<bool> over_soft{false};   // 当前是否处于超过软限制的状态（避免重复告警）
+    };
+
+    /**
+     * @brief 为标签预留 bytes 字节，超过硬限制时返回false
+     */
+    bool charge_tag(MemoryTag tag, size_t bytes);
+
+    /**
+     * @brief 归还标签的 bytes 字节
+     */
+    void uncharge_tag(MemoryTag tag, size_t bytes);
+
+    TagState tags_[MAX_MEMORY_TAGS];
+    std::atomic<size_t> tag_count_;     // 已注册的标签数量（含 UNTAGGED）
+    std::mutex tags_mutex_;             // 保护注册过程
 
     // 线程安全
     mutable std::mutex manager_mutex_; // 保护管理器结构
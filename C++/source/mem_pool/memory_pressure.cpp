@@ -0,0 +1,266 @@
+#include "memory_pressure.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+MemoryPressureMonitor::MemoryPressureMonitor(size_t limit)
+    : limit_(limit > 0 ? limit : 1),
+      in_use_(0),
+      high_mark_(std::numeric_limits<size_t>::max()),
+      low_mark_(0),
+      wake_pending_(false),
+      next_id_(1),
+      event_fd_(-1),
+      wake_writers_(0),
+      psi_fd_(-1),
+      running_(false),
+      usage_events_(0),
+      psi_events_(0) {}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {
+    if (thread_.joinable()) {
+        running_.store(false);
+        uint64_t one = 1;
+        ssize_t ignored = write(event_fd_.load(), &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+    }
+
+    // 先撤下 eventfd，再等已经读到旧值的 wake() 写完，之后关闭不会与写入竞争
+    int event_fd = event_fd_.exchange(-1);
+    while (wake_writers_.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (event_fd >= 0) {
+        close(event_fd);
+    }
+    int psi = psi_fd_.exchange(-1);
+    if (psi >= 0) {
+        close(psi);
+    }
+}
+
+void MemoryPressureMonitor::wake() {
+    // 通知线程处理完之前不重复写 eventfd
+    if (event_fd_.load(std::memory_order_acquire) < 0 || wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    // 先登记再读取 eventfd：析构时要么这里读到 -1，要么析构等到这次写入结束
+    wake_writers_.fetch_add(1);
+    int event_fd = event_fd_.load();
+    if (event_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(event_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    wake_writers_.fetch_sub(1);
+}
+
+bool MemoryPressureMonitor::start_locked() {
+    if (thread_.joinable()) {
+        return true;
+    }
+
+    int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0) {
+        std::cerr << "[ERROR] 无法创建 eventfd: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 分配路径上的 wake() 不加锁读取，必须先发布 eventfd 再启动线程
+    event_fd_.store(event_fd, std::memory_order_release);
+    running_.store(true);
+    thread_ = std::thread(&MemoryPressureMonitor::run, this);
+    return true;
+}
+
+size_t MemoryPressureMonitor::add_callback(double threshold, PressureCallback callback) {
+    if (!(threshold > 0.0 && threshold <= 1.0) || !callback) {
+        return 0;
+    }
+
+    size_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!start_locked()) {
+            return 0;
+        }
+
+        Entry entry;
+        entry.id = next_id_++;
+        entry.threshold = threshold;
+        entry.trigger_bytes = static_cast<size_t>(threshold * static_cast<double>(limit_));
+        double rearm = std::max(0.0, threshold - REARM_HYSTERESIS);
+        entry.rearm_bytes = static_cast<size_t>(rearm * static_cast<double>(limit_));
+        entry.fired = false;
+        entry.callback = std::move(callback);
+        id = entry.id;
+
+        auto pos = std::upper_bound(callbacks_.begin(), callbacks_.end(), threshold,
+                                    [](double value, const Entry& e) { return value < e.threshold; });
+        callbacks_.insert(pos, std::move(entry));
+        recompute_marks_locked();
+    }
+
+    // 注册时已经超过阈值的回调也要触发
+    wake();
+    return id;
+}
+
+bool MemoryPressureMonitor::remove_callback(size_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(callbacks_.begin(), callbacks_.end(), [id](const Entry& e) { return e.id == id; });
+    if (it == callbacks_.end()) {
+        return false;
+    }
+    callbacks_.erase(it);
+    recompute_marks_locked();
+    return true;
+}
+
+bool MemoryPressureMonitor::enable_psi(size_t stall_us, size_t window_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (psi_fd_.load() >= 0) {
+        return true;
+    }
+
+    int fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[WARNING] 内核不支持 PSI 或无权访问 /proc/pressure/memory: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 触发器格式 "some <停顿微秒> <窗口微秒>"，需要带结尾的 '\0'；非特权进程的窗口必须是 2 秒的整数倍
+    const size_t UNPRIVILEGED_WINDOW = 2000000;
+    size_t windows[] = {window_us, (window_us + UNPRIVILEGED_WINDOW - 1) / UNPRIVILEGED_WINDOW * UNPRIVILEGED_WINDOW};
+    bool registered = false;
+    for (size_t window : windows) {
+        char trigger[64];
+        int length = snprintf(trigger, sizeof(trigger), "some %zu %zu", std::min(stall_us, window), window);
+        if (length > 0 && write(fd, trigger, static_cast<size_t>(length) + 1) >= 0) {
+            registered = true;
+            break;
+        }
+    }
+    if (!registered) {
+        std::cerr << "[WARNING] 注册 PSI 触发器失败: " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    if (!start_locked()) {
+        close(fd);
+        return false;
+    }
+
+    psi_fd_.store(fd);
+    // 让通知线程把新的文件描述符加入 poll
+    uint64_t one = 1;
+    ssize_t ignored = write(event_fd_.load(), &one, sizeof(one));
+    (void)ignored;
+    return true;
+}
+
+size_t MemoryPressureMonitor::get_event_count(PressureSource source) const {
+    return source == PressureSource::POOL_USAGE ? usage_events_.load() : psi_events_.load();
+}
+
+void MemoryPressureMonitor::recompute_marks_locked() {
+    size_t high = std::numeric_limits<size_t>::max();
+    size_t low = 0;
+    for (const auto& entry : callbacks_) {
+        if (entry.fired) {
+            low = std::max(low, entry.rearm_bytes);
+        } else {
+            high = std::min(high, entry.trigger_bytes);
+        }
+    }
+    high_mark_.store(high, std::memory_order_relaxed);
+    low_mark_.store(low, std::memory_order_relaxed);
+}
+
+void MemoryPressureMonitor::evaluate(std::vector<std::pair<PressureCallback, MemoryPressureEvent>>& pending) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t used = in_use_.load(std::memory_order_relaxed);
+
+    for (auto& entry : callbacks_) {
+        if (!entry.fired && used >= entry.trigger_bytes) {
+            entry.fired = true;
+            MemoryPressureEvent event{PressureSource::POOL_USAGE, entry.threshold,
+                                      static_cast<double>(used) / limit_, used, limit_};
+            pending.emplace_back(entry.callback, event);
+        } else if (entry.fired && used < entry.rearm_bytes) {
+            entry.fired = false;
+        }
+    }
+    recompute_marks_locked();
+}
+
+void MemoryPressureMonitor::run() {
+    std::vector<std::pair<PressureCallback, MemoryPressureEvent>> pending;
+    // 线程运行期间 eventfd 不会变化
+    const int event_fd = event_fd_.load();
+
+    while (running_.load()) {
+        pollfd fds[2];
+        nfds_t count = 0;
+        fds[count++] = {event_fd, POLLIN, 0};
+        int psi = psi_fd_.load();
+        if (psi >= 0) {
+            fds[count++] = {psi, POLLPRI, 0};
+        }
+
+        int ready = poll(fds, count, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] 内存压力通知线程 poll 失败: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (!running_.load()) {
+            break;
+        }
+
+        pending.clear();
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t value;
+            ssize_t ignored = read(event_fd, &value, sizeof(value));
+            (void)ignored;
+            // 先清除标记再评估，评估期间新的越界会再次唤醒
+            wake_pending_.store(false, std::memory_order_release);
+            evaluate(pending);
+            usage_events_.fetch_add(pending.size(), std::memory_order_relaxed);
+        }
+
+        if (count > 1 && fds[1].revents) {
+            if (fds[1].revents & POLLERR) {
+                // 所在 cgroup 被删除，触发器失效
+                std::cerr << "[WARNING] PSI 触发器失效，停止监听" << std::endl;
+                int fd = psi_fd_.exchange(-1);
+                if (fd >= 0) close(fd);
+            } else if (fds[1].revents & POLLPRI) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                size_t used = in_use_.load(std::memory_order_relaxed);
+                for (const auto& entry : callbacks_) {
+                    MemoryPressureEvent event{PressureSource::SYSTEM_PSI, entry.threshold,
+                                              static_cast<double>(used) / limit_, used, limit_};
+                    pending.emplace_back(entry.callback, event);
+                }
+                psi_events_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // 回调在锁外执行，回调中可以注册/注销回调或者释放内存
+        for (auto& item : pending) {
+            item.first(item.second);
+        }
+    }
+}
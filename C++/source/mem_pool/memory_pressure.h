@@ -0,0 +1,167 @@
+#ifndef MEMORY_PRESSURE_H
+#define MEMORY_PRESSURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// 内存压力通知（Memory Pressure Notification）
+// ============================================================================
+
+/**
+ * @brief 压力事件的来源
+ */
+enum class PressureSource {
+    POOL_USAGE,     // 池的使用量跨过了回调注册的阈值
+    SYSTEM_PSI      // 内核 PSI（/proc/pressure/memory）报告整个系统/cgroup 因内存不足而停顿
+};
+
+/**
+ * @brief 压力事件
+ */
+struct MemoryPressureEvent {
+    PressureSource source;
+    double threshold;       // 回调注册的阈值（占 limit 的比例）
+    double usage_ratio;     // 触发时的使用比例
+    size_t bytes_in_use;    // 触发时的使用量
+    size_t limit;           // 计算比例的基准
+};
+
+using PressureCallback = std::function<void(const MemoryPressureEvent&)>;
+
+/**
+ * @brief 内存压力监视器
+ *
+ * 1. 分配/释放路径只做一次原子加减和一次比较：使用量越过"下一个未触发的阈值"（或回落到
+ *    "已触发阈值的重新布防点"）时写 eventfd 唤醒通知线程，回调不会在分配线程中执行
+ * 2. 通知线程按阈值从低到高调用跨过的回调；使用量回落到阈值减去 5% 以下后重新布防，避免在阈值附近抖动
+ * 3. 可选监听内核 PSI 触发器：注册 "some <stall> <window>" 后 poll POLLPRI，
+ *    系统（或所在 cgroup）因内存不足停顿超过阈值时调用所有回调，来源为 SYSTEM_PSI
+ *
+ * 回调中可以调用 MemoryPoolManager 的任何接口（例如让缓存释放条目），但不应长时间阻塞
+ */
+class MemoryPressureMonitor {
+public:
+    static constexpr double REARM_HYSTERESIS = 0.05;    // 重新布防的回差（占 limit 的比例）
+
+    /**
+     * @brief 构造函数（不启动线程，第一次注册回调或启用 PSI 时才启动）
+     * @param limit 计算使用比例的基准（字节）
+     */
+    explicit MemoryPressureMonitor(size_t limit);
+
+    ~MemoryPressureMonitor();
+
+    MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+    MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+
+    /**
+     * @brief 记录分配（分配路径调用）
+     */
+    void on_allocate(size_t bytes) {
+        size_t used = in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        if (used >= high_mark_.load(std::memory_order_relaxed)) {
+            wake();
+        }
+    }
+
+    /**
+     * @brief 记录释放（释放路径调用）
+     */
+    void on_free(size_t bytes) {
+        size_t used = in_use_.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+        if (used < low_mark_.load(std::memory_order_relaxed)) {
+            wake();
+        }
+    }
+
+    /**
+     * @brief fork 前后锁住/释放 mutex_（见 MemoryPoolManager::lock_for_fork）
+     */
+    void lock_for_fork() { mutex_.lock(); }
+    void unlock_after_fork() { mutex_.unlock(); }
+
+    /**
+     * @brief 注册回调
+     * @param threshold 使用比例阈值（0, 1]，例如 0.7 / 0.85 / 0.95
+     * @param callback 回调，在通知线程中执行
+     * @return 回调编号（用于注销），阈值非法时返回0
+     */
+    size_t add_callback(double threshold, PressureCallback callback);
+
+    /**
+     * @brief 注销回调
+     */
+    bool remove_callback(size_t id);
+
+    /**
+     * @brief 监听内核 PSI 内存压力
+     * @param stall_us 窗口内累计停顿超过该值时触发（微秒）
+     * @param window_us 统计窗口（微秒），非特权进程要求是 2 秒的整数倍，不满足时自动向上取整
+     * @return 是否启用成功（内核不支持 PSI 或没有权限时返回false）
+     */
+    bool enable_psi(size_t stall_us = 150000, size_t window_us = 2000000);
+
+    size_t bytes_in_use() const { return in_use_.load(std::memory_order_relaxed); }
+
+    size_t limit() const { return limit_; }
+
+    /**
+     * @brief 已投递的事件数（按来源）
+     */
+    size_t get_event_count(PressureSource source) const;
+
+private:
+    struct Entry {
+        size_t id;
+        double threshold;
+        size_t trigger_bytes;   // threshold * limit
+        size_t rearm_bytes;     // 回落到这个值以下时重新布防
+        bool fired;
+        PressureCallback callback;
+    };
+
+    void wake();
+    void run();
+
+    /**
+     * @brief 对照当前使用量更新每个回调的状态，返回需要调用的回调
+     */
+    void evaluate(std::vector<std::pair<PressureCallback, MemoryPressureEvent>>& pending);
+
+    /**
+     * @brief 根据各回调的状态重新计算 high_mark_/low_mark_（调用前必须持有 mutex_）
+     */
+    void recompute_marks_locked();
+
+    /**
+     * @brief 启动通知线程（调用前必须持有 mutex_）
+     */
+    bool start_locked();
+
+    const size_t limit_;
+    std::atomic<size_t> in_use_;
+    std::atomic<size_t> high_mark_;     // 最低的未触发阈值，没有时为 SIZE_MAX
+    std::atomic<size_t> low_mark_;      // 最高的重新布防点，没有时为 0
+    std::atomic<bool> wake_pending_;    // 已经写过 eventfd 还没被处理，避免每次分配都写
+
+    std::vector<Entry> callbacks_;      // 按阈值升序
+    size_t next_id_;
+    mutable std::mutex mutex_;          // 保护 callbacks_ 和线程启动
+
+    std::atomic<int> event_fd_;         // 启动通知线程前发布，分配路径上的 wake() 无锁读取
+    std::atomic<size_t> wake_writers_;  // 正在写 eventfd 的 wake() 数量，析构时等它们结束再关闭
+    std::atomic<int> psi_fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    std::atomic<size_t> usage_events_;
+    std::atomic<size_t> psi_events_;
+};
+
+#endif // MEMORY_PRESSURE_H
@@ -0,0 +1,196 @@
+#include "allocation_trace.h"
+#include "memory_pool.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ============================================================================
+// 分配轨迹回放工具
+//
+// 用法：trace_replay <trace-file> [backend ...]
+//   backend 为 malloc、pool，或带参数的 pool 配置，例如：
+//     pool:small=64K,medium=512K,large=2M,count=16,slab=0
+// 每个后端在独立的子进程中回放，峰值 RSS 互不影响
+// ============================================================================
+
+namespace {
+
+/**
+ * @brief 子进程通过管道回传的结果
+ */
+struct ChildReport {
+    double elapsed_ms;
+    size_t failed_allocations;
+    size_t peak_live_bytes;
+    size_t peak_rss_bytes;
+    double fragmentation;
+};
+
+/**
+ * @brief 解析带 K/M/G 后缀的大小
+ */
+bool parse_size(const std::string& text, size_t& value) {
+    char* end = nullptr;
+    unsigned long long number = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+    switch (*end) {
+        case 'K': case 'k': number <<= 10; ++end; break;
+        case 'M': case 'm': number <<= 20; ++end; break;
+        case 'G': case 'g': number <<= 30; ++end; break;
+        default: break;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    value = static_cast<size_t>(number);
+    return true;
+}
+
+/**
+ * @brief 解析 pool:key=value,... 形式的配置
+ */
+bool parse_pool_config(const std::string& spec, MemoryPoolConfig& config) {
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) {
+        return true;
+    }
+
+    std::stringstream options(spec.substr(colon + 1));
+    std::string option;
+    while (std::getline(options, option, ',')) {
+        size_t eq = option.find('=');
+        size_t value = 0;
+        if (eq == std::string::npos || !parse_size(option.substr(eq + 1), value)) {
+            std::cerr << "[ERROR] 无法解析配置项: " << option << std::endl;
+            return false;
+        }
+
+        std::string key = option.substr(0, eq);
+        if (key == "small") config.small_block_size = value;
+        else if (key == "medium") config.medium_block_size = value;
+        else if (key == "large") config.large_block_size = value;
+        else if (key == "count") config.block_count = value;
+        else if (key == "slab") config.enable_slab = value != 0;
+        else if (key == "decay") config.purge_decay_ms = value;
+        else {
+            std::cerr << "[ERROR] 未知的配置项: " << key << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 在子进程中回放一个后端
+ */
+bool run_backend(const AllocationTrace& trace, const std::string& spec, ReplayResult& result) {
+    // 先在父进程中校验参数，后端本身在子进程中创建，不占用父进程的内存
+    MemoryPoolConfig config;
+    bool use_malloc = spec == "malloc";
+    if (!use_malloc) {
+        if (spec.compare(0, 4, "pool") != 0 || (spec.size() > 4 && spec[4] != ':')) {
+            std::cerr << "[ERROR] 未知的后端: " << spec << std::endl;
+            return false;
+        }
+        if (!parse_pool_config(spec, config)) {
+            return false;
+        }
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        std::cerr << "[ERROR] pipe 失败: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 子进程会继承未刷新的输出缓冲区，先刷新避免重复输出
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "[ERROR] fork 失败: " << std::strerror(errno) << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        std::unique_ptr<ReplayBackend> backend;
+        if (use_malloc) {
+            backend = std::make_unique<MallocBackend>();
+        } else {
+            backend = std::make_unique<PoolBackend>(config, spec);
+        }
+        ReplayResult r = replay_trace(trace, *backend);
+        ChildReport report{r.elapsed_ms, r.failed_allocations, r.peak_live_bytes, r.peak_rss_bytes, r.fragmentation};
+        ssize_t written = write(fds[1], &report, sizeof(report));
+        close(fds[1]);
+        backend.reset();
+        std::cout.flush();
+        _exit(written == static_cast<ssize_t>(sizeof(report)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ChildReport report;
+    ssize_t bytes = read(fds[0], &report, sizeof(report));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (bytes != static_cast<ssize_t>(sizeof(report)) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "[ERROR] 后端 " << spec << " 回放失败" << std::endl;
+        return false;
+    }
+
+    result.backend = spec;
+    result.elapsed_ms = report.elapsed_ms;
+    result.failed_allocations = report.failed_allocations;
+    result.peak_live_bytes = report.peak_live_bytes;
+    result.peak_rss_bytes = report.peak_rss_bytes;
+    result.fragmentation = report.fragmentation;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <trace-file> [malloc|pool|pool:key=value,...] ..." << std::endl;
+        std::cerr << "  pool 配置项: small, medium, large, count, slab, decay（大小可带 K/M/G 后缀）" << std::endl;
+        return 1;
+    }
+
+    AllocationTrace trace;
+    if (!load_allocation_trace(argv[1], trace)) {
+        return 1;
+    }
+    if (trace.dropped_frees > 0) {
+        std::cout << "[WARNING] " << trace.dropped_frees << " 个释放事件找不到对应的分配（录制开始前分配的对象），已忽略"
+                  << std::endl;
+    }
+
+    std::vector<std::string> specs;
+    for (int i = 2; i < argc; ++i) {
+        specs.push_back(argv[i]);
+    }
+    if (specs.empty()) {
+        specs = {"malloc", "pool"};
+    }
+
+    std::vector<ReplayResult> results;
+    for (const auto& spec : specs) {
+        ReplayResult result;
+        if (run_backend(trace, spec, result)) {
+            results.push_back(result);
+        }
+    }
+
+    print_replay_results(trace, results);
+    return results.size() == specs.size() ? 0 : 1;
+}
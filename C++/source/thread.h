@@ -5,6 +5,8 @@
 #ifndef SOURCE_THREAD_H
 #define SOURCE_THREAD_H
 
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <iostream>
 #include <queue>
@@ -0,0 +1,587 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef SOURCE_THREAD_POOL_H
+#define SOURCE_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace CodeGuide {
+
+// ============================================================================
+// futex 封装：空闲线程挂起/唤醒
+// ============================================================================
+
+/**
+ * @brief 当 *addr == expected 时挂起当前线程，直到被 futex_wake 唤醒
+ * Linux 下直接使用 futex 系统调用，其他平台退化为 C++20 的 atomic::wait
+ */
+inline void futex_wait(std::atomic<uint32_t> *addr, uint32_t expected) {
+#ifdef __linux__
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    addr->wait(expected);
+#endif
+}
+
+/**
+ * @brief 唤醒最多 count 个挂起在 addr 上的线程
+ */
+inline void futex_wake(std::atomic<uint32_t> *addr, int count) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    if (count == 1) {
+        addr->notify_one();
+    } else {
+        addr->notify_all();
+    }
+#endif
+}
+
+// ============================================================================
+// Chase-Lev 工作窃取双端队列
+// ============================================================================
+
+/**
+ * @brief Chase-Lev 无锁工作窃取队列（参考 Lê 等人 2013 年的 C11 内存模型版本）
+ * 所有者线程在 bottom 端 push/pop（LIFO，缓存局部性好），其他线程在 top 端 steal（FIFO）。
+ * 只存储指针，数组满时由所有者线程扩容，旧数组延迟到析构时释放，避免窃取者读到已释放内存。
+ */
+template<typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(size_t capacity = 256)
+        : top_(0), bottom_(0), array_(new Array(round_up_pow2(capacity))) {}
+
+    ~ChaseLevDeque() {
+        delete array_.load(std::memory_order_relaxed);
+        for (Array *old : retired_) {
+            delete old;
+        }
+    }
+
+    ChaseLevDeque(const ChaseLevDeque &) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+    /**
+     * @brief 所有者线程压入元素
+     */
+    void push(T *item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array *a = array_.load(std::memory_order_relaxed);
+
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, item);
+        // release 保证元素写入先于 bottom 更新对窃取者可见
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 所有者线程弹出元素，队列为空返回 nullptr
+     */
+    T *pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array *a = array_.load(std::memory_order_relaxed);
+        // 先减 bottom 再读 top，必须是全序操作，否则与 steal 竞争最后一个元素时会重复出队
+        bottom_.store(b, std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+            // 队列为空，恢复 bottom
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *item = a->get(b);
+        if (t == b) {
+            // 只剩最后一个元素，和窃取者通过 CAS 竞争 top
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * @brief 其他线程窃取元素，队列为空或竞争失败返回 nullptr
+     */
+    T *steal() {
+        int64_t t = top_.load(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_seq_cst);
+
+        if (t >= b) {
+            return nullptr;
+        }
+
+        Array *a = array_.load(std::memory_order_acquire);
+        T *item = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    /**
+     * @brief 近似元素数量（并发下只作为提示）
+     */
+    size_t size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    // 环形数组，容量为 2 的幂，下标取模用位与
+    struct Array {
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T *>[]> slots;
+
+        explicit Array(size_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<T *>[cap]) {}
+
+        T *get(int64_t i) const { return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T *item) { slots[static_cast<size_t>(i) & mask].store(item, std::memory_order_relaxed); }
+    };
+
+    static size_t round_up_pow2(size_t n) {
+        size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    Array *grow(Array *old, int64_t t, int64_t b) {
+        auto *bigger = new Array(old->capacity * 2);
+        for (int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        retired_.push_back(old);
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // top 和 bottom 分别被窃取者和所有者频繁修改，放在不同缓存行避免伪共享
+    alignas(64) std::atomic<int64_t> top_;
+    alignas(64) std::atomic<int64_t> bottom_;
+    std::atomic<Array *> array_;
+    std::vector<Array *> retired_;  // 扩容后的旧数组，只由所有者线程访问
+};
+
+// ============================================================================
+// 工作窃取线程池
+// ============================================================================
+
+/**
+ * @brief 工作窃取线程池
+ * 1. 每个工作线程有自己的 Chase-Lev 队列，线程内提交的任务压入本地队列
+ * 2. 外部线程提交的任务进入全局注入队列
+ * 3. 空闲线程依次检查：本地队列 -> 全局注入队列 -> 随机窃取其他线程队列
+ * 4. 仍然没有任务时挂起在 futex 上，有新任务时才被唤醒，不会空转
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief 构造函数
+     * @param thread_count 工作线程数量，0 表示使用硬件并发数
+     */
+    explicit ThreadPool(size_t thread_count = 0)
+        : stop_(false), wake_seq_(0), sleepers_(0), inject_size_(0), steal_count_(0) {
+        if (thread_count == 0) {
+            thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        workers_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers_.push_back(std::make_unique<Worker>(i));
+        }
+        // 所有队列创建完后再启动线程，工作线程窃取时会遍历 workers_
+        for (auto &worker : workers_) {
+            worker->thread = std::thread(&ThreadPool::worker_loop, this, worker.get());
+        }
+    }
+
+    ~ThreadPool() {
+        shutdown();
+
+        // 正常情况下停止时队列已经执行空，这里兜底释放残留的任务
+        for (Task *task : inject_queue_) {
+            delete task;
+        }
+        inject_queue_.clear();
+        for (auto &worker : workers_) {
+            while (Task *task = worker->deque.pop()) {
+                delete task;
+            }
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief 提交任务
+     * @return 获取任务返回值（或异常）的 future
+     * @throw std::runtime_error 线程池已经停止（工作线程中提交的任务除外，它们会在退出前执行完）
+     */
+    template<typename F, typename... Args>
+    auto submit(F &&func, Args &&... args)
+        -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+        // 参数按值保存并在执行时移出，只能移动的参数（如 std::unique_ptr）也可以提交
+        // packaged_task 不可拷贝，std::function 要求可拷贝，所以用 shared_ptr 包装
+        auto task = std::make_shared<std::packaged_task<R()>>(
+            [func = std::forward<F>(func), args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> R {
+                return std::apply(std::move(func), std::move(args));
+            });
+        std::future<R> result = task->get_future();
+
+        Task *wrapper = new Task([task]() { (*task)(); });
+        if (!schedule(wrapper)) {
+            delete wrapper;
+            throw std::runtime_error("ThreadPool 已停止，不能再提交任务");
+        }
+        return result;
+    }
+
+    /**
+     * @brief 提交不需要返回值的任务，省去 future 的共享状态分配
+     * @throw std::runtime_error 线程池已经停止
+     */
+    void post(Task func) {
+        Task *task = new Task(std::move(func));
+        if (!schedule(task)) {
+            delete task;
+            throw std::runtime_error("ThreadPool 已停止，不能再提交任务");
+        }
+    }
+
+    /**
+     * @brief 并行执行 body(i)，i 属于 [begin, end)
+     * @param grain 每个子任务处理的元素数量，0 表示按线程数自动切分
+     *
+     * 调用线程先参与执行任务，找不到可执行的任务时说明剩余子任务都已在其他线程上运行，
+     * 这时阻塞等待最后一个子任务唤醒，不再空转。可以在工作线程内嵌套调用。
+     * 任意子任务抛出的第一个异常会在所有子任务结束后重新抛出。
+     */
+    template<typename F>
+    void parallel_for(size_t begin, size_t end, F &&body, size_t grain = 0) {
+        if (begin >= end) {
+            return;
+        }
+
+        size_t total = end - begin;
+        if (grain == 0) {
+            // 每个线程分 4 份，给窃取留下平衡负载的余地
+            grain = std::max<size_t>(1, total / (workers_.size() * 4));
+        }
+        size_t chunks = (total + grain - 1) / grain;
+
+        std::atomic<size_t> remaining(chunks);
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t chunk_begin = begin + c * grain;
+            size_t chunk_end = std::min(end, chunk_begin + grain);
+            Task *chunk = new Task([&, chunk_begin, chunk_end]() {
+                try {
+                    for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                        body(i);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                // 在锁内递减：调用线程返回前会拿一次 done_mutex，之后不会再有子任务访问栈上的状态
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    done_cv.notify_all();
+                }
+            });
+            // 线程池已停止时由调用线程自己执行
+            if (!schedule(chunk)) {
+                run_task(chunk);
+            }
+        }
+
+        // 调用线程帮忙执行任务，直到所有子任务完成
+        Worker *self = current_worker();
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            Task *task = find_task(self);
+            if (task) {
+                run_task(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done_cv.wait(lock, [&remaining]() { return remaining.load(std::memory_order_acquire) == 0; });
+        }
+        // 等最后一个子任务释放 done_mutex 后才能让这些局部变量析构
+        std::lock_guard<std::mutex> done_lock(done_mutex);
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief 停止线程池，已提交的任务执行完后工作线程退出
+     */
+    void shutdown() {
+        {
+            // 与 schedule 的注入路径串行：stop_ 置位之前入队的任务一定会被工作线程看到
+            std::lock_guard<std::mutex> lock(inject_mutex_);
+            if (stop_.exchange(true)) {
+                return;
+            }
+        }
+        wake_all();
+        for (auto &worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief 工作线程数量
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief 成功窃取任务的次数，用于观察负载均衡情况
+     */
+    size_t steal_count() const { return steal_count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 当前线程是否是本线程池的工作线程
+     */
+    bool in_worker_thread() const { return current_worker() != nullptr; }
+
+private:
+    struct Worker {
+        size_t index;
+        ChaseLevDeque<Task> deque;
+        std::thread thread;
+
+        explicit Worker(size_t i) : index(i) {}
+    };
+
+    // 当前线程对应的工作线程（非工作线程为 nullptr）
+    struct WorkerBinding {
+        const ThreadPool *pool = nullptr;
+        Worker *worker = nullptr;
+    };
+
+    static WorkerBinding &binding() {
+        thread_local WorkerBinding tls;
+        return tls;
+    }
+
+    Worker *current_worker() const {
+        WorkerBinding &tls = binding();
+        return tls.pool == this ? tls.worker : nullptr;
+    }
+
+    /**
+     * @brief 任务入队，线程池已停止时返回 false，任务仍归调用者所有
+     * 工作线程在退出前会执行完本地队列，所以停止过程中工作线程提交的任务照常入队
+     */
+    bool schedule(Task *task) {
+        Worker *self = current_worker();
+        if (self) {
+            // 工作线程提交的任务压入本地队列，只有所有者线程会 push，无需加锁
+            self->deque.push(task);
+        } else {
+            std::lock_guard<std::mutex> lock(inject_mutex_);
+            if (stop_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            inject_queue_.push_back(task);
+            inject_size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify_one();
+        return true;
+    }
+
+    Task *pop_injected() {
+        // 先无锁检查，避免空闲线程争抢全局锁
+        if (inject_size_.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (inject_queue_.empty()) {
+            return nullptr;
+        }
+        Task *task = inject_queue_.front();
+        inject_queue_.pop_front();
+        inject_size_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    Task *steal_from_others(Worker *self) {
+        size_t count = workers_.size();
+        // xorshift 随机选择起始受害者，避免所有线程同时窃取同一个队列
+        thread_local uint32_t seed = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        size_t start = seed % count;
+
+        for (size_t i = 0; i < count; ++i) {
+            Worker *victim = workers_[(start + i) % count].get();
+            if (victim == self) {
+                continue;
+            }
+            Task *task = victim->deque.steal();
+            if (task) {
+                steal_count_.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    Task *find_task(Worker *self) {
+        Task *task = nullptr;
+        if (self) {
+            task = self->deque.pop();
+        }
+        if (!task) {
+            task = pop_injected();
+        }
+        if (!task) {
+            task = steal_from_others(self);
+        }
+        return task;
+    }
+
+    bool has_work() const {
+        if (inject_size_.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+        for (const auto &worker : workers_) {
+            if (!worker->deque.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void run_task(Task *task) {
+        try {
+            (*task)();
+        } catch (...) {
+            // submit 的异常已经由 packaged_task 保存到 future 中，这里只兜底 post 的任务
+        }
+        delete task;
+    }
+
+    void worker_loop(Worker *self) {
+        binding() = WorkerBinding{this, self};
+
+        while (true) {
+            Task *task = find_task(self);
+            if (task) {
+                run_task(task);
+                continue;
+            }
+            if (stop_.load(std::memory_order_acquire)) {
+                // 看到 stop_ 之后再检查一次：之前的检查可能没有看到停止前刚入队的任务
+                task = find_task(self);
+                if (!task) {
+                    break;
+                }
+                run_task(task);
+                continue;
+            }
+            park();
+        }
+
+        binding() = WorkerBinding{};
+    }
+
+    /**
+     * @brief 空闲线程挂起
+     * 先读取唤醒序号并登记为睡眠者，再复查一次任务：
+     * 提交者先入队再检查睡眠者，两边都用全序操作，保证不会丢失唤醒
+     */
+    void park() {
+        uint32_t seq = wake_seq_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!has_work() && !stop_.load(std::memory_order_acquire)) {
+            // 序号已变化（期间有人唤醒）时 futex_wait 会立即返回
+            futex_wait(&wake_seq_, seq);
+        }
+
+        sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void notify_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // 没有线程睡眠时不进入内核，繁忙时提交任务几乎没有额外开销
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            wake_seq_.fetch_add(1, std::memory_order_release);
+            futex_wake(&wake_seq_, 1);
+        }
+    }
+
+    void wake_all() {
+        wake_seq_.fetch_add(1, std::memory_order_release);
+        futex_wake(&wake_seq_, INT_MAX);
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;   // 工作线程及其本地队列
+
+    std::mutex inject_mutex_;                        // 保护全局注入队列
+    std::deque<Task *> inject_queue_;                // 外部线程提交的任务
+
+    std::atomic<bool> stop_;                         // 停止标志
+    std::atomic<uint32_t> wake_seq_;                 // futex 字，每次唤醒递增
+    std::atomic<uint32_t> sleepers_;                 // 挂起的线程数量
+    std::atomic<size_t> inject_size_;                // 注入队列长度（无锁快速检查）
+    std::atomic<size_t> steal_count_;                // 窃取次数统计
+};
+
+}
+
+#endif //SOURCE_THREAD_POOL_H
@@ -0,0 +1,476 @@
+/**
+ * @file async_logger.cpp
+ * @brief 异步日志的实现
+ *
+ * 实现要点：
+ * 1. 业务线程只写自己的环形缓冲区，注册时才加锁
+ * 2. 后台线程轮流读空各线程的缓冲区，格式化后合并为一次writev
+ * 3. 后台线程独占一个IoUring实例，不与EventLoop争用提交队列
+ * 4. fdatasync按时间间隔批量执行，而不是每条日志一次
+ * 5. 后台线程空闲时睡眠在条件变量上，生产者只在它睡眠时才加锁唤醒，不需要定时轮询
+ */
+
+#include "async_logger.hpp"
+#include "io_uring_wrapper.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+
+namespace asyncio {
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 64 * 1024;        // 每个文本块的大小
+constexpr size_t MAX_IOVECS = 64;               // 单次writev的iovec数量
+constexpr size_t DRAIN_BATCH = 1024;            // 每轮从单个线程缓冲区最多取出的记录数
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO ";
+        case LogLevel::WARN:  return "WARN ";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "?    ";
+}
+
+/**
+ * @brief 解码一个参数并追加到out
+ * @return 解码后的读取位置
+ */
+size_t append_arg(const LogRecord& record, size_t pos, std::string& out) {
+    char buffer[32];
+    auto type = static_cast<detail::LogArgType>(record.payload[pos]);
+    const char* value = record.payload + pos + 1;
+
+    switch (type) {
+        case detail::LogArgType::INT: {
+            int64_t v;
+            std::memcpy(&v, value, sizeof(v));
+            out.append(buffer, std::snprintf(buffer, sizeof(buffer), "%" PRId64, v));
+            return pos + 1 + sizeof(v);
+        }
+        case detail::LogArgType::UINT: {
+            uint64_t v;
+            std::memcpy(&v, value, sizeof(v));
+            out.append(buffer, std::snprintf(buffer, sizeof(buffer), "%" PRIu64, v));
+            return pos + 1 + sizeof(v);
+        }
+        case detail::LogArgType::DOUBLE: {
+            double v;
+            std::memcpy(&v, value, sizeof(v));
+            out.append(buffer, std::snprintf(buffer, sizeof(buffer), "%g", v));
+            return pos + 1 + sizeof(v);
+        }
+        case detail::LogArgType::BOOL:
+            out.append(value[0] ? "true" : "false");
+            return pos + 2;
+        case detail::LogArgType::CHAR:
+            out.push_back(value[0]);
+            return pos + 2;
+        case detail::LogArgType::STRING: {
+            uint16_t n;
+            std::memcpy(&n, value, sizeof(n));
+            out.append(value + sizeof(n), n);
+            return pos + 1 + sizeof(n) + n;
+        }
+        case detail::LogArgType::POINTER: {
+            uintptr_t v;
+            std::memcpy(&v, value, sizeof(v));
+            out.append(buffer, std::snprintf(buffer, sizeof(buffer), "0x%" PRIxPTR, v));
+            return pos + 1 + sizeof(v);
+        }
+    }
+    return record.payload_size;
+}
+
+} // namespace
+
+namespace detail {
+
+LogRing::LogRing(size_t capacity, uint32_t thread_id)
+    : thread_id_(thread_id)
+{
+    size_t cap = 2;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+    capacity_ = cap;
+    mask_ = cap - 1;
+    records_.reset(new LogRecord[cap]);
+}
+
+void format_record(const LogRecord& record, std::string& out) {
+    // 时间戳：本地时间 + 微秒
+    time_t seconds = static_cast<time_t>(record.timestamp_ns / 1000000000);
+    unsigned micros = static_cast<unsigned>((record.timestamp_ns % 1000000000) / 1000);
+    struct tm tm_time;
+    localtime_r(&seconds, &tm_time);
+
+    char prefix[64];
+    int n = std::snprintf(prefix, sizeof(prefix), "%04d-%02d-%02d %02d:%02d:%02d.%06u %s [T%u] ",
+                          tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                          tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec, micros,
+                          level_name(record.level), record.thread_id);
+    out.append(prefix, n > 0 ? static_cast<size_t>(n) : 0);
+
+    // 按"{}"占位符依次替换参数
+    size_t pos = 0;
+    uint8_t used = 0;
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && used < record.arg_count) {
+            pos = append_arg(record, pos, out);
+            used++;
+            ++p;
+        } else {
+            out.push_back(*p);
+        }
+    }
+    out.push_back('\n');
+}
+
+} // namespace detail
+
+std::atomic<AsyncLogger*> AsyncLogger::global_{nullptr};
+std::atomic<uint64_t> AsyncLogger::next_instance_id_{1};
+
+AsyncLogger::AsyncLogger(AsyncLoggerConfig config)
+    : config_(std::move(config))
+    , instance_id_(next_instance_id_.fetch_add(1))
+    , fd_(-1)
+    , file_offset_(0)
+    , next_thread_id_(1)
+    , dropped_by_retired_(0)
+    , used_chunks_(0)
+    , running_(false)
+    , written_bytes_(0)
+    , sleeping_(false)
+    , wake_pending_(false)
+    , flush_generation_(0)
+    , dirty_(false)
+{
+    fd_ = ::open(config_.path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("打开日志文件失败: " + config_.path + ": " + std::string(strerror(errno)));
+    }
+
+    // 追加写：从文件末尾开始，由后台线程自己维护偏移
+    struct stat st;
+    if (fstat(fd_, &st) == 0) {
+        file_offset_ = static_cast<uint64_t>(st.st_size);
+    }
+
+    try {
+        ring_ = std::make_unique<IoUring>(config_.queue_depth);
+    } catch (...) {
+        ::close(fd_);
+        throw;
+    }
+}
+
+AsyncLogger::~AsyncLogger() {
+    stop();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void AsyncLogger::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    last_sync_ = std::chrono::steady_clock::now();
+    writer_thread_ = std::thread(&AsyncLogger::run, this);
+    global_.store(this, std::memory_order_release);
+}
+
+void AsyncLogger::stop() {
+    // 先取消全局实例，新的日志退化为stderr，再让后台线程写完剩余日志
+    AsyncLogger* expected = this;
+    global_.compare_exchange_strong(expected, nullptr);
+
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_pending_ = true;
+    }
+    wake_cv_.notify_one();
+    flush_cv_.notify_all();
+
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+}
+
+void AsyncLogger::flush() {
+    if (!running_.load()) {
+        return;
+    }
+
+    // 等待两轮完整的 drain + write：第一轮可能在调用前已经开始，第二轮一定覆盖调用前提交的日志
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    uint64_t target = flush_generation_ + 2;
+    wake_pending_ = true;
+    wake_cv_.notify_one();
+    flush_cv_.wait(lock, [this, target] {
+        return flush_generation_ >= target || !running_.load();
+    });
+}
+
+void AsyncLogger::wake_writer() {
+    // 多个生产者同时看到sleeping_时只有一个去加锁通知
+    if (!sleeping_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_pending_ = true;
+    }
+    wake_cv_.notify_one();
+}
+
+bool AsyncLogger::has_pending_records() {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (const auto& ring : rings_) {
+        if (!ring->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncLogger::wait_for_work() {
+    // 先声明要睡眠，再复查缓冲区：与log()中的 publish -> 屏障 -> 读sleeping_ 配对，
+    // 两边至少有一方看到对方的写入，不会出现日志已发布而后台线程仍在睡眠的情况
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (has_pending_records()) {
+        sleeping_.store(false, std::memory_order_relaxed);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    auto woken = [this] { return wake_pending_ || !running_.load(); };
+    if (dirty_) {
+        // 还有没同步的写入，最多睡到下一次fdatasync的时间
+        wake_cv_.wait_until(lock, last_sync_ + config_.sync_interval, woken);
+    } else {
+        wake_cv_.wait(lock, woken);
+    }
+    wake_pending_ = false;
+    sleeping_.store(false, std::memory_order_relaxed);
+}
+
+uint64_t AsyncLogger::dropped_count() const {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    uint64_t total = dropped_by_retired_;
+    for (const auto& ring : rings_) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+detail::LogRing* AsyncLogger::register_thread(ThreadRingCache& cache) {
+    if (cache.ring) {
+        // 线程之前注册过其他实例，旧缓冲区交给旧实例回收
+        cache.ring->abandoned.store(true, std::memory_order_release);
+    }
+
+    auto ring = std::make_shared<detail::LogRing>(config_.ring_capacity, next_thread_id_.fetch_add(1));
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+
+    cache.instance_id = instance_id_;
+    cache.ring = std::move(ring);
+    return cache.ring.get();
+}
+
+void AsyncLogger::run() {
+    while (true) {
+        bool stopping = !running_.load(std::memory_order_acquire);
+
+        size_t drained = drain();
+        if (used_chunks_ > 0) {
+            write_chunks();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (dirty_ && (stopping || now - last_sync_ >= config_.sync_interval)) {
+            sync();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            flush_generation_++;
+        }
+        flush_cv_.notify_all();
+
+        if (stopping && drained == 0) {
+            break;
+        }
+        if (drained == 0) {
+            wait_for_work();
+        }
+    }
+}
+
+size_t AsyncLogger::drain() {
+    {
+        // 复制注册表，回收已退出且读空的线程缓冲区
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end();) {
+            if ((*it)->abandoned.load(std::memory_order_acquire) && (*it)->empty()) {
+                dropped_by_retired_ += (*it)->dropped.load(std::memory_order_relaxed);
+                it = rings_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        snapshot_.assign(rings_.begin(), rings_.end());
+    }
+
+    size_t drained = 0;
+    used_chunks_ = 0;
+
+    for (auto& ring : snapshot_) {
+        for (size_t i = 0; i < DRAIN_BATCH; ++i) {
+            const LogRecord* record = ring->front();
+            if (!record) {
+                break;
+            }
+
+            if (used_chunks_ == 0 || chunks_[used_chunks_ - 1].size() >= CHUNK_SIZE) {
+                if (used_chunks_ == chunks_.size()) {
+                    chunks_.emplace_back();
+                    chunks_.back().reserve(CHUNK_SIZE + 1024);
+                }
+                chunks_[used_chunks_++].clear();
+            }
+
+            detail::format_record(*record, chunks_[used_chunks_ - 1]);
+            ring->pop();
+            drained++;
+        }
+    }
+
+    snapshot_.clear();
+    return drained;
+}
+
+void AsyncLogger::wait_completion(const bool& done) {
+    while (!done) {
+        ring_->wait_and_process(1, -1);
+    }
+}
+
+void AsyncLogger::write_chunks() {
+    std::vector<struct iovec> iovecs;
+    iovecs.reserve(MAX_IOVECS);
+
+    size_t index = 0;
+    size_t skip = 0;    // 第一个块中已经写入的字节数（短写时）
+
+    while (index < used_chunks_) {
+        iovecs.clear();
+        size_t batch_bytes = 0;
+        for (size_t i = index; i < used_chunks_ && iovecs.size() < MAX_IOVECS; ++i) {
+            size_t offset = i == index ? skip : 0;
+            struct iovec iov;
+            iov.iov_base = chunks_[i].data() + offset;
+            iov.iov_len = chunks_[i].size() - offset;
+            iovecs.push_back(iov);
+            batch_bytes += iov.iov_len;
+        }
+
+        bool done = false;
+        int result = 0;
+        try {
+            ring_->submit_writev(fd_, iovecs.data(), static_cast<unsigned int>(iovecs.size()),
+                                 static_cast<off_t>(file_offset_),
+                                 [&done, &result](const IoResult& r) {
+                                     result = r.result;
+                                     done = true;
+                                 });
+            wait_completion(done);
+        } catch (const std::exception& e) {
+            std::cerr << "[AsyncLogger] 提交写请求失败: " << e.what() << std::endl;
+            return;
+        }
+
+        if (result < 0) {
+            if (result == -EINTR || result == -EAGAIN) {
+                continue;
+            }
+            // 写失败时丢弃本批日志，不能再通过日志报告自身的错误
+            std::cerr << "[AsyncLogger] 写日志文件失败: " << strerror(-result) << std::endl;
+            return;
+        }
+
+        size_t written = static_cast<size_t>(result);
+        file_offset_ += written;
+        written_bytes_.fetch_add(written, std::memory_order_relaxed);
+        dirty_ = true;
+
+        if (written == 0 && batch_bytes > 0) {
+            std::cerr << "[AsyncLogger] 写日志文件返回0字节，丢弃剩余日志" << std::endl;
+            return;
+        }
+
+        // 跳过已写完的块，短写时从剩余位置继续
+        while (written > 0 && index < used_chunks_) {
+            size_t remaining = chunks_[index].size() - skip;
+            if (written >= remaining) {
+                written -= remaining;
+                index++;
+                skip = 0;
+            } else {
+                skip += written;
+                written = 0;
+            }
+        }
+    }
+}
+
+void AsyncLogger::sync() {
+    bool done = false;
+    int result = 0;
+    try {
+        ring_->submit_fsync(fd_, true, [&done, &result](const IoResult& r) {
+            result = r.result;
+            done = true;
+        });
+        wait_completion(done);
+    } catch (const std::exception& e) {
+        std::cerr << "[AsyncLogger] 提交fdatasync失败: " << e.what() << std::endl;
+        return;
+    }
+
+    if (result < 0) {
+        std::cerr << "[AsyncLogger] fdatasync失败: " << strerror(-result) << std::endl;
+    }
+    dirty_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+}
+
+void AsyncLogger::write_stderr(const LogRecord& record) {
+    std::string line;
+    detail::format_record(record, line);
+    std::cerr << line << std::flush;
+}
+
+} // namespace asyncio
@@ -0,0 +1,501 @@
+/**
+ * @file async_logger.hpp
+ * @brief 基于io_uring的异步非阻塞日志
+ *
+ * 同步日志（std::cout/std::cerr）在热路径上会持有流的锁、格式化字符串并发起write系统调用，
+ * 磁盘或终端变慢时直接拖慢业务线程。异步日志把这些工作全部移到后台线程：
+ *
+ * ┌──────────────┐   二进制记录    ┌──────────────┐
+ * │  业务线程 1   │──────────────>│ 线程1环形缓冲 │──┐
+ * └──────────────┘   （无锁SPSC）  └──────────────┘  │   ┌──────────────────┐  writev  ┌──────┐
+ * ┌──────────────┐                ┌──────────────┐  ├──>│ 后台线程：格式化  │────────>│ 文件 │
+ * │  业务线程 N   │──────────────>│ 线程N环形缓冲 │──┘   │ 批量写 + fdatasync │ io_uring └──────┘
+ * └──────────────┘                └──────────────┘      └──────────────────┘
+ *
+ * 1. 每个线程有自己的单生产者单消费者环形缓冲区，写日志时不加锁、不分配内存
+ * 2. 日志记录只保存格式串指针和参数的二进制值，格式化延迟到后台线程（lazy formatting）
+ * 3. 后台线程把多条日志合并为一次writev，通过IoUring提交，并定期fdatasync
+ * 4. 缓冲区满时丢弃日志并计数，业务线程永远不会因为磁盘而阻塞
+ *
+ * 使用示例：
+ * @code
+ * AsyncLoggerConfig config;
+ * config.path = "/var/log/app.log";
+ * AsyncLogger logger(config);
+ * logger.start();   // 成为全局日志实例
+ *
+ * ASYNC_LOG_INFO("连接建立 fd={} peer={}", fd, peer_name);
+ *
+ * logger.stop();    // 写完剩余日志后停止
+ * @endcode
+ *
+ * 注意：格式串必须是字符串字面量（或生命周期覆盖整个进程的字符串），后台线程格式化时才读取它。
+ * 没有启动全局日志实例时，ASYNC_LOG_* 退化为同步写stderr。
+ */
+
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace asyncio {
+
+class IoUring;
+
+/**
+ * @brief 日志级别
+ */
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+};
+
+/**
+ * @brief 异步日志配置
+ */
+struct AsyncLoggerConfig {
+    std::string path;                                       // 日志文件路径
+    size_t ring_capacity = 4096;                            // 每个线程环形缓冲区的记录数（向上取整为2的幂）
+    LogLevel min_level = LogLevel::INFO;                    // 低于该级别的日志直接丢弃
+    std::chrono::milliseconds sync_interval{1000};          // fdatasync间隔
+    unsigned int queue_depth = 64;                          // 后台线程io_uring队列深度
+};
+
+/**
+ * @brief 二进制日志记录
+ *
+ * 固定256字节，参数按 [类型][值] 顺序编码在payload中，字符串超长时截断
+ */
+struct LogRecord {
+    static constexpr size_t PAYLOAD_SIZE = 256 - 24;
+
+    uint64_t timestamp_ns;      // 墙上时间（纳秒）
+    const char* format;         // 格式串，"{}"为参数占位符
+    uint32_t thread_id;         // 线程编号（注册顺序）
+    LogLevel level;             // 日志级别
+    uint8_t arg_count;          // 参数数量
+    uint16_t payload_size;      // payload已使用字节数
+    char payload[PAYLOAD_SIZE]; // 参数编码
+};
+
+static_assert(sizeof(LogRecord) == 256, "LogRecord should fill exactly 4 cache lines");
+
+namespace detail {
+
+/**
+ * @brief 参数类型标记
+ */
+enum class LogArgType : uint8_t {
+    INT,
+    UINT,
+    DOUBLE,
+    BOOL,
+    CHAR,
+    STRING,
+    POINTER
+};
+
+/**
+ * @brief 参数编码器，把参数按值写入LogRecord的payload
+ */
+class LogArgWriter {
+public:
+    explicit LogArgWriter(LogRecord& record) : record_(record) {}
+
+    template<typename T>
+    void put_scalar(LogArgType type, T value) {
+        if (record_.payload_size + 1 + sizeof(T) > LogRecord::PAYLOAD_SIZE) {
+            return;
+        }
+        char* out = record_.payload + record_.payload_size;
+        out[0] = static_cast<char>(type);
+        std::memcpy(out + 1, &value, sizeof(T));
+        record_.payload_size += static_cast<uint16_t>(1 + sizeof(T));
+        record_.arg_count++;
+    }
+
+    void put_string(const char* data, size_t length) {
+        size_t room = LogRecord::PAYLOAD_SIZE - record_.payload_size;
+        if (room < 3) {
+            return;
+        }
+        uint16_t n = static_cast<uint16_t>(length < room - 3 ? length : room - 3);
+        char* out = record_.payload + record_.payload_size;
+        out[0] = static_cast<char>(LogArgType::STRING);
+        std::memcpy(out + 1, &n, sizeof(n));
+        std::memcpy(out + 3, data, n);
+        record_.payload_size += static_cast<uint16_t>(3 + n);
+        record_.arg_count++;
+    }
+
+    template<typename T>
+    void put(const T& value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            put_scalar(LogArgType::BOOL, static_cast<uint8_t>(value));
+        } else if constexpr (std::is_same_v<U, char>) {
+            put_scalar(LogArgType::CHAR, value);
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            put_scalar(LogArgType::INT, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<U> || std::is_enum_v<U>) {
+            put_scalar(LogArgType::UINT, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            put_scalar(LogArgType::DOUBLE, static_cast<double>(value));
+        } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+            if (value) {
+                put_string(value, std::strlen(value));
+            } else {
+                put_string("(null)", 6);
+            }
+        } else if constexpr (std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>) {
+            put_string(value.data(), value.size());
+        } else if constexpr (std::is_pointer_v<U>) {
+            put_scalar(LogArgType::POINTER, reinterpret_cast<uintptr_t>(value));
+        } else {
+            static_assert(std::is_arithmetic_v<U>, "unsupported log argument type");
+        }
+    }
+
+private:
+    LogRecord& record_;
+};
+
+/**
+ * @brief 单生产者单消费者环形缓冲区
+ *
+ * 生产者是注册它的业务线程，消费者是后台写线程。
+ * head_/tail_ 单调递增，下标取模用位与；两端各自缓存对方的位置，减少跨核缓存行传递。
+ */
+class LogRing {
+public:
+    explicit LogRing(size_t capacity, uint32_t thread_id);
+
+    /**
+     * @brief 生产者获取一个空闲槽位，缓冲区满返回nullptr
+     */
+    LogRecord* try_claim() {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ >= capacity_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ >= capacity_) {
+                return nullptr;
+            }
+        }
+        return &records_[tail & mask_];
+    }
+
+    /**
+     * @brief 生产者发布已写好的槽位
+     */
+    void publish() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 消费者读取一条记录，缓冲区空返回nullptr
+     */
+    const LogRecord* front() {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return nullptr;
+            }
+        }
+        return &records_[head & mask_];
+    }
+
+    /**
+     * @brief 消费者释放已读取的记录
+     */
+    void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    uint32_t thread_id() const { return thread_id_; }
+
+    std::atomic<bool> abandoned{false};     // 所属线程已退出，读空后可以回收
+    std::atomic<uint64_t> dropped{0};       // 缓冲区满时丢弃的记录数
+
+private:
+    std::unique_ptr<LogRecord[]> records_;
+    size_t capacity_;
+    size_t mask_;
+    uint32_t thread_id_;
+
+    alignas(64) std::atomic<uint64_t> head_{0};   // 消费者位置
+    uint64_t cached_tail_ = 0;                    // 消费者缓存的生产者位置
+    alignas(64) std::atomic<uint64_t> tail_{0};   // 生产者位置
+    uint64_t cached_head_ = 0;                    // 生产者缓存的消费者位置
+};
+
+/**
+ * @brief 把记录格式化为一行文本，追加到out
+ */
+void format_record(const LogRecord& record, std::string& out);
+
+/**
+ * @brief 当前墙上时间（纳秒）
+ */
+inline uint64_t log_timestamp_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace detail
+
+/**
+ * @brief 异步日志
+ */
+class AsyncLogger {
+public:
+    /**
+     * @brief 构造函数，打开（追加）日志文件
+     * @throws std::runtime_error 文件打开失败或io_uring初始化失败
+     */
+    explicit AsyncLogger(AsyncLoggerConfig config);
+
+    /**
+     * @brief 析构函数，停止后台线程并写完剩余日志
+     *
+     * 注意：析构前应保证没有线程再向这个实例写日志
+     */
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    /**
+     * @brief 启动后台写线程，并设置为全局日志实例
+     */
+    void start();
+
+    /**
+     * @brief 取消全局日志实例，写完所有已提交的日志后停止后台线程
+     */
+    void stop();
+
+    /**
+     * @brief 阻塞直到调用前提交的日志全部写入文件（用于测试和退出前）
+     */
+    void flush();
+
+    /**
+     * @brief 写一条日志，只做参数编码和一次原子发布
+     * @return 缓冲区满或级别被过滤时返回false
+     */
+    template<typename... Args>
+    bool log(LogLevel level, const char* format, const Args&... args) {
+        if (level < config_.min_level) {
+            return false;
+        }
+
+        detail::LogRing* ring = local_ring();
+        if (!ring) {
+            return false;
+        }
+
+        LogRecord* record = ring->try_claim();
+        if (!record) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        record->timestamp_ns = detail::log_timestamp_ns();
+        record->format = format;
+        record->thread_id = ring->thread_id();
+        record->level = level;
+        record->arg_count = 0;
+        record->payload_size = 0;
+
+        detail::LogArgWriter writer(*record);
+        (writer.put(args), ...);
+
+        ring->publish();
+
+        // 后台线程准备睡眠时唤醒它：发布和读取sleeping_之间需要全序屏障，与run()中先声明睡眠再复查缓冲区配对。
+        // 后台线程忙碌时只有一次屏障和一次读，不进入内核
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            wake_writer();
+        }
+        return true;
+    }
+
+    /**
+     * @brief 写入全局日志实例；没有全局实例时同步格式化后写stderr
+     */
+    template<typename... Args>
+    static void write(LogLevel level, const char* format, const Args&... args) {
+        AsyncLogger* logger = global_.load(std::memory_order_acquire);
+        if (logger) {
+            logger->log(level, format, args...);
+            return;
+        }
+
+        LogRecord record;
+        record.timestamp_ns = detail::log_timestamp_ns();
+        record.format = format;
+        record.thread_id = 0;
+        record.level = level;
+        record.arg_count = 0;
+        record.payload_size = 0;
+        detail::LogArgWriter writer(record);
+        (writer.put(args), ...);
+        write_stderr(record);
+    }
+
+    /**
+     * @brief 当前全局日志实例
+     */
+    static AsyncLogger* global() { return global_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 因缓冲区满而丢弃的日志条数
+     */
+    uint64_t dropped_count() const;
+
+    /**
+     * @brief 已写入文件的字节数
+     */
+    uint64_t written_bytes() const { return written_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief 获取当前线程的环形缓冲区，第一次调用时注册
+     */
+    detail::LogRing* local_ring() {
+        ThreadRingCache& cache = thread_cache();
+        if (cache.instance_id != instance_id_) {
+            return register_thread(cache);
+        }
+        return cache.ring.get();
+    }
+
+    /**
+     * @brief 线程本地缓存的缓冲区，线程退出时标记为废弃，由后台线程读空后回收
+     */
+    struct ThreadRingCache {
+        uint64_t instance_id = 0;
+        std::shared_ptr<detail::LogRing> ring;
+
+        ~ThreadRingCache() {
+            if (ring) {
+                ring->abandoned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    static ThreadRingCache& thread_cache() {
+        thread_local ThreadRingCache cache;
+        return cache;
+    }
+
+    /**
+     * @brief 为当前线程创建缓冲区并加入注册表（每个线程只执行一次）
+     */
+    detail::LogRing* register_thread(ThreadRingCache& cache);
+
+    /**
+     * @brief 后台线程主函数
+     */
+    void run();
+
+    /**
+     * @brief 从所有线程的缓冲区取出记录并格式化到chunks_
+     * @return 取出的记录数
+     */
+    size_t drain();
+
+    /**
+     * @brief 把chunks_中的文本通过一次（或多次，短写时）writev写入文件
+     */
+    void write_chunks();
+
+    /**
+     * @brief 提交fdatasync并等待完成
+     */
+    void sync();
+
+    /**
+     * @brief 处理io_uring完成事件，直到done被回调置为true
+     */
+    void wait_completion(const bool& done);
+
+    /**
+     * @brief 唤醒睡眠中的后台线程（只有第一个看到sleeping_的生产者真正加锁通知）
+     */
+    void wake_writer();
+
+    /**
+     * @brief 后台线程空闲时睡眠，直到有新日志、flush()/stop()或者到了fdatasync时间
+     */
+    void wait_for_work();
+
+    /**
+     * @brief 是否有线程缓冲区非空
+     */
+    bool has_pending_records();
+
+    static void write_stderr(const LogRecord& record);
+
+    static std::atomic<AsyncLogger*> global_;
+    static std::atomic<uint64_t> next_instance_id_;
+
+    AsyncLoggerConfig config_;
+    uint64_t instance_id_;                   // 区分不同实例，避免线程缓存命中同地址的旧实例
+    int fd_;
+    uint64_t file_offset_;
+    std::unique_ptr<IoUring> ring_;
+
+    mutable std::mutex rings_mutex_;                          // 保护rings_
+    std::vector<std::shared_ptr<detail::LogRing>> rings_;     // 所有线程的缓冲区
+    std::atomic<uint32_t> next_thread_id_;
+    uint64_t dropped_by_retired_;                             // 已回收缓冲区累计的丢弃数
+
+    std::vector<std::shared_ptr<detail::LogRing>> snapshot_;  // 后台线程遍历用的注册表副本
+    std::vector<std::string> chunks_;        // 格式化好的文本块（复用容量）
+    size_t used_chunks_;                     // 本批使用的文本块数量
+    std::thread writer_thread_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> written_bytes_;
+    std::atomic<bool> sleeping_;             // 后台线程是否准备睡眠，生产者据此决定是否唤醒
+
+    // 睡眠/唤醒
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;        // 唤醒后台线程
+    std::condition_variable flush_cv_;       // 每完成一轮drain+write通知flush()
+    bool wake_pending_;                      // 有未处理的唤醒（受wake_mutex_保护）
+    uint64_t flush_generation_;              // 每完成一轮drain+write递增，flush()据此等待（受wake_mutex_保护）
+    std::chrono::steady_clock::time_point last_sync_;
+    bool dirty_;                             // 上次fdatasync后是否有新写入
+};
+
+} // namespace asyncio
+
+/**
+ * @brief 日志宏，格式串使用"{}"作为占位符
+ */
+#define ASYNC_LOG_DEBUG(format, ...) ::asyncio::AsyncLogger::write(::asyncio::LogLevel::DEBUG, format, ##__VA_ARGS__)
+#define ASYNC_LOG_INFO(format, ...)  ::asyncio::AsyncLogger::write(::asyncio::LogLevel::INFO, format, ##__VA_ARGS__)
+#define ASYNC_LOG_WARN(format, ...)  ::asyncio::AsyncLogger::write(::asyncio::LogLevel::WARN, format, ##__VA_ARGS__)
+#define ASYNC_LOG_ERROR(format, ...) ::asyncio::AsyncLogger::write(::asyncio::LogLevel::ERROR, format, ##__VA_ARGS__)
+
+#endif // ASYNC_LOGGER_HPP
@@ -10,6 +10,7 @@
  */
 
 #include "io_uring_wrapper.hpp"
+#include "async_logger.hpp"
 #include <iostream>
 #include <cerrno>
 #include <cstring>
@@ -23,6 +24,7 @@ namespace asyncio {
 
 IoUring::IoUring(unsigned int queue_depth, unsigned int flags)
     : queue_depth_(queue_depth)
+    , setup_flags_(flags)
     , initialized_(false)
     , next_request_id_(1)
     , pending_requests_(0)
@@ -115,6 +117,7 @@ IoUring::~IoUring() {
 
 IoUring::IoUring(IoUring&& other) noexcept
     : queue_depth_(other.queue_depth_)
+    , setup_flags_(other.setup_flags_)
     , initialized_(other.initialized_)
     , next_request_id_(other.next_request_id_.load())
     , pending_requests_(other.pending_requests_.load())
@@ -139,6 +142,7 @@ IoUring& IoUring::operator=(IoUring&& other) noexcept {
 
         // 移动其他成员
         queue_depth_ = other.queue_depth_;
+        setup_flags_ = other.setup_flags_;
         initialized_ = other.initialized_;
         next_request_id_.store(other.next_request_id_.load());
         pending_requests_.store(other.pending_requests_.load());
@@ -193,6 +197,37 @@ struct io_uring_sqe* IoUring::prepare_sqe(IoContext& ctx) {
 }
 
 uint64_t IoUring::submit_request(IoContext& ctx) {
+    uint64_t request_id = queue_request(ctx, 0);
+    submit_queued(&request_id, 1);
+    return request_id;
+}
+
+std::vector<uint64_t> IoUring::submit_linked(std::vector<IoContext>& chain) {
+    if (chain.size() > queue_depth_) {
+        throw std::runtime_error("链接请求数量超过队列深度: " + std::to_string(chain.size()));
+    }
+
+    std::vector<uint64_t> ids;
+    ids.reserve(chain.size());
+    try {
+        for (size_t i = 0; i < chain.size(); ++i) {
+            // 最后一个请求不带链接标志，链在这里结束
+            unsigned int flags = i + 1 < chain.size() ? IOSQE_IO_LINK : 0;
+            ids.push_back(queue_request(chain[i], flags));
+        }
+    } catch (...) {
+        // 已经填充的SQE无法撤回，照常提交，它们的回调仍然会被调用
+        if (!ids.empty()) {
+            submit_queued(ids.data(), ids.size());
+        }
+        throw;
+    }
+
+    submit_queued(ids.data(), ids.size());
+    return ids;
+}
+
+uint64_t IoUring::queue_request(IoContext& ctx, unsigned int sqe_flags) {
     if (!initialized_) {
         throw std::runtime_error("io_uring未初始化");
     }
@@ -204,6 +239,9 @@ uint64_t IoUring::submit_request(IoContext& ctx) {
     // 获取SQE
     struct io_uring_sqe* sqe = prepare_sqe(ctx);
 
+    // 先创建上下文副本，SQE中引用的参数（如超时时间）必须指向这份在请求完成前一直有效的副本
+    auto ctx_ptr = std::make_unique<IoContext>(ctx);
+
     /**
      * 根据操作类型填充SQE
      *
@@ -248,6 +286,17 @@ uint64_t IoUring::submit_request(IoContext& ctx) {
             io_uring_prep_write(sqe, ctx.fd, ctx.buffer, ctx.length, ctx.offset);
             break;
 
+        case IoOpType::WRITEV:
+            /**
+             * io_uring_prep_writev(sqe, fd, iovecs, nr_vecs, offset)
+             *
+             * 准备一个向量写操作，buffer指向iovec数组，length为iovec数量
+             * 底层使用pwritev2系统调用
+             */
+            io_uring_prep_writev(sqe, ctx.fd, static_cast<const struct iovec*>(ctx.buffer),
+                                 static_cast<unsigned int>(ctx.length), ctx.offset);
+            break;
+
         case IoOpType::FSYNC:
             /**
              * io_uring_prep_fsync(sqe, fd, flags)
@@ -283,13 +332,24 @@ uint64_t IoUring::submit_request(IoContext& ctx) {
             io_uring_prep_nop(sqe);
             break;
 
+        case IoOpType::TIMEOUT:
+            /**
+             * io_uring_prep_timeout(sqe, ts, count, flags)
+             *
+             * 准备一个超时操作：
+             * - ts: 超时时间，内核在请求完成前会读取它，所以指向上下文副本
+             * - count: 0表示纯定时器，不等待其他请求完成
+             * - flags: 0表示相对时间
+             *
+             * 到期时CQE的res为-ETIME
+             */
+            io_uring_prep_timeout(sqe, &ctx_ptr->timeout_spec, 0, 0);
+            break;
+
         default:
             throw std::runtime_error("不支持的IO操作类型: " + std::to_string(static_cast<int>(ctx.op_type)));
     }
 
-    // 创建上下文副本并存储
-    auto ctx_ptr = std::make_unique<IoContext>(ctx);
-
     /**
      * 设置用户数据
      *
@@ -302,6 +362,9 @@ uint64_t IoUring::submit_request(IoContext& ctx) {
      * 在64位系统上这是安全的，因为指针和uint64_t大小相同
      */
     io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(request_id));
+    if (sqe_flags != 0) {
+        io_uring_sqe_set_flags(sqe, sqe_flags);
+    }
 
     // 存储上下文
     {
@@ -309,6 +372,11 @@ uint64_t IoUring::submit_request(IoContext& ctx) {
         contexts_[request_id] = std::move(ctx_ptr);
     }
 
+    return request_id;
+}
+
+void IoUring::submit_queued(const uint64_t* ids, size_t count) {
+
     /**
      * 提交请求到内核
      *
@@ -325,14 +393,14 @@ uint64_t IoUring::submit_request(IoContext& ctx) {
     if (submitted < 0) {
         // 提交失败，清理上下文
         std::lock_guard<std::mutex> lock(contexts_mutex_);
-        contexts_.erase(request_id);
+        for (size_t i = 0; i < count; ++i) {
+            contexts_.erase(ids[i]);
+        }
         throw std::runtime_error("io_uring_submit失败: " + std::string(strerror(-submitted)));
     }
 
     // 增加pending计数
-    pending_requests_.fetch_add(1);
-
-    return request_id;
+    pending_requests_.fetch_add(count);
 }
 
 uint64_t IoUring::submit_read(int fd, void* buffer, size_t length, off_t offset,
@@ -359,6 +427,18 @@ uint64_t IoUring::submit_write(int fd, const void* buffer, size_t length, off_t
     return submit_request(ctx);
 }
 
+uint64_t IoUring::submit_writev(int fd, const struct iovec* iov, unsigned int iovcnt, off_t offset,
+                                 std::function<void(const IoResult&)> callback) {
+    IoContext ctx;
+    ctx.op_type = IoOpType::WRITEV;
+    ctx.fd = fd;
+    ctx.buffer = const_cast<struct iovec*>(iov);
+    ctx.length = iovcnt;
+    ctx.offset = offset;
+    ctx.callback = std::move(callback);
+    return submit_request(ctx);
+}
+
 uint64_t IoUring::submit_fsync(int fd, bool datasync,
                                 std::function<void(const IoResult&)> callback) {
     IoContext ctx;
@@ -368,6 +448,16 @@ uint64_t IoUring::submit_fsync(int fd, bool datasync,
     return submit_request(ctx);
 }
 
+uint64_t IoUring::submit_timeout(std::chrono::nanoseconds timeout,
+                                  std::function<void(const IoResult&)> callback) {
+    IoContext ctx;
+    ctx.op_type = IoOpType::TIMEOUT;
+    ctx.timeout_spec.tv_sec = timeout.count() / 1000000000;
+    ctx.timeout_spec.tv_nsec = timeout.count() % 1000000000;
+    ctx.callback = std::move(callback);
+    return submit_request(ctx);
+}
+
 void IoUring::handle_cqe(struct io_uring_cqe* cqe) {
     /**
      * 处理完成队列项(CQE)
@@ -382,6 +472,11 @@ void IoUring::handle_cqe(struct io_uring_cqe* cqe) {
     // 使用io_uring_cqe_get_data获取void*，然后转换为uint64_t
     uint64_t request_id = reinterpret_cast<uint64_t>(io_uring_cqe_get_data(cqe));
 
+    // 请求ID从1开始分配，0是取消请求自身的CQE，没有对应的上下文，也不计入pending
+    if (request_id == 0) {
+        return;
+    }
+
     // 构造结果结构体
     IoResult result;
     result.result = cqe->res;
@@ -417,9 +512,9 @@ void IoUring::handle_cqe(struct io_uring_cqe* cqe) {
             try {
                 ctx->callback(result);
             } catch (const std::exception& e) {
-                std::cerr << "[io_uring] 回调异常: " << e.what() << std::endl;
+                ASYNC_LOG_ERROR("[io_uring] 回调异常: {}", e.what());
             } catch (...) {
-                std::cerr << "[io_uring] 回调发生未知异常" << std::endl;
+                ASYNC_LOG_ERROR("[io_uring] 回调发生未知异常");
             }
         }
 
@@ -596,6 +691,10 @@ bool IoUring::cancel_request(uint64_t request_id) {
      */
     io_uring_prep_cancel(sqe, reinterpret_cast<void*>(request_id), 0);
 
+    // prep函数不会清空user_data，SQE复用时会残留上一个请求的ID，
+    // 导致取消请求的CQE被当成那个请求的完成事件，所以显式设置为0
+    io_uring_sqe_set_data(sqe, nullptr);
+
     int ret = io_uring_submit(&ring_);
     return ret > 0;
 }
@@ -631,10 +730,30 @@ uint32_t IoUring::get_features() const {
 // EventLoop 类实现
 // ============================================================================
 
-EventLoop::EventLoop(IoUring& ring)
+EventLoop::EventLoop(IoUring& ring, const EventLoopOptions& options)
     : ring_(ring)
+    , options_(options)
     , running_(false)
+    , has_tasks_(false)
+    , sleeping_(false)
+    , stat_iterations_(0)
+    , stat_spin_polls_(0)
+    , stat_spin_hits_(0)
+    , stat_spin_misses_(0)
+    , stat_blocking_waits_(0)
+    , stat_completions_(0)
+    , stat_tasks_(0)
+    , stat_wakeups_(0)
+    , epoch_(Clock::now())
+    , armed_tick_(UINT64_MAX)
+    , armed_request_id_(0)
+    , timeouts_in_flight_(0)
+    , next_timer_tick_(UINT64_MAX)
 {
+    // 自旋会占满事件循环线程所在的核心，只有一个CPU时会和投递任务、提交IO的线程抢同一个核心，延迟反而变差
+    if ((options_.spin_budget.count() > 0 || polling_only()) && std::thread::hardware_concurrency() <= 1) {
+        ASYNC_LOG_WARN("[EventLoop] 只有一个CPU，自旋等待会与其他线程争用CPU，建议使用默认的阻塞模式");
+    }
 }
 
 EventLoop::~EventLoop() {
@@ -642,6 +761,50 @@ EventLoop::~EventLoop() {
     if (loop_thread_.joinable()) {
         loop_thread_.join();
     }
+
+    /**
+     * 回收挂在ring上的超时请求
+     *
+     * 超时请求的回调引用this，而IoUring比事件循环活得久：不回收的话，
+     * 之后处理这个ring的完成事件时会调用到已经析构的事件循环。
+     * 取消最新挂的那个（之前被替换的在替换时已经取消），然后处理完成事件直到所有超时回调都执行过。
+     * 取消失败（如SQ已满）时超时仍会在到期后完成，只是等待更久。
+     */
+    if (!ring_.is_valid()) {
+        return;
+    }
+    uint64_t armed = 0;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (armed_tick_ != UINT64_MAX) {
+            armed = armed_request_id_;
+        }
+    }
+    if (armed != 0) {
+        ring_.cancel_request(armed);
+    }
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex_);
+            if (timeouts_in_flight_ == 0) {
+                break;
+            }
+        }
+        try {
+            // 带超时等待：同一个ring上的其他线程也可能取走这些完成事件
+            ring_.wait_and_process(1, 10);
+        } catch (const std::exception& e) {
+            ASYNC_LOG_ERROR("[EventLoop] 析构时回收超时请求失败: {}", e.what());
+            break;
+        }
+    }
+
+    // 取消请求自身的CQE（user_data为0）可能晚于超时的CQE到达，顺便回收
+    try {
+        ring_.process_completions(0);
+    } catch (...) {
+    }
 }
 
 void EventLoop::start() {
@@ -674,15 +837,7 @@ void EventLoop::stop() {
      * 方案2：使用eventfd进行通知
      * 方案3：使用带超时的等待
      */
-    if (ring_.is_valid()) {
-        IoContext ctx;
-        ctx.op_type = IoOpType::NOP;
-        try {
-            ring_.submit_request(ctx);
-        } catch (...) {
-            // 忽略错误，可能ring已经被关闭
-        }
-    }
+    wakeup();
 }
 
 void EventLoop::join() {
@@ -695,17 +850,36 @@ void EventLoop::post(std::function<void()> func) {
     {
         std::lock_guard<std::mutex> lock(task_mutex_);
         task_queue_.push(std::move(func));
+        has_tasks_.store(true);
     }
 
-    // 唤醒事件循环（如果它在等待）
-    // 这里使用NOP操作来唤醒
+    /**
+     * 只在事件循环准备阻塞时唤醒
+     *
+     * 与block_wait()配对：这里先设置has_tasks_再读sleeping_，block_wait()先设置sleeping_再读has_tasks_，
+     * 两边都是seq_cst，至少有一方能看到对方的写入，不会出现任务已入队而事件循环仍然阻塞的情况。
+     * 事件循环正在处理或自旋时不提交NOP，省掉一次系统调用和一个多余的CQE
+     */
+    if (sleeping_.load()) {
+        wakeup();
+    }
+}
+
+void EventLoop::wakeup() {
+    // IOPOLL实例不支持NOP；从不阻塞的事件循环也不需要唤醒
+    if (polling_only()) {
+        return;
+    }
+
+    // 使用NOP操作来唤醒
     if (ring_.is_valid()) {
+        stat_wakeups_.fetch_add(1, std::memory_order_relaxed);
         IoContext ctx;
         ctx.op_type = IoOpType::NOP;
         try {
             ring_.submit_request(ctx);
         } catch (...) {
-            // 忽略错误
+            // 忽略错误，可能ring已经被关闭
         }
     }
 }
@@ -718,23 +892,37 @@ void EventLoop::run() {
      *
      * 循环中的操作：
      * 1. 处理任务队列中的任务
-     * 2. 等待并处理IO完成事件
-     * 3. 检查是否应该停止
+     * 2. 执行到期的定时器，并为下一个到期时间挂超时请求
+     * 3. 等待并处理IO完成事件
+     * 4. 检查是否应该停止
      */
     while (running_.load()) {
+        stat_iterations_.fetch_add(1, std::memory_order_relaxed);
+
         // 处理任务队列
         process_tasks();
 
+        // 处理定时器
+        process_timers();
+
         try {
+            // 低延迟模式：先自旋，等到工作就直接进入下一轮，不经过内核唤醒
+            if (options_.spin_budget.count() > 0 || polling_only()) {
+                if (spin_wait() || polling_only()) {
+                    continue;
+                }
+            }
+
             /**
              * 等待IO完成事件
              *
-             * 使用带超时的等待，这样即使没有IO事件，
-             * 也能定期检查running_标志和任务队列
+             * 无限等待，不再周期性唤醒：
+             * - 定时器到期由arm_timer()挂的超时请求产生CQE唤醒
+             * - post()/stop()/其他线程添加更早的定时器时提交NOP唤醒
              */
-            ring_.wait_and_process(1, 100);  // 100ms超时
+            block_wait();
         } catch (const std::exception& e) {
-            std::cerr << "[EventLoop] 处理完成事件时发生异常: " << e.what() << std::endl;
+            ASYNC_LOG_ERROR("[EventLoop] 处理完成事件时发生异常: {}", e.what());
         }
     }
 
@@ -761,19 +949,238 @@ void EventLoop::process_tasks() {
     {
         std::lock_guard<std::mutex> lock(task_mutex_);
         tasks.swap(task_queue_);
+        has_tasks_.store(false);
     }
+    stat_tasks_.fetch_add(tasks.size(), std::memory_order_relaxed);
 
     while (!tasks.empty()) {
         auto& task = tasks.front();
         try {
             task();
         } catch (const std::exception& e) {
-            std::cerr << "[EventLoop] 任务执行异常: " << e.what() << std::endl;
+            ASYNC_LOG_ERROR("[EventLoop] 任务执行异常: {}", e.what());
         } catch (...) {
-            std::cerr << "[EventLoop] 任务执行发生未知异常" << std::endl;
+            ASYNC_LOG_ERROR("[EventLoop] 任务执行发生未知异常");
         }
         tasks.pop();
     }
 }
 
+uint64_t EventLoop::to_tick(Clock::time_point when) const {
+    if (when <= epoch_) {
+        return 0;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(when - epoch_).count();
+    return static_cast<uint64_t>((elapsed + 999999) / 1000000);
+}
+
+uint64_t EventLoop::now_tick() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - epoch_).count();
+    return static_cast<uint64_t>(elapsed);
+}
+
+EventLoop::TimerId EventLoop::schedule_after(std::chrono::milliseconds delay, std::function<void()> callback) {
+    return schedule_at(Clock::now() + delay, std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::schedule_at(Clock::time_point when, std::function<void()> callback) {
+    return add_timer(to_tick(when), 0, std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::schedule_every(std::chrono::milliseconds interval, std::function<void()> callback) {
+    uint64_t interval_ticks = interval.count() > 0 ? static_cast<uint64_t>(interval.count()) : 1;
+    return add_timer(to_tick(Clock::now()) + interval_ticks, interval_ticks, std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::add_timer(uint64_t expire_tick, uint64_t interval_ticks, std::function<void()> callback) {
+    TimerId id;
+    bool need_wakeup = false;
+
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        id = timer_wheel_.add(expire_tick, interval_ticks, std::move(callback));
+        update_next_timer_locked();
+
+        // 比已挂起的超时更早到期，需要让事件循环重新挂超时
+        uint64_t next;
+        if (timer_wheel_.next_expiry(next) && next < armed_tick_) {
+            need_wakeup = true;
+        }
+    }
+
+    // 在事件循环线程内添加（例如定时器回调中）时，arm_timer()会在下次等待前执行，无需唤醒；
+    // 事件循环没有准备阻塞时，block_wait()会在设置sleeping_之后重新挂超时，也无需唤醒
+    if (need_wakeup && sleeping_.load() && std::this_thread::get_id() != loop_thread_.get_id()) {
+        wakeup();
+    }
+
+    return id;
+}
+
+bool EventLoop::cancel_timer(TimerId id) {
+    // 已挂起的超时请求不取消，最多产生一次多余的唤醒，arm_timer()会按新的最近到期时间处理
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    return timer_wheel_.cancel(id);
+}
+
+size_t EventLoop::timer_count() const {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    return timer_wheel_.size();
+}
+
+void EventLoop::process_timers() {
+    std::vector<std::function<void()>> expired;
+
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        timer_wheel_.advance(now_tick(), expired);
+        update_next_timer_locked();
+    }
+
+    // 在锁外执行回调，回调中可以添加或取消定时器
+    for (auto& callback : expired) {
+        if (!callback) {
+            continue;
+        }
+        try {
+            callback();
+        } catch (const std::exception& e) {
+            ASYNC_LOG_ERROR("[EventLoop] 定时器回调异常: {}", e.what());
+        } catch (...) {
+            ASYNC_LOG_ERROR("[EventLoop] 定时器回调发生未知异常");
+        }
+    }
+}
+
+void EventLoop::arm_timer() {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+
+    uint64_t next;
+    if (!timer_wheel_.next_expiry(next) || next >= armed_tick_) {
+        // 没有定时器，或者已挂的超时不晚于下一个到期时间
+        return;
+    }
+
+    uint64_t now = now_tick();
+    std::chrono::milliseconds delay(next > now ? next - now : 0);
+
+    // 整个事件循环只保留一个超时请求：取消之前挂的更晚的那个
+    if (armed_tick_ != UINT64_MAX) {
+        ring_.cancel_request(armed_request_id_);
+    }
+
+    try {
+        uint64_t request_id = ring_.submit_timeout(delay, [this](const IoResult& result) {
+            // 超时到期或被取消，只有最新挂的那个才清除状态
+            auto* ctx = static_cast<IoContext*>(result.user_data);
+            std::lock_guard<std::mutex> guard(timer_mutex_);
+            timeouts_in_flight_--;
+            if (ctx && ctx->id == armed_request_id_) {
+                armed_tick_ = UINT64_MAX;
+                armed_request_id_ = 0;
+            }
+        });
+        // 回调要先拿到timer_mutex_，不会在计数增加之前执行
+        timeouts_in_flight_++;
+        armed_tick_ = next;
+        armed_request_id_ = request_id;
+    } catch (const std::exception& e) {
+        ASYNC_LOG_ERROR("[EventLoop] 挂定时器超时请求失败: {}", e.what());
+    }
+}
+
+void EventLoop::update_next_timer_locked() {
+    uint64_t next;
+    next_timer_tick_.store(timer_wheel_.next_expiry(next) ? next : UINT64_MAX, std::memory_order_relaxed);
+}
+
+bool EventLoop::polling_only() const {
+    return options_.never_block || (ring_.setup_flags() & IORING_SETUP_IOPOLL);
+}
+
+bool EventLoop::spin_wait() {
+    /**
+     * 自旋等待
+     *
+     * 每轮检查三件事，都不需要加锁：
+     * 1. process_completions()：io_uring_peek_cqe只读共享内存中的CQ尾指针
+     *    （IOPOLL实例上CQ为空时会带GETEVENTS进入内核轮询设备，这正是IOPOLL需要的）
+     * 2. has_tasks_：post()投递的任务
+     * 3. next_timer_tick_：最近的定时器是否到期
+     * 任何一项有工作就返回，回到run()中处理；否则用pause降低自旋对同核超线程的影响
+     */
+    const bool forever = polling_only();
+    const Clock::time_point deadline = Clock::now() + options_.spin_budget;
+    uint64_t polls = 0;
+    bool found = false;
+
+    while (running_.load(std::memory_order_relaxed)) {
+        polls++;
+
+        size_t completed = ring_.process_completions(0);
+        if (completed > 0) {
+            stat_completions_.fetch_add(completed, std::memory_order_relaxed);
+            found = true;
+            break;
+        }
+        if (has_tasks_.load(std::memory_order_acquire)) {
+            found = true;
+            break;
+        }
+
+        Clock::time_point now = Clock::now();
+        uint64_t tick = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - epoch_).count());
+        if (tick >= next_timer_tick_.load(std::memory_order_relaxed)) {
+            found = true;
+            break;
+        }
+        if (!forever && now >= deadline) {
+            break;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    stat_spin_polls_.fetch_add(polls, std::memory_order_relaxed);
+    if (found) {
+        stat_spin_hits_.fetch_add(1, std::memory_order_relaxed);
+    } else if (!forever) {
+        stat_spin_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return found;
+}
+
+void EventLoop::block_wait() {
+    // 先声明要阻塞，再挂定时器超时和检查任务，与post()/add_timer()中的检查配对
+    sleeping_.store(true);
+    try {
+        arm_timer();
+        if (!has_tasks_.load() && running_.load()) {
+            stat_blocking_waits_.fetch_add(1, std::memory_order_relaxed);
+            size_t completed = ring_.wait_and_process(1, -1);
+            stat_completions_.fetch_add(completed, std::memory_order_relaxed);
+        }
+    } catch (...) {
+        sleeping_.store(false);
+        throw;
+    }
+    sleeping_.store(false);
+}
+
+EventLoopStats EventLoop::stats() const {
+    EventLoopStats result;
+    result.iterations = stat_iterations_.load(std::memory_order_relaxed);
+    result.spin_polls = stat_spin_polls_.load(std::memory_order_relaxed);
+    result.spin_hits = stat_spin_hits_.load(std::memory_order_relaxed);
+    result.spin_misses = stat_spin_misses_.load(std::memory_order_relaxed);
+    result.blocking_waits = stat_blocking_waits_.load(std::memory_order_relaxed);
+    result.completions = stat_completions_.load(std::memory_order_relaxed);
+    result.tasks = stat_tasks_.load(std::memory_order_relaxed);
+    result.wakeups = stat_wakeups_.load(std::memory_order_relaxed);
+    return result;
+}
+
 } // namespace asyncio
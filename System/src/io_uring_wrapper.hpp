@@ -34,6 +34,7 @@
 #include <liburing.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -49,6 +50,9 @@
 #include <condition_variable>
 #include <queue>
 #include <unordered_map>
+#include <chrono>
+
+#include "timer_wheel.hpp"
 
 namespace asyncio {
 
@@ -60,6 +64,7 @@ namespace asyncio {
 enum class IoOpType {
     READ,           // 读操作 (preadv2)
     WRITE,          // 写操作 (pwritev2)
+    WRITEV,         // 向量写操作，一次提交多个缓冲区
     FSYNC,          // 文件同步
     FDATASYNC,      // 数据同步（不包含元数据）
     POLL_ADD,       // 添加poll监听
@@ -125,6 +130,7 @@ struct IoContext {
     std::function<void(const IoResult&)> callback;  // 完成回调
     void* coroutine_handle;                      // 协程句柄（用于co_await）
     uint64_t id;                                 // 请求唯一ID
+    struct __kernel_timespec timeout_spec;       // TIMEOUT操作的相对超时时间，需要在请求完成前保持有效
 
     IoContext()
         : op_type(IoOpType::NOP)
@@ -133,7 +139,8 @@ struct IoContext {
         , length(0)
         , offset(0)
         , coroutine_handle(nullptr)
-        , id(0) {}
+        , id(0)
+        , timeout_spec{0, 0} {}
 };
 
 /**
@@ -221,6 +228,19 @@ public:
      */
     uint64_t submit_request(IoContext& ctx);
 
+    /**
+     * @brief 一次提交一组链接的请求
+     * @param chain 按顺序执行的请求，除最后一个外都带IOSQE_IO_LINK标志
+     * @return 各请求的ID，与chain一一对应
+     *
+     * 整组请求只调用一次io_uring_submit。内核保证链上的请求按顺序执行，
+     * 前一个请求失败或短读写时，后面的请求以-ECANCELED完成。
+     * 典型用法是 writev -> fdatasync：写和同步一次提交，中间不需要回到用户态。
+     *
+     * 注意：链的长度不能超过队列深度，否则SQ中途写满会把链拆成两次提交
+     */
+    std::vector<uint64_t> submit_linked(std::vector<IoContext>& chain);
+
     /**
      * @brief 提交读请求（便捷接口）
      * @param fd 文件描述符
@@ -245,6 +265,20 @@ public:
     uint64_t submit_write(int fd, const void* buffer, size_t length, off_t offset,
                           std::function<void(const IoResult&)> callback = nullptr);
 
+    /**
+     * @brief 提交向量写请求（便捷接口）
+     * @param fd 文件描述符
+     * @param iov iovec数组，数组和其中的缓冲区在请求完成前必须保持有效
+     * @param iovcnt iovec数量
+     * @param offset 文件偏移
+     * @param callback 完成回调
+     * @return 请求ID
+     *
+     * 把多个不连续的缓冲区合并为一次写操作，适合日志、WAL等批量写场景
+     */
+    uint64_t submit_writev(int fd, const struct iovec* iov, unsigned int iovcnt, off_t offset,
+                           std::function<void(const IoResult&)> callback = nullptr);
+
     /**
      * @brief 提交fsync请求
      * @param fd 文件描述符
@@ -255,6 +289,17 @@ public:
     uint64_t submit_fsync(int fd, bool datasync = false,
                           std::function<void(const IoResult&)> callback = nullptr);
 
+    /**
+     * @brief 提交超时请求
+     * @param timeout 相对超时时间
+     * @param callback 完成回调，正常到期时result为-ETIME，被取消时为-ECANCELED
+     * @return 请求ID，可以通过cancel_request()取消
+     *
+     * 超时请求不占用线程，到期后内核产生一个CQE，可以用来唤醒阻塞在等待CQE上的事件循环
+     */
+    uint64_t submit_timeout(std::chrono::nanoseconds timeout,
+                            std::function<void(const IoResult&)> callback = nullptr);
+
     /**
      * @brief 处理完成队列中的事件
      * @param max_completions 最多处理的完成事件数量，0表示处理所有
@@ -308,6 +353,14 @@ public:
      */
     unsigned int queue_depth() const { return queue_depth_; }
 
+    /**
+     * @brief 获取初始化时使用的标志（IORING_SETUP_*）
+     *
+     * EventLoop根据IORING_SETUP_IOPOLL决定是否可以阻塞等待：
+     * IOPOLL实例只支持O_DIRECT读写，超时和NOP请求会失败，完成事件只能通过轮询获取
+     */
+    unsigned int setup_flags() const { return setup_flags_; }
+
     /**
      * @brief 获取io_uring特性标志
      * @return 支持的特性标志位
@@ -330,6 +383,7 @@ public:
 private:
     struct io_uring ring_;                      // io_uring实例
     unsigned int queue_depth_;                   // 队列深度
+    unsigned int setup_flags_;                   // 初始化标志
     bool initialized_;                           // 是否已初始化
     std::atomic<uint64_t> next_request_id_;     // 下一个请求ID
     std::atomic<size_t> pending_requests_;      // pending请求计数
@@ -345,6 +399,21 @@ private:
      */
     struct io_uring_sqe* prepare_sqe(IoContext& ctx);
 
+    /**
+     * @brief 填充SQE并登记上下文，但不提交（内部函数）
+     * @param ctx IO上下文
+     * @param sqe_flags SQE标志（如IOSQE_IO_LINK）
+     * @return 请求ID
+     */
+    uint64_t queue_request(IoContext& ctx, unsigned int sqe_flags);
+
+    /**
+     * @brief 提交SQ中已填充的请求（内部函数）
+     * @param ids 本次提交的请求ID，提交失败时清理它们的上下文
+     * @param count 请求数量
+     */
+    void submit_queued(const uint64_t* ids, size_t count);
+
     /**
      * @brief 处理单个CQE（内部函数）
      * @param cqe 完成队列项
@@ -352,6 +421,47 @@ private:
     void handle_cqe(struct io_uring_cqe* cqe);
 };
 
+/**
+ * @brief 事件循环选项
+ *
+ * 默认（spin_budget为0）没有IO、任务和定时器时直接阻塞在io_uring_wait_cqe中，CPU占用最低，
+ * 但每次完成事件都要经过一次系统调用返回和线程唤醒，完成到回调的延迟在几十微秒量级。
+ *
+ * 低延迟模式：阻塞前先在io_uring_peek_cqe和任务队列上自旋spin_budget，期间到达的完成事件和任务
+ * 不经过内核唤醒，延迟可以降到个位数微秒；代价是自旋期间占满一个CPU核心，建议把事件循环线程绑核。
+ *
+ * 可以和IoUring的初始化标志组合使用：
+ * - IORING_SETUP_SQPOLL：内核线程轮询提交队列，提交不需要系统调用
+ * - IORING_SETUP_IOPOLL：NVMe等设备用轮询代替中断完成IO（只支持O_DIRECT读写）。
+ *   IOPOLL实例不能提交超时和NOP请求，事件循环自动进入一直自旋、从不阻塞的模式，定时器改为轮询检查
+ */
+struct EventLoopOptions {
+    std::chrono::microseconds spin_budget{0};   // 阻塞前自旋的时长，0表示不自旋
+    bool never_block = false;                   // 一直自旋，不阻塞（IOPOLL实例强制开启）
+};
+
+/**
+ * @brief 事件循环统计，用于评估自旋的效率
+ */
+struct EventLoopStats {
+    uint64_t iterations = 0;        // 循环次数
+    uint64_t spin_polls = 0;        // 自旋中的轮询次数
+    uint64_t spin_hits = 0;         // 自旋期间等到了工作（没有阻塞）的次数
+    uint64_t spin_misses = 0;       // 自旋预算用完仍然没有工作、转入阻塞的次数
+    uint64_t blocking_waits = 0;    // 阻塞等待次数
+    uint64_t completions = 0;       // 处理的完成事件数
+    uint64_t tasks = 0;             // 执行的任务数
+    uint64_t wakeups = 0;           // 为唤醒事件循环提交的NOP数
+
+    /**
+     * @brief 自旋命中率：自旋结束时有工作可做的比例，过低说明自旋预算大部分被浪费
+     */
+    double spin_efficiency() const {
+        uint64_t spins = spin_hits + spin_misses;
+        return spins ? static_cast<double>(spin_hits) / static_cast<double>(spins) : 0.0;
+    }
+};
+
 /**
  * @brief 事件循环类
  *
@@ -361,6 +471,9 @@ private:
  * 1. 在单独的线程中运行
  * 2. 持续处理IO完成事件
  * 3. 支持优雅停止
+ * 4. 内置分层时间轮定时器，只为最近的到期时间挂一个io_uring超时请求，
+ *    没有IO、任务和定时器时一直阻塞，不会周期性空转唤醒
+ * 5. 可选的低延迟模式：阻塞前先自旋等待一段时间（见EventLoopOptions）
  *
  * 事件循环的工作方式：
  * ┌─────────────────────────────────────────┐
@@ -384,8 +497,9 @@ public:
     /**
      * @brief 构造函数
      * @param ring 关联的IoUring实例
+     * @param options 事件循环选项（是否自旋等待）
      */
-    explicit EventLoop(IoUring& ring);
+    explicit EventLoop(IoUring& ring, const EventLoopOptions& options = EventLoopOptions());
 
     /**
      * @brief 析构函数
@@ -433,14 +547,96 @@ public:
      */
     void post(std::function<void()> func);
 
+    using TimerId = TimerWheel::TimerId;
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 延迟delay后在事件循环线程中执行回调
+     * @return 定时器ID，可用于cancel_timer()
+     *
+     * 定时精度为1ms，回调不会早于到期时间执行。线程安全，可以从任何线程调用。
+     */
+    TimerId schedule_after(std::chrono::milliseconds delay, std::function<void()> callback);
+
+    /**
+     * @brief 在指定时间点执行回调
+     */
+    TimerId schedule_at(Clock::time_point when, std::function<void()> callback);
+
+    /**
+     * @brief 每隔interval执行一次回调，直到被取消
+     */
+    TimerId schedule_every(std::chrono::milliseconds interval, std::function<void()> callback);
+
+    /**
+     * @brief 取消定时器，O(1)
+     * @return 定时器存在且尚未触发时返回true
+     */
+    bool cancel_timer(TimerId id);
+
+    /**
+     * @brief 当前活跃的定时器数量
+     */
+    size_t timer_count() const;
+
+    /**
+     * @brief 获取事件循环统计（线程安全，各计数器分别读取，不是严格的快照）
+     */
+    EventLoopStats stats() const;
+
 private:
     IoUring& ring_;
+    EventLoopOptions options_;
     std::atomic<bool> running_;
     std::thread loop_thread_;
 
     // 任务队列
     std::mutex task_mutex_;
     std::queue<std::function<void()>> task_queue_;
+    std::atomic<bool> has_tasks_;       // 任务队列不空，自旋时不加锁检查
+
+    // 事件循环即将或正在阻塞等待CQE，post()只在这时提交NOP唤醒
+    std::atomic<bool> sleeping_;
+
+    // 统计（relaxed原子计数）
+    std::atomic<uint64_t> stat_iterations_;
+    std::atomic<uint64_t> stat_spin_polls_;
+    std::atomic<uint64_t> stat_spin_hits_;
+    std::atomic<uint64_t> stat_spin_misses_;
+    std::atomic<uint64_t> stat_blocking_waits_;
+    std::atomic<uint64_t> stat_completions_;
+    std::atomic<uint64_t> stat_tasks_;
+    std::atomic<uint64_t> stat_wakeups_;
+
+    // 定时器（1 tick = 1ms，以epoch_为起点）
+    mutable std::mutex timer_mutex_;
+    TimerWheel timer_wheel_;
+    Clock::time_point epoch_;
+    uint64_t armed_tick_;           // 已挂起的io_uring超时对应的tick，UINT64_MAX表示没有
+    uint64_t armed_request_id_;     // 已挂起的io_uring超时请求ID
+    size_t timeouts_in_flight_;     // 还没有完成的超时请求数量（包括已取消、CQE尚未处理的），析构时等待归零
+    std::atomic<uint64_t> next_timer_tick_;     // 最近的到期tick（可能偏早），自旋时不加锁检查，UINT64_MAX表示没有
+
+    /**
+     * @brief 是否从不阻塞（never_block或者IOPOLL实例）
+     */
+    bool polling_only() const;
+
+    /**
+     * @brief 在预算内自旋等待完成事件、任务或到期的定时器
+     * @return 等到了工作返回true，预算用完返回false
+     */
+    bool spin_wait();
+
+    /**
+     * @brief 阻塞等待完成事件
+     */
+    void block_wait();
+
+    /**
+     * @brief 根据时间轮刷新next_timer_tick_（调用前必须持有timer_mutex_）
+     */
+    void update_next_timer_locked();
 
     /**
      * @brief 事件循环主函数
@@ -451,6 +647,36 @@ private:
      * @brief 处理任务队列
      */
     void process_tasks();
+
+    /**
+     * @brief 执行所有已到期的定时器
+     */
+    void process_timers();
+
+    /**
+     * @brief 为最近的到期时间挂一个io_uring超时请求
+     */
+    void arm_timer();
+
+    /**
+     * @brief 添加定时器，必要时唤醒事件循环重新挂超时
+     */
+    TimerId add_timer(uint64_t expire_tick, uint64_t interval_ticks, std::function<void()> callback);
+
+    /**
+     * @brief 把时间点换算为tick，向上取整保证定时器不会提前触发
+     */
+    uint64_t to_tick(Clock::time_point when) const;
+
+    /**
+     * @brief 当前时间对应的tick
+     */
+    uint64_t now_tick() const;
+
+    /**
+     * @brief 提交NOP唤醒阻塞在等待CQE上的事件循环
+     */
+    void wakeup();
 };
 
 } // namespace asyncio
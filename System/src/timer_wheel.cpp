@@ -0,0 +1,276 @@
+/**
+ * @file timer_wheel.cpp
+ * @brief 分层时间轮的实现
+ *
+ * 实现要点：
+ * 1. 每层用位图记录非空槽，查找下一个到期时间只需要扫描几个64位字
+ * 2. 推进时间轮时直接跳到下一个非空槽，空闲时不需要逐tick空转
+ * 3. 节点通过数组下标链接，节点数组扩容不会使链表失效
+ */
+
+#include "timer_wheel.hpp"
+
+namespace asyncio {
+
+TimerWheel::TimerWheel(uint64_t start_tick)
+    : free_head_(NIL)
+    , current_tick_(start_tick)
+    , active_count_(0)
+{
+    for (uint32_t i = 0; i < TOTAL_SLOTS; ++i) {
+        heads_[i] = NIL;
+    }
+    for (auto& word : occupied_) {
+        word = 0;
+    }
+}
+
+uint32_t TimerWheel::alloc_node() {
+    if (free_head_ != NIL) {
+        uint32_t index = free_head_;
+        free_head_ = nodes_[index].next;
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::free_node(uint32_t index) {
+    TimerNode& node = nodes_[index];
+    node.active = false;
+    node.callback = nullptr;
+    // 代数递增，使旧的定时器ID失效
+    node.generation++;
+    node.prev = NIL;
+    node.slot = NIL;
+    node.next = free_head_;
+    free_head_ = index;
+}
+
+void TimerWheel::link(uint32_t index) {
+    TimerNode& node = nodes_[index];
+    // 调用者保证 expire >= current_tick_
+    uint64_t delta = node.expire - current_tick_;
+
+    int level;
+    uint64_t position = node.expire;
+    if (delta < LEVEL0_SLOTS) {
+        level = 0;
+    } else if (delta < (1ull << level_shift(2))) {
+        level = 1;
+    } else if (delta < (1ull << level_shift(3))) {
+        level = 2;
+    } else {
+        level = 3;
+        if (delta >= MAX_SPAN) {
+            // 超出覆盖范围，先放到最远的槽，下沉时再重新计算
+            position = current_tick_ + MAX_SPAN - 1;
+        }
+    }
+
+    uint32_t slot = static_cast<uint32_t>(position >> level_shift(level)) & (level_slots(level) - 1);
+    uint32_t global = level_base(level) + slot;
+
+    node.slot = global;
+    node.prev = NIL;
+    node.next = heads_[global];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[global] = index;
+
+    if (level == 0) {
+        occupied_[slot >> 6] |= 1ull << (slot & 63);
+    } else {
+        occupied_[LEVEL0_SLOTS / 64 + level - 1] |= 1ull << slot;
+    }
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    TimerNode& node = nodes_[index];
+    uint32_t global = node.slot;
+
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[global] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+    node.slot = NIL;
+
+    if (heads_[global] == NIL) {
+        // 槽变空，清除位图中的对应位
+        if (global < LEVEL0_SLOTS) {
+            occupied_[global >> 6] &= ~(1ull << (global & 63));
+        } else {
+            uint32_t level = (global - LEVEL0_SLOTS) / LEVELN_SLOTS + 1;
+            uint32_t slot = (global - LEVEL0_SLOTS) % LEVELN_SLOTS;
+            occupied_[LEVEL0_SLOTS / 64 + level - 1] &= ~(1ull << slot);
+        }
+    }
+}
+
+TimerWheel::TimerId TimerWheel::add(uint64_t expire_tick, uint64_t interval_ticks, Callback callback) {
+    uint32_t index = alloc_node();
+    TimerNode& node = nodes_[index];
+
+    // 已经过期的定时器在下一个tick触发
+    node.expire = expire_tick > current_tick_ ? expire_tick : current_tick_ + 1;
+    node.interval = interval_ticks;
+    node.callback = std::move(callback);
+    node.active = true;
+
+    link(index);
+    active_count_++;
+
+    return (static_cast<uint64_t>(node.generation) << 32) | (static_cast<uint64_t>(index) + 1);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint64_t low = id & 0xFFFFFFFFull;
+    if (low == 0 || low > nodes_.size()) {
+        return false;
+    }
+
+    uint32_t index = static_cast<uint32_t>(low - 1);
+    TimerNode& node = nodes_[index];
+    if (!node.active || node.generation != static_cast<uint32_t>(id >> 32)) {
+        // 已经触发、已经取消，或者节点已被复用
+        return false;
+    }
+
+    unlink(index);
+    free_node(index);
+    active_count_--;
+    return true;
+}
+
+int TimerWheel::find_occupied(int level, uint32_t start) const {
+    uint32_t slots = level_slots(level);
+    const uint64_t* words = level == 0 ? occupied_ : &occupied_[LEVEL0_SLOTS / 64 + level - 1];
+
+    // 槽数都是64的整数倍，逐字扫描，第一个字只看start之后的位
+    for (uint32_t offset = 0; offset < slots;) {
+        uint32_t position = (start + offset) & (slots - 1);
+        uint32_t bit = position & 63;
+        uint64_t bits = words[position >> 6] >> bit;
+        if (bits) {
+            return static_cast<int>(offset + __builtin_ctzll(bits));
+        }
+        offset += 64 - bit;
+    }
+    return -1;
+}
+
+bool TimerWheel::next_expiry(uint64_t& tick) const {
+    if (active_count_ == 0) {
+        return false;
+    }
+
+    uint64_t best = UINT64_MAX;
+
+    // level0：下一个非空槽就是到期时间
+    int offset = find_occupied(0, static_cast<uint32_t>(current_tick_ + 1) & (LEVEL0_SLOTS - 1));
+    if (offset >= 0) {
+        best = current_tick_ + 1 + static_cast<uint64_t>(offset);
+    }
+
+    // 高层：非空槽开始下沉的时刻
+    for (int level = 1; level < LEVEL_COUNT; ++level) {
+        int shift = level_shift(level);
+        uint64_t next_bucket = (current_tick_ >> shift) + 1;
+        offset = find_occupied(level, static_cast<uint32_t>(next_bucket) & (LEVELN_SLOTS - 1));
+        if (offset >= 0) {
+            uint64_t candidate = (next_bucket + static_cast<uint64_t>(offset)) << shift;
+            if (candidate < best) {
+                best = candidate;
+            }
+        }
+    }
+
+    tick = best;
+    return best != UINT64_MAX;
+}
+
+void TimerWheel::cascade(int level, uint32_t slot) {
+    uint32_t global = level_base(level) + slot;
+    uint32_t index = heads_[global];
+    if (index == NIL) {
+        return;
+    }
+
+    // 整个槽摘下后逐个按剩余时间重新插入
+    heads_[global] = NIL;
+    occupied_[LEVEL0_SLOTS / 64 + level - 1] &= ~(1ull << slot);
+
+    while (index != NIL) {
+        uint32_t next = nodes_[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+size_t TimerWheel::process_tick(uint64_t tick, std::vector<Callback>& expired) {
+    // 到达level0一圈的边界时，从level1开始逐层下沉
+    if ((tick & (LEVEL0_SLOTS - 1)) == 0) {
+        for (int level = 1; level < LEVEL_COUNT; ++level) {
+            uint32_t slot = static_cast<uint32_t>(tick >> level_shift(level)) & (LEVELN_SLOTS - 1);
+            cascade(level, slot);
+            if (slot != 0) {
+                break;
+            }
+        }
+    }
+
+    size_t fired = 0;
+    uint32_t global = static_cast<uint32_t>(tick) & (LEVEL0_SLOTS - 1);
+
+    while (heads_[global] != NIL) {
+        uint32_t index = heads_[global];
+        unlink(index);
+        TimerNode& node = nodes_[index];
+
+        if (node.expire > tick) {
+            // 理论上不会发生，保险起见重新插入
+            link(index);
+            continue;
+        }
+
+        if (node.interval > 0) {
+            // 周期定时器：拷贝回调后按固定节拍重新插入，避免误差累积
+            expired.push_back(node.callback);
+            node.expire = tick + node.interval;
+            link(index);
+        } else {
+            expired.push_back(std::move(node.callback));
+            free_node(index);
+            active_count_--;
+        }
+        fired++;
+    }
+
+    return fired;
+}
+
+size_t TimerWheel::advance(uint64_t now_tick, std::vector<Callback>& expired) {
+    size_t fired = 0;
+
+    while (current_tick_ < now_tick) {
+        uint64_t next;
+        if (!next_expiry(next) || next > now_tick) {
+            // 中间的槽都是空的，直接跳到now_tick
+            current_tick_ = now_tick;
+            break;
+        }
+        current_tick_ = next;
+        fired += process_tick(next, expired);
+    }
+
+    return fired;
+}
+
+} // namespace asyncio
@@ -0,0 +1,177 @@
+/**
+ * @file timer_wheel.hpp
+ * @brief 分层时间轮（Hierarchical Timing Wheel）
+ *
+ * 用于管理海量定时器（例如每个连接一个超时定时器），插入和取消都是O(1)。
+ *
+ * 层级划分（时间粒度为1个tick，EventLoop中1 tick = 1ms）：
+ * ┌────────┬────────┬──────────────┬──────────────────────┐
+ * │  层级  │ 槽位数 │  每个槽跨度   │       覆盖范围        │
+ * ├────────┼────────┼──────────────┼──────────────────────┤
+ * │ level0 │  256   │   1 tick     │ 256 ticks (256ms)    │
+ * │ level1 │   64   │  2^8 ticks   │ 2^14 ticks (~16s)    │
+ * │ level2 │   64   │  2^14 ticks  │ 2^20 ticks (~17min)  │
+ * │ level3 │   64   │  2^20 ticks  │ 2^26 ticks (~18.6h)  │
+ * └────────┴────────┴──────────────┴──────────────────────┘
+ *
+ * 定时器按照剩余时间放入对应层级的槽，高层槽到期时整体下沉（cascade）到低层，
+ * 最终由level0触发。超出覆盖范围的定时器先放在level3最远的槽，下沉时重新计算。
+ *
+ * 节点统一存放在数组中，通过下标组成双向链表，定时器ID = (generation << 32) | (下标 + 1)，
+ * 取消时通过下标直接定位节点并用generation校验，避免ABA问题。
+ *
+ * 注意：TimerWheel本身不是线程安全的，由使用者（EventLoop）负责加锁。
+ */
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace asyncio {
+
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    static constexpr TimerId INVALID_TIMER = 0;
+
+    /**
+     * @brief 构造函数
+     * @param start_tick 时间轮的起始tick
+     */
+    explicit TimerWheel(uint64_t start_tick = 0);
+
+    // 节点之间用下标互相引用，禁止拷贝
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief 添加定时器
+     * @param expire_tick 到期的tick，小于等于当前tick时在下一个tick触发
+     * @param interval_ticks 重复间隔，0表示只触发一次
+     * @param callback 到期回调
+     * @return 定时器ID，用于取消
+     */
+    TimerId add(uint64_t expire_tick, uint64_t interval_ticks, Callback callback);
+
+    /**
+     * @brief 取消定时器，O(1)
+     * @param id 定时器ID
+     * @return 定时器存在且未触发时返回true
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * @brief 推进时间轮到now_tick，收集到期的回调
+     * @param now_tick 当前tick
+     * @param expired 输出参数，到期的回调按到期顺序追加到末尾
+     * @return 到期的定时器数量
+     *
+     * 回调不在这里执行，调用者可以先释放锁再执行，回调中可以安全地添加/取消定时器。
+     * 周期定时器会自动以expire + interval重新插入，ID保持不变。
+     */
+    size_t advance(uint64_t now_tick, std::vector<Callback>& expired);
+
+    /**
+     * @brief 获取下一个需要处理的tick
+     * @param tick 输出参数
+     * @return 没有定时器时返回false
+     *
+     * 返回值可能早于真实的最早到期时间（高层槽需要下沉的时刻），
+     * 但不会晚于它，所以按这个时间唤醒不会错过定时器。
+     */
+    bool next_expiry(uint64_t& tick) const;
+
+    /**
+     * @brief 当前活跃的定时器数量
+     */
+    size_t size() const { return active_count_; }
+
+    /**
+     * @brief 当前tick
+     */
+    uint64_t current_tick() const { return current_tick_; }
+
+private:
+    static constexpr int LEVEL_COUNT = 4;
+    static constexpr int LEVEL0_BITS = 8;
+    static constexpr int LEVELN_BITS = 6;
+    static constexpr uint32_t LEVEL0_SLOTS = 1u << LEVEL0_BITS;   // 256
+    static constexpr uint32_t LEVELN_SLOTS = 1u << LEVELN_BITS;   // 64
+    static constexpr uint32_t TOTAL_SLOTS = LEVEL0_SLOTS + LEVELN_SLOTS * (LEVEL_COUNT - 1);
+    static constexpr uint64_t MAX_SPAN = 1ull << (LEVEL0_BITS + LEVELN_BITS * (LEVEL_COUNT - 1));
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct TimerNode {
+        uint64_t expire = 0;        // 到期tick
+        uint64_t interval = 0;      // 重复间隔
+        Callback callback;          // 到期回调
+        uint32_t prev = NIL;        // 槽内链表前驱
+        uint32_t next = NIL;        // 槽内链表后继（空闲时作为空闲链表指针）
+        uint32_t slot = NIL;        // 所在槽的全局下标
+        uint32_t generation = 1;    // 节点复用代数
+        bool active = false;        // 是否在时间轮中
+    };
+
+    /**
+     * @brief 层级level的槽在heads_中的起始下标
+     */
+    static uint32_t level_base(int level) {
+        return level == 0 ? 0 : LEVEL0_SLOTS + LEVELN_SLOTS * (level - 1);
+    }
+
+    /**
+     * @brief 层级level的槽下标在tick中的起始位
+     */
+    static int level_shift(int level) {
+        return level == 0 ? 0 : LEVEL0_BITS + LEVELN_BITS * (level - 1);
+    }
+
+    static uint32_t level_slots(int level) {
+        return level == 0 ? LEVEL0_SLOTS : LEVELN_SLOTS;
+    }
+
+    uint32_t alloc_node();
+    void free_node(uint32_t index);
+
+    /**
+     * @brief 根据到期时间把节点挂到对应层级的槽
+     */
+    void link(uint32_t index);
+
+    /**
+     * @brief 把节点从所在槽摘下
+     */
+    void unlink(uint32_t index);
+
+    /**
+     * @brief 把level层的slot槽下沉到低层
+     */
+    void cascade(int level, uint32_t slot);
+
+    /**
+     * @brief 在level层的位图中，从start开始循环查找第一个非空槽
+     * @return 相对start的偏移，没有非空槽时返回-1
+     */
+    int find_occupied(int level, uint32_t start) const;
+
+    /**
+     * @brief 处理一个tick：必要时下沉高层槽，并收集level0当前槽中到期的定时器
+     */
+    size_t process_tick(uint64_t tick, std::vector<Callback>& expired);
+
+    std::vector<TimerNode> nodes_;       // 节点数组
+    uint32_t free_head_;                 // 空闲节点链表
+    uint32_t heads_[TOTAL_SLOTS];        // 每个槽的链表头
+    uint64_t occupied_[LEVEL0_SLOTS / 64 + LEVEL_COUNT - 1];  // 非空槽位图：level0占4个字，其他层各1个字
+    uint64_t current_tick_;              // 已处理到的tick
+    size_t active_count_;                // 活跃定时器数量
+};
+
+} // namespace asyncio
+
+#endif // TIMER_WHEEL_HPP
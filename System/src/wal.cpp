@@ -0,0 +1,657 @@
+/**
+ * @file wal.cpp
+ * @brief 组提交预写日志的实现
+ *
+ * 实现要点：
+ * 1. 帧编码和CRC在append()的调用线程中完成，提交线程只负责IO
+ * 2. 每批记录的writev和fdatasync用IOSQE_IO_LINK链接，一次提交、一次等待
+ * 3. 短写时链上后续的请求被取消，从已写入的位置重新提交剩余部分和同步
+ * 4. 段切换很少发生，创建、预分配写0和目录同步直接用同步系统调用
+ */
+
+#include "wal.hpp"
+#include "io_uring_wrapper.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace asyncio {
+
+namespace {
+
+constexpr size_t MAX_IOVECS = 1024;             // 单次writev的iovec数量（Linux的IOV_MAX）
+constexpr size_t SEGMENT_NAME_DIGITS = 20;      // 段文件名中LSN的位数
+constexpr const char* SEGMENT_SUFFIX = ".wal";
+constexpr size_t ZERO_FILL_CHUNK = 1024 * 1024;  // 段文件写0时单次pwrite的大小
+
+#if !defined(__SSE4_2__)
+/**
+ * @brief CRC32C查找表（反射多项式0x82F63B78）
+ */
+struct Crc32cTable {
+    uint32_t entries[256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+const Crc32cTable& crc32c_table() {
+    static const Crc32cTable table;
+    return table;
+}
+#endif
+
+std::string segment_name(WriteAheadLog::Lsn first_lsn) {
+    char name[32];
+    snprintf(name, sizeof(name), "%020" PRIu64 "%s", first_lsn, SEGMENT_SUFFIX);
+    return name;
+}
+
+/**
+ * @brief 从文件开头写入size字节的0，失败时返回false并保留errno
+ */
+bool zero_fill(int fd, size_t size) {
+    static const std::vector<char> zeros(ZERO_FILL_CHUNK, 0);
+    size_t offset = 0;
+    while (offset < size) {
+        size_t length = std::min(ZERO_FILL_CHUNK, size - offset);
+        ssize_t n = ::pwrite(fd, zeros.data(), length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+
+#if defined(__SSE4_2__)
+    // crc32指令每次处理8字节
+    while (length >= sizeof(uint64_t)) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        crc = static_cast<uint32_t>(_mm_crc32_u64(crc, value));
+        p += sizeof(value);
+        length -= sizeof(value);
+    }
+    while (length > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --length;
+    }
+#else
+    const uint32_t* table = crc32c_table().entries;
+    while (length > 0) {
+        crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        --length;
+    }
+#endif
+
+    return ~crc;
+}
+
+WriteAheadLog::WriteAheadLog(WalConfig config)
+    : config_(std::move(config))
+    , dir_fd_(-1)
+    , fd_(-1)
+    , segment_offset_(0)
+    , pending_bytes_(0)
+    , next_lsn_(1)
+    , running_(false)
+    , stopping_(false)
+    , failed_(false)
+    , durable_lsn_(0)
+    , stat_records_(0)
+    , stat_bytes_(0)
+    , stat_commits_(0)
+    , stat_segments_(0)
+    , stat_max_batch_(0)
+{
+    if (config_.directory.empty()) {
+        throw std::runtime_error("预写日志目录不能为空");
+    }
+    // 一次提交至少要容纳 writev + fdatasync
+    config_.queue_depth = std::max(config_.queue_depth, 2u);
+
+    if (::mkdir(config_.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("创建预写日志目录失败: " + config_.directory + ": " + std::string(strerror(errno)));
+    }
+    dir_fd_ = ::open(config_.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd_ < 0) {
+        throw std::runtime_error("打开预写日志目录失败: " + config_.directory + ": " + std::string(strerror(errno)));
+    }
+
+    try {
+        // 下一个LSN接在最后一个段的有效记录之后；最后一个段为空时就是它的起始LSN，新段会覆盖它
+        segments_ = list_segments(config_.directory);
+        if (!segments_.empty()) {
+            const Segment& last = segments_.back();
+            next_lsn_ = last.first_lsn + scan_segment(last, nullptr);
+            durable_lsn_.store(next_lsn_ - 1);
+        }
+
+        ring_ = std::make_unique<IoUring>(config_.queue_depth);
+        open_segment(next_lsn_);
+    } catch (...) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        ::close(dir_fd_);
+        throw;
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    stop();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (dir_fd_ >= 0) {
+        ::close(dir_fd_);
+    }
+}
+
+void WriteAheadLog::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ || stopping_) {
+        return;
+    }
+    running_ = true;
+    committer_thread_ = std::thread(&WriteAheadLog::run, this);
+}
+
+void WriteAheadLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    space_cv_.notify_all();
+
+    if (committer_thread_.joinable()) {
+        committer_thread_.join();
+    }
+}
+
+std::future<WriteAheadLog::Lsn> WriteAheadLog::append(std::string_view data) {
+    if (data.size() > UINT32_MAX) {
+        throw std::length_error("预写日志记录超过4GB");
+    }
+
+    // 在调用线程中完成编码和CRC，多个线程的CRC计算可以并行
+    PendingRecord record;
+    uint32_t length = static_cast<uint32_t>(data.size());
+    uint32_t crc = crc32c(&length, sizeof(length));
+    crc = crc32c(data.data(), data.size(), crc);
+
+    record.frame.resize(FRAME_HEADER_SIZE + data.size());
+    char* out = record.frame.data();
+    std::memcpy(out, &length, sizeof(length));
+    std::memcpy(out + sizeof(length), &crc, sizeof(crc));
+    if (!data.empty()) {
+        std::memcpy(out + FRAME_HEADER_SIZE, data.data(), data.size());
+    }
+
+    std::future<Lsn> future = record.promise.get_future();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this] {
+            return pending_bytes_ < config_.max_pending_bytes || stopping_ || failed_;
+        });
+
+        if (failed_ || stopping_) {
+            std::string reason = failed_ ? "预写日志写入失败: " + error_ : std::string("预写日志已停止");
+            record.promise.set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+            return future;
+        }
+
+        // LSN在锁内分配，队列顺序就是LSN顺序
+        record.lsn = next_lsn_++;
+        pending_bytes_ += record.frame.size();
+        pending_.push_back(std::move(record));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+WriteAheadLog::Lsn WriteAheadLog::next_lsn() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_lsn_;
+}
+
+size_t WriteAheadLog::truncate_before(Lsn lsn) {
+    std::vector<std::string> victims;
+    {
+        // 段i的记录都小于段i+1的起始LSN；最后一个段是当前段，总是保留
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        size_t count = 0;
+        while (count + 1 < segments_.size() && segments_[count + 1].first_lsn <= lsn) {
+            victims.push_back(segments_[count].path);
+            ++count;
+        }
+        segments_.erase(segments_.begin(), segments_.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+
+    size_t removed = 0;
+    for (const auto& path : victims) {
+        if (::unlink(path.c_str()) == 0) {
+            ++removed;
+        } else {
+            std::cerr << "[WriteAheadLog] 删除段文件失败: " << path << ": " << strerror(errno) << std::endl;
+        }
+    }
+    return removed;
+}
+
+WalStats WriteAheadLog::stats() const {
+    WalStats stats;
+    stats.records = stat_records_.load(std::memory_order_relaxed);
+    stats.bytes = stat_bytes_.load(std::memory_order_relaxed);
+    stats.commits = stat_commits_.load(std::memory_order_relaxed);
+    stats.segments = stat_segments_.load(std::memory_order_relaxed);
+    stats.max_batch = stat_max_batch_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void WriteAheadLog::run() {
+    std::vector<PendingRecord> batch;
+
+    while (true) {
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !pending_.empty() || stopping_; });
+
+            // 停止时提交完已入队的记录再退出
+            if (pending_.empty()) {
+                break;
+            }
+
+            // 可选的提交延迟：用一点延迟换更大的批次
+            if (config_.commit_delay.count() > 0 && !stopping_ && pending_bytes_ < config_.max_batch_bytes) {
+                cv_.wait_for(lock, config_.commit_delay, [this] {
+                    return pending_bytes_ >= config_.max_batch_bytes || stopping_;
+                });
+            }
+
+            // 取走队列中的记录，至少一条，超大记录单独成批
+            size_t bytes = 0;
+            while (!pending_.empty() &&
+                   (batch.empty() || bytes + pending_.front().frame.size() <= config_.max_batch_bytes)) {
+                bytes += pending_.front().frame.size();
+                batch.push_back(std::move(pending_.front()));
+                pending_.pop_front();
+            }
+            pending_bytes_ -= bytes;
+            failed = failed_;
+        }
+        space_cv_.notify_all();
+
+        if (failed) {
+            fail_records(batch, 0);
+        } else {
+            commit(batch);
+        }
+        batch.clear();
+    }
+}
+
+void WriteAheadLog::commit(std::vector<PendingRecord>& batch) {
+    size_t begin = 0;
+
+    while (begin < batch.size()) {
+        int result = 0;
+        std::string message;
+        size_t end = begin;
+        size_t total = 0;
+
+        try {
+            // 当前段放不下下一条记录时切换到新段；空段总是接受，超过段大小的记录单独占一个段
+            if (segment_offset_ > 0 && segment_offset_ + batch[begin].frame.size() > config_.segment_size) {
+                open_segment(batch[begin].lsn);
+            }
+
+            iovecs_.clear();
+            while (end < batch.size()) {
+                size_t size = batch[end].frame.size();
+                if (end > begin && segment_offset_ + total + size > config_.segment_size) {
+                    break;
+                }
+                struct iovec iov;
+                iov.iov_base = batch[end].frame.data();
+                iov.iov_len = size;
+                iovecs_.push_back(iov);
+                total += size;
+                ++end;
+            }
+
+            result = write_and_sync();
+            if (result < 0) {
+                message = strerror(-result);
+            }
+        } catch (const std::exception& e) {
+            result = -EIO;
+            message = e.what();
+        }
+
+        if (result < 0) {
+            std::cerr << "[WriteAheadLog] 写入失败，停止接受新记录: " << message << std::endl;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                failed_ = true;
+                error_ = message;
+            }
+            space_cv_.notify_all();
+            fail_records(batch, begin);
+            return;
+        }
+
+        segment_offset_ += total;
+        uint64_t count = end - begin;
+        stat_records_.fetch_add(count, std::memory_order_relaxed);
+        stat_bytes_.fetch_add(total, std::memory_order_relaxed);
+        stat_commits_.fetch_add(1, std::memory_order_relaxed);
+        if (count > stat_max_batch_.load(std::memory_order_relaxed)) {
+            stat_max_batch_.store(count, std::memory_order_relaxed);
+        }
+        durable_lsn_.store(batch[end - 1].lsn, std::memory_order_release);
+
+        for (size_t i = begin; i < end; ++i) {
+            batch[i].promise.set_value(batch[i].lsn);
+        }
+        begin = end;
+    }
+}
+
+int WriteAheadLog::write_and_sync() {
+    std::vector<IoContext> chain;
+    std::vector<size_t> expected;
+    std::vector<int> results;
+    size_t written = 0;
+
+    while (true) {
+        // 从已写入的位置开始组织iovec，第一次提交时就是全部的帧
+        chain_iovecs_.clear();
+        size_t skip = written;
+        for (const auto& iov : iovecs_) {
+            if (skip >= iov.iov_len) {
+                skip -= iov.iov_len;
+                continue;
+            }
+            struct iovec rest;
+            rest.iov_base = static_cast<char*>(iov.iov_base) + skip;
+            rest.iov_len = iov.iov_len - skip;
+            chain_iovecs_.push_back(rest);
+            skip = 0;
+        }
+
+        // writev按MAX_IOVECS切分，链上留一个位置给fdatasync
+        chain.clear();
+        expected.clear();
+        size_t index = 0;
+        uint64_t offset = segment_offset_ + written;
+        while (index < chain_iovecs_.size() && chain.size() + 1 < config_.queue_depth) {
+            size_t count = std::min(MAX_IOVECS, chain_iovecs_.size() - index);
+            size_t bytes = 0;
+            for (size_t i = index; i < index + count; ++i) {
+                bytes += chain_iovecs_[i].iov_len;
+            }
+
+            IoContext ctx;
+            ctx.op_type = IoOpType::WRITEV;
+            ctx.fd = fd_;
+            ctx.buffer = &chain_iovecs_[index];
+            ctx.length = count;
+            ctx.offset = static_cast<off_t>(offset);
+            chain.push_back(std::move(ctx));
+            expected.push_back(bytes);
+
+            offset += bytes;
+            index += count;
+        }
+
+        // 剩余的数据都在这条链上时，链接fdatasync：写完立即同步，写失败或短写时同步被取消
+        bool with_sync = index == chain_iovecs_.size();
+        if (with_sync) {
+            IoContext ctx;
+            ctx.op_type = IoOpType::FDATASYNC;
+            ctx.fd = fd_;
+            chain.push_back(std::move(ctx));
+        }
+
+        submit_and_wait(chain, results);
+
+        bool interrupted = false;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            int result = results[i];
+            if (result == -ECANCELED || result == -EINTR || result == -EAGAIN) {
+                interrupted = true;
+                break;
+            }
+            if (result < 0) {
+                return result;
+            }
+            if (result == 0) {
+                return -EIO;
+            }
+            written += static_cast<size_t>(result);
+            if (static_cast<size_t>(result) < expected[i]) {
+                interrupted = true;
+                break;
+            }
+        }
+
+        // fdatasync失败不重试：内核可能已经把写失败的脏页标记为干净，重试会误报成功
+        if (with_sync && !interrupted) {
+            return results.back();
+        }
+    }
+}
+
+void WriteAheadLog::submit_and_wait(std::vector<IoContext>& chain, std::vector<int>& results) {
+    results.assign(chain.size(), 0);
+    size_t completed = 0;
+
+    for (size_t i = 0; i < chain.size(); ++i) {
+        chain[i].callback = [&results, &completed, i](const IoResult& r) {
+            results[i] = r.result;
+            ++completed;
+        };
+    }
+
+    ring_->submit_linked(chain);
+    while (completed < chain.size()) {
+        ring_->wait_and_process(1, -1);
+    }
+}
+
+void WriteAheadLog::open_segment(Lsn first_lsn) {
+    std::string path = config_.directory + "/" + segment_name(first_lsn);
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("创建段文件失败: " + path + ": " + std::string(strerror(errno)));
+    }
+
+    // 预分配只保留块：ext4/xfs上fallocate得到的是未写入（unwritten）区段，第一次写入时要把区段
+    // 转换为已写入，这是元数据修改，每次fdatasync都要一起同步。所以再整段写一遍0，
+    // 之后的fdatasync只需要刷数据块（文件大小也不再变化）
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(config_.segment_size));
+    if (err != 0) {
+        std::cerr << "[WriteAheadLog] 预分配段文件失败，改为直接写0扩展: " << strerror(err) << std::endl;
+    }
+    if (!zero_fill(fd, config_.segment_size)) {
+        int saved = errno;
+        ::close(fd);
+        throw std::runtime_error("段文件写0失败: " + path + ": " + std::string(strerror(saved)));
+    }
+
+    // 写0的数据、文件大小和目录项都要持久化，否则崩溃后整个段可能不存在
+    if (::fsync(fd) != 0 || ::fsync(dir_fd_) != 0) {
+        int saved = errno;
+        ::close(fd);
+        throw std::runtime_error("同步段文件失败: " + path + ": " + std::string(strerror(saved)));
+    }
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = fd;
+    segment_offset_ = 0;
+    stat_segments_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    if (!segments_.empty() && segments_.back().first_lsn == first_lsn) {
+        // 覆盖了上次留下的空段
+        segments_.back().path = path;
+    } else {
+        segments_.push_back(Segment{first_lsn, path});
+    }
+}
+
+void WriteAheadLog::fail_records(std::vector<PendingRecord>& records, size_t begin) {
+    std::string reason;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reason = "预写日志写入失败: " + error_;
+    }
+    for (size_t i = begin; i < records.size(); ++i) {
+        records[i].promise.set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+    }
+}
+
+std::vector<WriteAheadLog::Segment> WriteAheadLog::list_segments(const std::string& directory) {
+    std::vector<Segment> segments;
+
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        if (errno == ENOENT) {
+            return segments;
+        }
+        throw std::runtime_error("读取预写日志目录失败: " + directory + ": " + std::string(strerror(errno)));
+    }
+
+    const size_t suffix_length = strlen(SEGMENT_SUFFIX);
+    while (struct dirent* entry = ::readdir(dir)) {
+        std::string_view name(entry->d_name);
+        if (name.size() != SEGMENT_NAME_DIGITS + suffix_length ||
+            name.substr(SEGMENT_NAME_DIGITS) != SEGMENT_SUFFIX ||
+            !std::all_of(name.begin(), name.begin() + SEGMENT_NAME_DIGITS,
+                         [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        Lsn first_lsn = std::strtoull(std::string(name.substr(0, SEGMENT_NAME_DIGITS)).c_str(), nullptr, 10);
+        segments.push_back(Segment{first_lsn, directory + "/" + std::string(name)});
+    }
+    ::closedir(dir);
+
+    std::sort(segments.begin(), segments.end(),
+              [](const Segment& a, const Segment& b) { return a.first_lsn < b.first_lsn; });
+    return segments;
+}
+
+uint64_t WriteAheadLog::scan_segment(const Segment& segment, const RecordVisitor& visitor) {
+    int fd = ::open(segment.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("打开段文件失败: " + segment.path + ": " + std::string(strerror(errno)));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        ::close(fd);
+        throw std::runtime_error("读取段文件失败: " + segment.path + ": " + std::string(strerror(saved)));
+    }
+
+    // 段的大小有上限，整段读入内存再解析
+    std::string content(static_cast<size_t>(st.st_size), '\0');
+    size_t loaded = 0;
+    while (loaded < content.size()) {
+        ssize_t n = ::pread(fd, content.data() + loaded, content.size() - loaded, static_cast<off_t>(loaded));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        loaded += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    content.resize(loaded);
+
+    uint64_t count = 0;
+    size_t pos = 0;
+    while (pos + FRAME_HEADER_SIZE <= content.size()) {
+        uint32_t length;
+        uint32_t crc;
+        std::memcpy(&length, content.data() + pos, sizeof(length));
+        std::memcpy(&crc, content.data() + pos + sizeof(length), sizeof(crc));
+
+        // 预分配的空白区域
+        if (length == 0 && crc == 0) {
+            break;
+        }
+        // 帧没有写完
+        if (length > content.size() - pos - FRAME_HEADER_SIZE) {
+            break;
+        }
+        const char* data = content.data() + pos + FRAME_HEADER_SIZE;
+        uint32_t actual = crc32c(&length, sizeof(length));
+        actual = crc32c(data, length, actual);
+        if (actual != crc) {
+            break;
+        }
+
+        if (visitor) {
+            visitor(segment.first_lsn + count, std::string_view(data, length));
+        }
+        ++count;
+        pos += FRAME_HEADER_SIZE + length;
+    }
+    return count;
+}
+
+WriteAheadLog::Lsn WriteAheadLog::recover(const std::string& directory, const RecordVisitor& visitor) {
+    Lsn last = 0;
+    for (const auto& segment : list_segments(directory)) {
+        uint64_t count = scan_segment(segment, visitor);
+        if (count > 0) {
+            last = segment.first_lsn + count - 1;
+        }
+    }
+    return last;
+}
+
+} // namespace asyncio
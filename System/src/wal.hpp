@@ -0,0 +1,287 @@
+/**
+ * @file wal.hpp
+ * @brief 基于io_uring的组提交预写日志（Write-Ahead Log）
+ *
+ * 每条记录单独 write + fdatasync 时，吞吐量受限于设备的同步延迟：
+ * 一次fdatasync在SSD上需要几十到几百微秒，在机械盘上需要几毫秒，每秒只能持久化几百到几千条记录。
+ * 组提交（group commit）让并发写入的记录共享同一次同步：
+ *
+ * ┌──────────┐ append  ┌────────────┐        ┌─────────────────────────────────┐
+ * │ 业务线程1 │───────>│            │  批量  │ 提交线程：                       │
+ * └──────────┘ future  │ 待提交队列 │──────>│ writev ──(IOSQE_IO_LINK)──> fdatasync │
+ * ┌──────────┐         │            │        │ 一次io_uring_submit，完成后唤醒future │
+ * │ 业务线程N │───────>│            │        └─────────────────────────────────┘
+ * └──────────┘         └────────────┘
+ *
+ * 1. append()在调用线程中完成帧编码和CRC计算，入队后立即返回future
+ * 2. 提交线程每轮取走队列中的全部记录（不超过max_batch_bytes），
+ *    用一个writev写入、链接一个fdatasync，两者一次提交给内核
+ * 3. 同步完成后才设置这一批记录的future，future就绪即表示记录已经持久化
+ * 4. 同步期间到达的记录自然积累成下一批，并发越高每批越大，同步次数不随记录数增长
+ *
+ * 磁盘格式：
+ * - 日志由多个段文件组成，文件名是段内第一条记录的LSN（20位十进制，补零），扩展名.wal
+ * - 段文件创建时用fallocate预分配并整段写0（之后的fdatasync不再有区段转换的元数据），写满后切换到新段
+ * - 每条记录一个帧：[长度 u32][CRC32C u32][数据]，CRC覆盖长度字段和数据
+ * - 记录的LSN不写入文件，由段的起始LSN加上段内序号得到
+ * - 预分配区域全是0，长度和CRC都为0的帧表示段结束
+ *
+ * 使用示例：
+ * @code
+ * WalConfig config;
+ * config.directory = "/var/lib/app/wal";
+ *
+ * // 启动前先重放已有的记录
+ * WriteAheadLog::recover(config.directory, [](WriteAheadLog::Lsn lsn, std::string_view data) {
+ *     apply(lsn, data);
+ * });
+ *
+ * WriteAheadLog wal(config);
+ * wal.start();
+ * std::future<WriteAheadLog::Lsn> done = wal.append(record);
+ * done.get();   // 返回时记录已经持久化
+ * @endcode
+ *
+ * 注意：帧头按主机字节序写入，日志文件不能在大小端不同的机器之间直接复制。
+ */
+
+#ifndef WAL_HPP
+#define WAL_HPP
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace asyncio {
+
+class IoUring;
+struct IoContext;
+
+/**
+ * @brief 计算CRC32C（Castagnoli多项式）
+ * @param data 数据
+ * @param length 数据长度
+ * @param crc 之前数据的CRC，用于分段计算
+ * @return CRC值
+ *
+ * 编译时启用SSE4.2（-msse4.2）时使用crc32指令，否则查表计算
+ */
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief 预写日志配置
+ */
+struct WalConfig {
+    std::string directory;                                  // 段文件所在目录，不存在时创建
+    size_t segment_size = 64 * 1024 * 1024;                 // 段文件大小，创建时预分配并写0
+    size_t max_batch_bytes = 4 * 1024 * 1024;               // 单次组提交最多合并的字节数
+    size_t max_pending_bytes = 64 * 1024 * 1024;            // 待提交字节数上限，超过时append阻塞
+    std::chrono::microseconds commit_delay{0};              // 批次未满时等待更多记录的时间，0表示不等待
+    unsigned int queue_depth = 64;                          // 提交线程io_uring队列深度
+};
+
+/**
+ * @brief 预写日志统计
+ */
+struct WalStats {
+    uint64_t records = 0;           // 已持久化的记录数
+    uint64_t bytes = 0;             // 已写入的字节数（包含帧头）
+    uint64_t commits = 0;           // 组提交次数（每次一个fdatasync）
+    uint64_t segments = 0;          // 创建的段文件数
+    uint64_t max_batch = 0;         // 单次组提交的最多记录数
+
+    /**
+     * @brief 平均每次组提交持久化的记录数
+     */
+    double records_per_commit() const {
+        return commits == 0 ? 0.0 : static_cast<double>(records) / static_cast<double>(commits);
+    }
+};
+
+/**
+ * @brief 组提交预写日志
+ *
+ * 线程模型：append()可以在任意线程调用；写入和同步只在后台提交线程中进行，
+ * 提交线程独占一个IoUring实例。
+ *
+ * 错误处理：写入或fdatasync失败后，无法确定哪些数据已经落盘（fsync失败后内核可能已经丢弃了脏页），
+ * 日志进入失败状态，这一批和之后的所有append都以异常结束，需要重新打开日志并恢复。
+ */
+class WriteAheadLog {
+public:
+    using Lsn = uint64_t;
+    using RecordVisitor = std::function<void(Lsn lsn, std::string_view data)>;
+
+    static constexpr size_t FRAME_HEADER_SIZE = 8;          // 长度 + CRC
+
+    /**
+     * @brief 打开日志目录
+     * @param config 配置
+     *
+     * 扫描已有段文件确定下一个LSN，然后创建一个新段继续写入。
+     * 不在旧段的末尾追加：旧段的尾部可能有崩溃时写了一半的帧。
+     * 失败时抛出std::runtime_error。
+     */
+    explicit WriteAheadLog(WalConfig config);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief 启动提交线程
+     */
+    void start();
+
+    /**
+     * @brief 提交完已入队的记录后停止提交线程
+     */
+    void stop();
+
+    /**
+     * @brief 追加一条记录
+     * @param data 记录数据，调用返回后即可释放
+     * @return 记录持久化后就绪的future，值为记录的LSN；写入失败或日志已停止时为异常
+     *
+     * 待提交的数据超过max_pending_bytes时阻塞，直到提交线程追上
+     */
+    std::future<Lsn> append(std::string_view data);
+
+    /**
+     * @brief 下一条记录将被分配的LSN
+     */
+    Lsn next_lsn() const;
+
+    /**
+     * @brief 已经持久化的最大LSN，没有时为0
+     */
+    Lsn durable_lsn() const { return durable_lsn_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 删除只包含小于lsn的记录的段文件
+     * @param lsn 检查点之后需要保留的第一个LSN
+     * @return 删除的段文件数量
+     *
+     * 当前正在写入的段不会被删除
+     */
+    size_t truncate_before(Lsn lsn);
+
+    /**
+     * @brief 获取统计信息
+     */
+    WalStats stats() const;
+
+    /**
+     * @brief 按LSN顺序读取目录中所有完整的记录
+     * @param directory 日志目录
+     * @param visitor 每条记录的回调，data只在回调期间有效
+     * @return 读到的最后一个LSN，没有记录时为0
+     *
+     * 每个段读到第一个损坏的帧（长度越界或CRC不匹配）为止，之后的内容视为崩溃时没有写完的尾部。
+     * 只有同步成功的记录才会被确认，所以被丢弃的尾部一定没有被确认过。
+     */
+    static Lsn recover(const std::string& directory, const RecordVisitor& visitor);
+
+private:
+    struct PendingRecord {
+        Lsn lsn;
+        std::string frame;          // 帧头 + 数据
+        std::promise<Lsn> promise;
+    };
+
+    struct Segment {
+        Lsn first_lsn;
+        std::string path;
+    };
+
+    /**
+     * @brief 提交线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 持久化一批记录（按段切分，每段一次写入+同步）
+     */
+    void commit(std::vector<PendingRecord>& batch);
+
+    /**
+     * @brief 把iovecs_中的帧写到当前段末尾并同步
+     * @return 0表示成功，否则为负的错误码
+     */
+    int write_and_sync();
+
+    /**
+     * @brief 提交一组链接请求并等待全部完成
+     */
+    void submit_and_wait(std::vector<IoContext>& chain, std::vector<int>& results);
+
+    /**
+     * @brief 关闭当前段，创建以first_lsn开头的新段
+     */
+    void open_segment(Lsn first_lsn);
+
+    /**
+     * @brief 让失败状态下的记录以异常结束
+     */
+    void fail_records(std::vector<PendingRecord>& records, size_t begin);
+
+    /**
+     * @brief 列出目录中的段文件，按起始LSN排序
+     */
+    static std::vector<Segment> list_segments(const std::string& directory);
+
+    /**
+     * @brief 读取一个段中完整的记录
+     * @return 段中有效记录的数量
+     */
+    static uint64_t scan_segment(const Segment& segment, const RecordVisitor& visitor);
+
+    WalConfig config_;
+    int dir_fd_;                                    // 目录，创建段文件后fsync目录
+    int fd_;                                        // 当前段
+    uint64_t segment_offset_;                       // 当前段的写入位置
+    std::unique_ptr<IoUring> ring_;                 // 提交线程独占
+    std::vector<struct iovec> iovecs_;              // 当前批次的帧
+    std::vector<struct iovec> chain_iovecs_;        // 本次提交的iovec（短写后跳过已写入的部分）
+
+    // 待提交队列
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;                    // 有新记录或者停止
+    std::condition_variable space_cv_;              // 待提交字节数下降
+    std::deque<PendingRecord> pending_;
+    size_t pending_bytes_;
+    Lsn next_lsn_;
+    bool running_;
+    bool stopping_;
+    bool failed_;
+    std::string error_;
+    std::thread committer_thread_;
+
+    // 段文件列表（提交线程创建，truncate_before删除）
+    mutable std::mutex segments_mutex_;
+    std::vector<Segment> segments_;
+
+    // 统计
+    std::atomic<Lsn> durable_lsn_;
+    std::atomic<uint64_t> stat_records_;
+    std::atomic<uint64_t> stat_bytes_;
+    std::atomic<uint64_t> stat_commits_;
+    std::atomic<uint64_t> stat_segments_;
+    std::atomic<uint64_t> stat_max_batch_;
+};
+
+} // namespace asyncio
+
+#endif // WAL_HPP